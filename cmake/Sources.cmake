@@ -1,8 +1,11 @@
 set(H_SOURCES_ROOT ${CMAKE_CURRENT_SOURCE_DIR}/sources)
 set(H_TARGETS
-        stardraw stardraw-demo glad
+        stardraw stardraw-demo stardraw-reflect glad
 )
 
+include(cmake/StardrawReflect.cmake)
+
 add_subdirectory(sources/glad)
 add_subdirectory(sources/stardraw)
+add_subdirectory(sources/stardraw-reflect)
 add_subdirectory(sources/stardraw-demo)
\ No newline at end of file
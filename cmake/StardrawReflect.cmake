@@ -0,0 +1,21 @@
+#Generates <shader name>_layout.hpp from a slang module at build time, containing C++ structs that mirror the module's buffer layouts.
+#The header is added to the target's include path.
+function(stardraw_generate_shader_header target shader_path namespace)
+    get_filename_component(shader_abs_path ${shader_path} ABSOLUTE)
+    get_filename_component(shader_name ${shader_path} NAME_WE)
+
+    set(output_dir ${CMAKE_CURRENT_BINARY_DIR}/stardraw_generated)
+    set(output_path ${output_dir}/${shader_name}_layout.hpp)
+
+    add_custom_command(
+            OUTPUT ${output_path}
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${output_dir}
+            COMMAND stardraw-reflect ${shader_abs_path} ${output_path} ${namespace}
+            DEPENDS stardraw-reflect ${shader_abs_path}
+            COMMENT "Generating shader layout header for ${shader_path}"
+            VERBATIM
+    )
+
+    target_sources(${target} PRIVATE ${output_path})
+    target_include_directories(${target} PRIVATE ${output_dir})
+endfunction()
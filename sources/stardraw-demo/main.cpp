@@ -2,11 +2,11 @@
 #include <filesystem>
 #include <fstream>
 
+#include "shader_layout.hpp"
 #include "stardraw/api/shaders.hpp"
 #include "stardraw/api/window.hpp"
 using namespace stardraw;
 
-shader_buffer_layout* uniforms_layout;
 shader_program* frag_shader;
 shader_program* vert_shader;
 
@@ -34,7 +34,6 @@ std::vector<shader_stage> load_shader()
 
     status vtx_load_status = stardraw::create_shader_program("main_linked", vert_entry_point, graphics_api::GL45, &vert_shader);
     status frg_load_status = stardraw::create_shader_program("main_linked", frag_entry_point, graphics_api::GL45, &frag_shader);
-    status layout_create = stardraw::create_shader_buffer_layout(frag_shader, "uniforms", &uniforms_layout);
 
     return {{shader_stage_type::VERTEX, vert_shader}, {shader_stage_type::FRAGMENT, frag_shader}};
 }
@@ -45,20 +44,14 @@ struct vertex
     f32 color[4];
 };
 
-struct uniform_block
-{
-    f32 tint[4];
-    f32 additive[3];
-};
-
 std::array triangle = {
     vertex {-1, -1, 0, 1, 0, 0, 1},
     vertex {1, -1, 0, 0, 1, 0, 1},
     vertex {0, 1, 0, 0, 0, 1, 1}
 };
 
-uniform_block uniforms = {
-    1, 1.0f, 1, 1.0f, 0.5, 0.5, 0.5
+demo_shaders::structured_element uniforms = {
+    {1, 1.0f, 1, 1.0f}, {0.5, 0.5, 0.5}
 };
 
 int main()
@@ -98,9 +91,6 @@ int main()
         }
     );
 
-    void* uniform_mem = layout_shader_buffer_memory(uniforms_layout, &uniforms, sizeof(uniform_block));
-    free(uniform_mem);
-
     std::array<u8, 36> texture_bytes = {
         255, 255, 255, 127,
         127, 127, 127, 255,
@@ -109,6 +99,7 @@ int main()
     };
 
     status transfer_status = ctx->transfer_buffer_memory_immediate({"vertices", 0, sizeof(vertex) * 3}, &triangle);
+    status uniforms_transfer_status = ctx->transfer_buffer_memory_immediate({"param-buffer", 0, sizeof(uniforms)}, &uniforms);
     status tex_transfer_status = ctx->transfer_texture_memory_immediate({"tex", 0, 0, 0, 2, 2}, texture_bytes.data());
 
     status init_status = ctx->execute_temp_command_buffer({
@@ -116,7 +107,7 @@ int main()
         shader_config_command(
             "shader",
             {
-                {frag_shader->locate("structured"), shader_parameter_value::buffer("param-buffer")},
+                {frag_shader->locate(demo_shaders::structured_parameter), shader_parameter_value::buffer("param-buffer")},
                 {frag_shader->locate("structured").index(1), shader_parameter_value::vector(1.0f, 0.0f, 1.0f, 1.0f)},
                 {frag_shader->locate("texture"), shader_parameter_value::image_read_write("tex")}
             }),
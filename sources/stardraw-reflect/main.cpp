@@ -0,0 +1,67 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "stardraw/api/shaders.hpp"
+using namespace stardraw;
+
+//Usage: stardraw-reflect <module.slang> <output header> <namespace>
+//Writes C++ mirrors of a module's buffer structs, see stardraw_generate_shader_header in cmake/StardrawReflect.cmake
+int main(const int argc, char** argv)
+{
+    if (argc != 4)
+    {
+        std::cerr << "Usage: stardraw-reflect <module.slang> <output header> <namespace>\n";
+        return 1;
+    }
+
+    const std::filesystem::path module_path = argv[1];
+    const std::filesystem::path output_path = argv[2];
+    const std::string module_name = module_path.stem().string();
+
+    std::ifstream module_file(module_path, std::ios::in);
+    if (!module_file)
+    {
+        std::cerr << std::format("Couldn't open shader module '{0}'\n", module_path.string());
+        return 1;
+    }
+
+    std::stringstream source;
+    source << module_file.rdbuf();
+
+    const status setup_status = setup_shader_compiler();
+    if (is_status_error(setup_status))
+    {
+        std::cerr << setup_status.message << "\n";
+        return 1;
+    }
+
+    const status load_status = load_shader_module(module_name, source.str());
+    if (is_status_error(load_status))
+    {
+        std::cerr << load_status.message << "\n";
+        return 1;
+    }
+
+    std::string header;
+    const status generate_status = generate_shader_struct_header(module_name, argv[3], header);
+    if (is_status_error(generate_status))
+    {
+        std::cerr << generate_status.message << "\n";
+        return 1;
+    }
+
+    //Leave unchanged headers alone so dependent sources aren't rebuilt.
+    if (std::filesystem::exists(output_path))
+    {
+        std::ifstream existing_file(output_path, std::ios::in);
+        std::stringstream existing;
+        existing << existing_file.rdbuf();
+        if (existing.str() == header) return 0;
+    }
+
+    std::ofstream output_file(output_path, std::ios::out | std::ios::trunc);
+    output_file << header;
+    return output_file ? 0 : 1;
+}
@@ -1,6 +1,12 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
 #include <string_view>
+#include <vector>
 
+#include "memory_transfer.hpp"
 #include "shaders.hpp"
 #include "shader_parameter_value.hpp"
 #include "stardraw/api/types.hpp"
@@ -14,9 +20,9 @@ namespace stardraw
     {
         DRAW, DRAW_INDIRECT, DRAW_INDEXED, DRAW_INDEXED_INDIRECT,
         CONFIG_BLENDING, CONFIG_STENCIL, CONFIG_SCISSOR, CONFIG_FACE_CULL, CONFIG_DEPTH_TEST, CONFIG_DEPTH_RANGE, CONFIG_DRAW,
-        BUFFER_COPY, TEXTURE_COPY,
+        BUFFER_COPY, TEXTURE_COPY, BUFFER_TO_TEXTURE_COPY, TEXTURE_TO_BUFFER_COPY,
         CLEAR_WINDOW, CLEAR_BUFFER,
-        CONFIG_SHADER,
+        CONFIG_SHADER, CONFIG_PARAMETER_SET, PUSH_CONSTANTS,
         SIGNAL,
     };
 
@@ -354,6 +360,75 @@ namespace stardraw
         u64 bytes;
     };
 
+    //Value repeated across a cleared buffer range. The pattern is written bit-for-bit, so typed values only determine the bytes and the pattern size.
+    struct buffer_clear_pattern
+    {
+        [[nodiscard]] inline static buffer_clear_pattern zero()
+        {
+            return from_bytes(std::array<u8, 4> {0, 0, 0, 0});
+        }
+
+        [[nodiscard]] inline static buffer_clear_pattern uint8(const u8 value)
+        {
+            return from_bytes(std::array {value});
+        }
+
+        [[nodiscard]] inline static buffer_clear_pattern uint16(const u16 value)
+        {
+            return from_bytes(std::bit_cast<std::array<u8, 2>>(value));
+        }
+
+        [[nodiscard]] inline static buffer_clear_pattern uint32(const u32 value)
+        {
+            return from_bytes(std::bit_cast<std::array<u8, 4>>(value));
+        }
+
+        [[nodiscard]] inline static buffer_clear_pattern float32(const f32 value)
+        {
+            return from_bytes(std::bit_cast<std::array<u8, 4>>(value));
+        }
+
+        [[nodiscard]] inline static buffer_clear_pattern vector(const f32 x, const f32 y, const f32 z, const f32 w)
+        {
+            return from_bytes(std::bit_cast<std::array<u8, 16>>(std::array {x, y, z, w}));
+        }
+
+        [[nodiscard]] inline static buffer_clear_pattern vector(const u32 x, const u32 y, const u32 z, const u32 w)
+        {
+            return from_bytes(std::bit_cast<std::array<u8, 16>>(std::array {x, y, z, w}));
+        }
+
+        template <u64 size>
+        [[nodiscard]] static buffer_clear_pattern from_bytes(const std::array<u8, size>& bytes)
+        {
+            static_assert(size == 1 || size == 2 || size == 4 || size == 8 || size == 12 || size == 16, "Buffer clear patterns must be 1, 2, 4, 8, 12 or 16 bytes");
+            buffer_clear_pattern pattern;
+            std::memcpy(pattern.bytes.data(), bytes.data(), size);
+            pattern.size = size;
+            return pattern;
+        }
+
+        std::array<u8, 16> bytes = {};
+        u8 size = 4;
+    };
+
+    //Fills a buffer range with a repeated pattern on the GPU. The address and byte count must be multiples of the pattern size; a byte count of 0 clears to the end of the buffer,
+    //ending with a partial pattern if the rest of the buffer isn't a whole number of them.
+    struct clear_buffer_command final : command
+    {
+        explicit clear_buffer_command(const std::string_view& buffer, const u64 address = 0, const u64 bytes = 0, const buffer_clear_pattern& pattern = buffer_clear_pattern::zero()) : buffer(buffer), address(address), bytes(bytes), pattern(pattern) {}
+
+        [[nodiscard]] command_type type() const override
+        {
+            return command_type::CLEAR_BUFFER;
+        }
+
+        object_identifier buffer;
+        u64 address;
+        u64 bytes;
+        buffer_clear_pattern pattern;
+    };
+
     enum class clear_window_mode
     {
         COLOR, DEPTH, STENCIL,
@@ -413,6 +488,43 @@ namespace stardraw
         bool erase_previous;
     };
 
+    //Binds a parameter set over the parameters of the current draw specification's shader, until the next draw config. The set must have been created for that shader.
+    struct parameter_set_command final : command
+    {
+        explicit parameter_set_command(const std::string_view& parameter_set) : parameter_set(parameter_set) {}
+
+        [[nodiscard]] command_type type() const override
+        {
+            return command_type::CONFIG_PARAMETER_SET;
+        }
+
+        object_identifier parameter_set;
+    };
+
+    //Largest push constant block a shader may declare.
+    constexpr u32 max_push_constant_bytes = 256;
+
+    /*
+    Writes into the push constant block ([[vk::push_constant]] in slang) seen by every following draw, until overwritten. Bytes outside the written range keep their previous values.
+    The data must match the block's layout - byte_address of a location in the block is its offset. Meant for small per-draw values, where it's far cheaper than a shader_config_command.
+    */
+    struct push_constants_command final : command
+    {
+        explicit push_constants_command(const void* data, const u32 bytes, const u32 offset = 0) : bytes(bytes), offset(offset)
+        {
+            memcpy(this->data.data(), data, std::min(bytes, max_push_constant_bytes));
+        }
+
+        [[nodiscard]] command_type type() const override
+        {
+            return command_type::PUSH_CONSTANTS;
+        }
+
+        std::array<u8, max_push_constant_bytes> data = {};
+        u32 bytes;
+        u32 offset;
+    };
+
     struct signal_command final : command
     {
         explicit signal_command(const std::string_view& signal_name) : signal_name(signal_name) {}
@@ -447,9 +559,11 @@ namespace stardraw
         u32 copy_layers = 1;
     };
 
+    //Copies texels between textures on the GPU. Several regions (eg. atlas moves) can be batched into one command; they're validated up front and copied in order.
     struct texture_copy_command final : command
     {
-        texture_copy_command(const std::string_view& read_texture, const std::string_view& write_texture, const texture_copy_info& copy_info) : read_texture(read_texture), write_texture(write_texture), copy_info(copy_info) {}
+        texture_copy_command(const std::string_view& read_texture, const std::string_view& write_texture, const texture_copy_info& copy_info) : read_texture(read_texture), write_texture(write_texture), regions({copy_info}) {}
+        texture_copy_command(const std::string_view& read_texture, const std::string_view& write_texture, const std::vector<texture_copy_info>& regions) : read_texture(read_texture), write_texture(write_texture), regions(regions) {}
 
         [[nodiscard]] command_type type() const override
         {
@@ -458,6 +572,57 @@ namespace stardraw
 
         object_identifier read_texture;
         object_identifier write_texture;
-        texture_copy_info copy_info;
+        std::vector<texture_copy_info> regions;
+    };
+
+    //Region of a texture copied to or from tightly packed pixels in a buffer. The pixel format describes the buffer side, and is converted the same way as for texture memory transfers.
+    struct texture_buffer_copy_info
+    {
+        u64 buffer_address = 0;
+
+        u32 x = 0;
+        u32 y = 0;
+        u32 z = 0;
+
+        u32 width = 1;
+        u32 height = 1;
+        u32 depth = 1;
+
+        u32 mipmap_level = 0;
+        u32 layer = 0;
+        u32 layers = 1;
+
+        texture_memory_transfer_info::pixel_data_type data_type = texture_memory_transfer_info::pixel_data_type::U8;
+        texture_memory_transfer_info::pixel_channels channels = texture_memory_transfer_info::pixel_channels::RGBA;
+    };
+
+    //Unpacks pixels from a buffer into a texture region on the GPU, eg. for compute generated image data.
+    struct buffer_to_texture_copy_command final : command
+    {
+        buffer_to_texture_copy_command(const std::string_view& source_buffer, const std::string_view& dest_texture, const texture_buffer_copy_info& copy_info) : source_buffer(source_buffer), dest_texture(dest_texture), copy_info(copy_info) {}
+
+        [[nodiscard]] command_type type() const override
+        {
+            return command_type::BUFFER_TO_TEXTURE_COPY;
+        }
+
+        object_identifier source_buffer;
+        object_identifier dest_texture;
+        texture_buffer_copy_info copy_info;
+    };
+
+    //Packs pixels from a texture region into a buffer on the GPU.
+    struct texture_to_buffer_copy_command final : command
+    {
+        texture_to_buffer_copy_command(const std::string_view& source_texture, const std::string_view& dest_buffer, const texture_buffer_copy_info& copy_info) : source_texture(source_texture), dest_buffer(dest_buffer), copy_info(copy_info) {}
+
+        [[nodiscard]] command_type type() const override
+        {
+            return command_type::TEXTURE_TO_BUFFER_COPY;
+        }
+
+        object_identifier source_texture;
+        object_identifier dest_buffer;
+        texture_buffer_copy_info copy_info;
     };
 }
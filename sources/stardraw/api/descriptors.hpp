@@ -1,7 +1,9 @@
 #pragma once
+#include <functional>
 #include <string>
 #include <utility>
 
+#include "commands.hpp"
 #include "shaders.hpp"
 #include "types.hpp"
 #include "starlib/types/polymorphic.hpp"
@@ -12,7 +14,7 @@ namespace stardraw
     using namespace starlib_stdint;
     enum class descriptor_type : u8
     {
-        BUFFER, SHADER, TEXTURE, TEXTURE_SAMPLER, VERTEX_SPECIFICATION, DRAW_SPECIFICATION,
+        BUFFER, SHADER, TEXTURE, TEXTURE_SAMPLER, VERTEX_SPECIFICATION, DRAW_SPECIFICATION, BUFFER_POOL, PARAMETER_SET,
     };
 
     struct descriptor
@@ -40,9 +42,16 @@ namespace stardraw
         SYSRAM, VRAM,
     };
 
+    ///How CPU-visible mappings (direct writes and staging memory) are kept in sync with the GPU.
+    ///COHERENT is simplest, but some drivers back coherent mappings with uncached memory. EXPLICIT_FLUSH tracks written ranges and flushes only those when the transfer is flushed.
+    enum class buffer_mapping_mode : u8
+    {
+        COHERENT, EXPLICIT_FLUSH,
+    };
+
     struct buffer_descriptor final : descriptor
     {
-        explicit buffer_descriptor(const std::string_view& name, const u64 size, const buffer_memory_storage memory = buffer_memory_storage::VRAM) : descriptor(name), size(size), memory(memory) {}
+        explicit buffer_descriptor(const std::string_view& name, const u64 size, const buffer_memory_storage memory = buffer_memory_storage::VRAM, const std::string_view& pool = "", const buffer_mapping_mode mapping = buffer_mapping_mode::COHERENT) : descriptor(name), size(size), memory(memory), pool(pool), mapping(mapping) {}
 
         [[nodiscard]] descriptor_type type() const override
         {
@@ -51,8 +60,55 @@ namespace stardraw
 
         u64 size;
         buffer_memory_storage memory;
+        //If set, the buffer is suballocated from this buffer pool instead of getting its own backend buffer. The pool's memory storage (and mapping mode for direct writes) is used.
+        std::string pool;
+        buffer_mapping_mode mapping;
+    };
+
+    //A large shared buffer that many small buffers can be suballocated from, saving backend buffer objects and rebinds. The size is rounded up to the backend's allocation granularity.
+    struct buffer_pool_descriptor final : descriptor
+    {
+        explicit buffer_pool_descriptor(const std::string_view& name, const u64 size, const buffer_memory_storage memory = buffer_memory_storage::VRAM, const buffer_mapping_mode mapping = buffer_mapping_mode::COHERENT) : descriptor(name), size(size), memory(memory), mapping(mapping) {}
+
+        [[nodiscard]] descriptor_type type() const override
+        {
+            return descriptor_type::BUFFER_POOL;
+        }
+
+        u64 size;
+        buffer_memory_storage memory;
+        buffer_mapping_mode mapping;
+    };
+
+    struct buffer_pool_info
+    {
+        u64 size = 0;
+        u64 used_bytes = 0;
+        u64 free_bytes = 0;
+        u64 largest_free_block = 0;
+        u32 allocations = 0;
+        u32 free_blocks = 0;
+        //0 when all free space is one contiguous block, approaching 1 as free space gets scattered into small blocks.
+        f32 fragmentation = 0;
     };
 
+    //Estimated GPU memory held by a render context, by category. Drivers may round allocations up, so treat these as lower bounds.
+    struct memory_usage_info
+    {
+        u64 buffer_bytes = 0;
+        u64 texture_bytes = 0;
+        //Persistent staging memory for streaming uploads and downloads.
+        u64 staging_bytes = 0;
+        //Short-lived upload memory - the async upload and push constant rings, scheduled uploads and in flight texture uploads.
+        u64 transient_bytes = 0;
+        u64 total_bytes = 0;
+        //Zero when no budget is set.
+        u64 budget_bytes = 0;
+    };
+
+    //Invoked after an evictable object has been deleted to get back under the memory budget, so it can be re-created when it's next needed.
+    using object_eviction_callback = std::function<void(descriptor_type type, const std::string& name, u64 bytes)>;
+
     enum class vertex_data_type : u8
     {
         //Simple non-converting types (same representation in shader and buffer)
@@ -118,9 +174,15 @@ namespace stardraw
         std::string shader;
     };
 
+    enum class shader_compile_mode : u8
+    {
+        BLOCKING, //The shader is ready as soon as it's created.
+        ASYNCHRONOUS, //Creation returns immediately and the shader is PENDING while it's transpiled on a worker thread and compiled by the driver in the background.
+    };
+
     struct shader_descriptor final : descriptor
     {
-        shader_descriptor(const std::string_view& name, const std::vector<shader_stage>& stages) : descriptor(name), stages(stages), cache_ptr(nullptr), cache_size(0) {}
+        shader_descriptor(const std::string_view& name, const std::vector<shader_stage>& stages, const shader_compile_mode compile_mode = shader_compile_mode::BLOCKING, const std::string_view& fallback = "") : descriptor(name), stages(stages), cache_ptr(nullptr), cache_size(0), compile_mode(compile_mode), fallback(fallback) {}
         shader_descriptor(const std::string_view& name, const void* cache_ptr, const u64 cache_size) : descriptor(name), stages({}), cache_ptr(cache_ptr), cache_size(cache_size) {}
 
         [[nodiscard]] descriptor_type type() const override
@@ -131,6 +193,27 @@ namespace stardraw
         std::vector<shader_stage> stages;
         const void* cache_ptr;
         const u64 cache_size;
+        shader_compile_mode compile_mode = shader_compile_mode::BLOCKING;
+        //Shader used by draws while this one is PENDING, with its own parameters. Without one, draws using a pending shader are skipped.
+        std::string fallback;
+    };
+
+    /*
+    An immutable set of parameters ("material") for a shader, bound with a parameter_set_command. Parameters are given the same way as in a shader_config_command.
+    Referenced textures and buffers are resolved once, and plain data is packed into uniform buffers owned by the set - so it must live in constant buffers or parameter blocks,
+    and the set can't also bind a buffer to them. Binding the set is then a fixed sequence of slot binds.
+    */
+    struct parameter_set_descriptor final : descriptor
+    {
+        parameter_set_descriptor(const std::string_view& name, const std::string_view& shader, const std::vector<shader_parameter>& parameters) : descriptor(name), shader(shader), parameters(parameters) {}
+
+        [[nodiscard]] descriptor_type type() const override
+        {
+            return descriptor_type::PARAMETER_SET;
+        }
+
+        std::string shader;
+        std::vector<shader_parameter> parameters;
     };
 
     enum class texture_data_type : u8
@@ -1,13 +1,55 @@
 #pragma once
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+
 #include "types.hpp"
 namespace stardraw
 {
     using namespace starlib_stdint;
     enum class memory_transfer_status
     {
+        PENDING, //Download is waiting for the GPU to finish writing the data. Poll transfer_status() until it becomes READY.
         READY, TRANSFERRING, COMPLETE
     };
 
+    class memory_transfer_handle;
+
+    //Order in which scheduled uploads are serviced. Critical uploads ignore the frame budget entirely.
+    enum class upload_priority : u8
+    {
+        CRITICAL, NORMAL, BACKGROUND
+    };
+
+    struct upload_queue_info
+    {
+        u32 queued_uploads = 0;
+        u64 queued_critical_bytes = 0;
+        u64 queued_normal_bytes = 0;
+        u64 queued_background_bytes = 0;
+        u64 frame_budget = 0;
+        u64 bytes_uploaded_last_frame = 0;
+    };
+
+    //Invoked on the render thread (from process_memory_transfers) when a download becomes ready to transfer.
+    using memory_transfer_ready_callback = std::function<void(memory_transfer_handle* handle)>;
+
+    //Works directly on the transfer's staging memory - write into it for uploads, read out of it for downloads.
+    //Lets data be decoded or decompressed straight into staging memory without an intermediate copy.
+    using memory_transfer_callback = std::function<status(void* memory, u64 bytes)>;
+
+    //As above, but also receives the region's offset within the transfer (used when a transfer is split between threads).
+    using memory_transfer_region_callback = std::function<status(u64 offset, void* memory, u64 bytes)>;
+
+
+    struct buffer_memory_region
+    {
+        u64 address;
+        u64 bytes;
+    };
 
     struct buffer_memory_transfer_info
     {
@@ -16,14 +58,48 @@ namespace stardraw
             UPLOAD_UNCHECKED, //Fastest upload, but not syncronization safe. Use if doing your own syncronization checks.
             UPLOAD_STREAMING, //Fast upload, allocates additional memory to stage uploads. Use for small repeated uploads.
             UPLOAD_CHUNK, //Slower upload, creates a single-use staging buffer. Use for large infrequent uploads.
+            DOWNLOAD, //Asynchronous readback through a staging ring. The handle stays PENDING until the GPU copy has completed (usually a frame or two later).
+            UPLOAD_ASYNC, //Multi-producer upload through the shared async ring. Prepare, transfer and flush are all safe from any thread; the copy is issued by process_memory_transfers.
+            UPLOAD_SCHEDULED, //Like UPLOAD_CHUNK, but flushing queues the copy; process_memory_transfers paces it by priority and the per-frame upload budget.
+            UPLOAD_TRACKED, //Direct write like UPLOAD_UNCHECKED, but preparing only waits if GPU work submitted since an earlier write, copy or draw touching an overlapping range is still in flight. Draws count as reading the whole of every buffer bound at the time. Requires SYSRAM storage.
         };
 
         std::string target;
         u64 address;
         u64 bytes;
         type transfer_type = type::UPLOAD_CHUNK;
+
+        //Only used by downloads - called once the data is ready to be transferred out.
+        memory_transfer_ready_callback ready_callback = nullptr;
+
+        //Only used by scheduled uploads.
+        upload_priority priority = upload_priority::NORMAL;
+
+        //Scatter upload (UPLOAD_STREAMING and UPLOAD_CHUNK only). If set, address and bytes are ignored; the source data is the regions packed back to back in this order.
+        //Callback and transfer_region writes see the same packing. Regions must not overlap. Regions adjacent both here and in the buffer are copied together.
+        std::vector<buffer_memory_region> regions = {};
     };
 
+    //Streams a byte range of a file into a buffer. The file is memory mapped a chunk at a time and copied straight from the mapping into staging memory, so nothing is read into an intermediate heap allocation.
+    struct buffer_file_transfer_info
+    {
+        std::filesystem::path path;
+        u64 file_offset = 0;
+        //Number of bytes to read. Zero reads to the end of the file.
+        u64 bytes = 0;
+
+        std::string target;
+        u64 address = 0;
+
+        //Bytes mapped and uploaded per step, rounded up to the mapping granularity. Bounds peak resident memory for the file.
+        u64 chunk_bytes = 64 * 1024 * 1024;
+
+        //Any upload type except UPLOAD_ASYNC. Each chunk is a separate transfer of this type.
+        buffer_memory_transfer_info::type transfer_type = buffer_memory_transfer_info::type::UPLOAD_CHUNK;
+
+        //Only used by scheduled uploads.
+        upload_priority priority = upload_priority::NORMAL;
+    };
 
     struct texture_memory_transfer_info
     {
@@ -37,6 +113,13 @@ namespace stardraw
             R, RG, RGB, RGBA, DEPTH, STENCIL
         };
 
+        enum class type : u8
+        {
+            UPLOAD, //Creates a single-use staging buffer to unpack pixels from.
+            UPLOAD_SCHEDULED, //Like UPLOAD, but flushing queues the unpack; process_memory_transfers paces it by priority and the per-frame upload budget.
+            DOWNLOAD, //Asynchronous readback through a staging ring. The handle stays PENDING until the GPU copy has completed (usually a frame or two later).
+        };
+
         std::string target;
         u32 x = 0;
         u32 y = 0;
@@ -54,6 +137,14 @@ namespace stardraw
         pixel_data_type data_type = pixel_data_type::U8;
         //The channels that the pixels being provided include
         pixel_channels channels = pixel_channels::RGBA;
+
+        type transfer_type = type::UPLOAD;
+
+        //Only used by downloads - called once the data is ready to be transferred out.
+        memory_transfer_ready_callback ready_callback = nullptr;
+
+        //Only used by scheduled uploads.
+        upload_priority priority = upload_priority::NORMAL;
     };
 
     //Single-use threadsafe handle for performing a memory transfer.
@@ -64,8 +155,70 @@ namespace stardraw
 
         //Transfer the requested memory amount in or out of data. Blocks calling thread until transfer is completed (or an error status is generated)
         //Call from a different thread if you want to avoid blocking your render thread during the transfer
+        //Downloads can only be transferred once transfer_status() reports READY.
         virtual status transfer(void* data) = 0;
+
+        //Transfer by running the callback over the whole staging region.
+        virtual status transfer(const memory_transfer_callback& callback) = 0;
+
+        //Transfer a sub-region. Can be called concurrently from several threads for disjoint regions;
+        //the transfer is complete once every byte has been covered. A failed region can be retried.
+        virtual status transfer_region(u64 offset, u64 bytes, const memory_transfer_callback& callback) = 0;
+
+        [[nodiscard]] virtual u64 transfer_bytes() = 0;
         virtual memory_transfer_status transfer_status() = 0;
     };
 
+    //Splits a transfer into chunk_bytes sized regions and works through them on up to `workers` threads (including the calling one). Blocks until every region is done.
+    //For compressed assets, compress in independent blocks of chunk_bytes so each region can be decompressed on its own.
+    inline status transfer_memory_parallel(memory_transfer_handle* handle, const u64 chunk_bytes, const u32 workers, const memory_transfer_region_callback& callback)
+    {
+        if (chunk_bytes == 0) return {status_type::INVALID, "Parallel transfer chunk size must be greater than zero"};
+
+        const u64 total_bytes = handle->transfer_bytes();
+        //An empty transfer has no chunks to hand out, but still needs completing.
+        if (total_bytes == 0) return handle->transfer_region(0, 0, [](void*, const u64) { return status(status_type::SUCCESS); });
+
+        const u64 chunk_count = (total_bytes + chunk_bytes - 1) / chunk_bytes;
+        std::atomic<u64> next_chunk = 0;
+        std::mutex error_mutex;
+        status first_error = status_type::SUCCESS;
+
+        const auto worker = [&]()
+        {
+            for (u64 chunk = next_chunk++; chunk < chunk_count; chunk = next_chunk++)
+            {
+                const u64 offset = chunk * chunk_bytes;
+                const u64 bytes = std::min(chunk_bytes, total_bytes - offset);
+                const status region_status = handle->transfer_region(offset, bytes, [&](void* memory, const u64 region_bytes)
+                {
+                    return callback(offset, memory, region_bytes);
+                });
+
+                if (is_status_error(region_status))
+                {
+                    const std::lock_guard lock(error_mutex);
+                    if (!is_status_error(first_error)) first_error = region_status;
+                    next_chunk = chunk_count;
+                    return;
+                }
+            }
+        };
+
+        std::vector<std::future<void>> helpers;
+        const u64 helper_count = std::min<u64>(workers, chunk_count);
+        for (u64 idx = 1; idx < helper_count; idx++)
+        {
+            helpers.push_back(std::async(std::launch::async, worker));
+        }
+
+        worker();
+        for (std::future<void>& helper : helpers)
+        {
+            helper.wait();
+        }
+
+        return first_error;
+    }
+
 }
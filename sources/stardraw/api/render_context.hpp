@@ -24,11 +24,40 @@ namespace stardraw
         [[nodiscard]] virtual status create_objects(const descriptor_list&& descriptors) = 0;
         [[nodiscard]] virtual status delete_object(descriptor_type type, const std::string_view& name) = 0;
 
+        //Reallocate a buffer's storage. With preserve set, existing contents (up to the smaller size) are copied on the GPU. Vertex specifications referencing the buffer are updated.
+        [[nodiscard]] virtual status resize_buffer(const std::string_view& name, const u64 new_size, const bool preserve) = 0;
+
+        //Grow a buffer to at least min_size bytes, at least doubling it so repeated appends resize a logarithmic number of times. Returns NOTHING_TO_DO if it's already big enough.
+        [[nodiscard]] virtual status ensure_buffer_size(const std::string_view& name, const u64 min_size, const bool preserve) = 0;
+
+        //Query occupancy and fragmentation of a buffer pool.
+        [[nodiscard]] virtual status get_buffer_pool_info(const std::string_view& name, buffer_pool_info* out_info) = 0;
+
+        //Limit the estimated GPU memory used by the context. Zero means unlimited.
+        //When over budget after creating or resizing objects, evictable objects are deleted least recently bound first. If that isn't enough, RANGE_OVERFLOW is returned (the objects are still created).
+        [[nodiscard]] virtual status set_memory_budget(const u64 bytes) = 0;
+        [[nodiscard]] virtual status get_memory_usage(memory_usage_info* out_info) = 0;
+        [[nodiscard]] virtual status get_object_memory_usage(descriptor_type type, const std::string_view& name, u64* out_bytes) = 0;
+
+        //Mark a buffer or texture as re-creatable, allowing it to be evicted when over the memory budget. The callback is invoked once it has been evicted.
+        //Anything still referencing an evicted object (vertex specifications, shader parameters) must be re-pointed or re-created by the callback's owner.
+        [[nodiscard]] virtual status set_object_evictable(descriptor_type type, const std::string_view& name, const object_eviction_callback& callback) = 0;
+
+        //Evict least recently bound evictable objects until usage is at most target_bytes. Objects with queued or in progress uploads are skipped, and submitted async uploads are copied first.
+        [[nodiscard]] virtual status evict_objects(const u64 target_bytes) = 0;
+
+        //SUCCESS once a shader is ready to draw with, PENDING while an asynchronous compile is in progress, or the error the compile failed with.
+        [[nodiscard]] virtual status get_shader_status(const std::string_view& name) = 0;
+
+        //Swaps hot reloaded shader programs into the shaders using them. Call at a frame boundary. Each affected shader is rebuilt asynchronously and keeps drawing with its
+        //old program until the new one is ready, and keeps its parameters. Returns the reload failure, if any, and the old programs are kept.
+        [[nodiscard]] virtual status apply_shader_reloads() = 0;
+
         [[nodiscard]] virtual signal_status check_signal(const std::string_view& name) = 0;
         [[nodiscard]] virtual signal_status wait_signal(const std::string_view& name, const u64 timeout_nanos) = 0;
 
         //Create a memory transfer handle for uploading or downloading data to/from a buffer.
-        //Memory transfer handles are single-use and threadsafe.
+        //Memory transfer handles are single-use and threadsafe. Only UPLOAD_ASYNC transfers may be prepared and flushed off the render thread.
         [[nodiscard]] virtual status prepare_buffer_memory_transfer(const buffer_memory_transfer_info& info, memory_transfer_handle** out_handle) = 0;
 
         //Flush a memory transfer to/from a buffer, completing or cancelling it. Any memory writes by the transfer are gaurenteed to be visible after flushing.
@@ -41,10 +70,18 @@ namespace stardraw
             memory_transfer_handle* transfer_handle;
             status prepare_status = prepare_buffer_memory_transfer(info, &transfer_handle);
             if (is_status_error(prepare_status)) return prepare_status;
+            if (info.transfer_type == buffer_memory_transfer_info::type::DOWNLOAD && wait_memory_transfer(transfer_handle, UINT64_MAX) != signal_status::SIGNALLED)
+            {
+                (void)flush_buffer_memory_transfer(transfer_handle);
+                return {status_type::BACKEND_ERROR, "Waiting for buffer download failed"};
+            }
             transfer_handle->transfer(data);
             return flush_buffer_memory_transfer(transfer_handle);
         }
 
+        //Uploads a range of a file to a buffer, without reading the file into memory first. Blocks until every chunk has been transferred and flushed.
+        [[nodiscard]] status transfer_buffer_memory_from_file(const buffer_file_transfer_info& info);
+
         //Create a memory transfer handle for uploading or downloading data to/from a texture
         //Memory transfer handles are single-use and threadsafe.
         [[nodiscard]] virtual status prepare_texture_memory_transfer(const texture_memory_transfer_info& info, memory_transfer_handle** out_handle) = 0;
@@ -59,8 +96,27 @@ namespace stardraw
             memory_transfer_handle* transfer_handle;
             status prepare_status = prepare_texture_memory_transfer(info, &transfer_handle);
             if (is_status_error(prepare_status)) return prepare_status;
+            if (info.transfer_type == texture_memory_transfer_info::type::DOWNLOAD && wait_memory_transfer(transfer_handle, UINT64_MAX) != signal_status::SIGNALLED)
+            {
+                (void)flush_texture_memory_transfer(transfer_handle);
+                return {status_type::BACKEND_ERROR, "Waiting for texture download failed"};
+            }
             transfer_handle->transfer(data);
             return flush_texture_memory_transfer(transfer_handle);
         }
+
+        //Allocate the ring used by UPLOAD_ASYNC transfers. Must be called from the render thread before any async uploads are prepared.
+        [[nodiscard]] virtual status configure_async_uploads(const u64 ring_bytes) = 0;
+
+        //Limit how many bytes of scheduled uploads are copied per call to process_memory_transfers. Zero means unlimited. Critical uploads always run in full.
+        [[nodiscard]] virtual status set_upload_budget(const u64 bytes_per_frame) = 0;
+        [[nodiscard]] virtual status get_upload_queue_info(upload_queue_info* out_info) = 0;
+
+        //Progress outstanding memory transfers. Issues the copies for flushed async uploads and scheduled uploads within the frame budget. Downloads whose GPU copies have completed become READY and have their ready callbacks invoked.
+        //Call once per frame from the render thread.
+        [[nodiscard]] virtual status process_memory_transfers() = 0;
+
+        //Block until a memory transfer is ready to be transferred (downloads are PENDING until their GPU copy completes). Stalls the pipeline - prefer polling the handle.
+        [[nodiscard]] virtual signal_status wait_memory_transfer(memory_transfer_handle* handle, const u64 timeout_nanos) = 0;
     };
 }
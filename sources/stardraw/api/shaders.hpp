@@ -1,4 +1,5 @@
 #pragma once
+#include <filesystem>
 #include <vector>
 #include "types.hpp"
 #include "starlib/types/starlib_stdint.hpp"
@@ -20,22 +21,36 @@ namespace stardraw
             u64 size;
         };
 
+        //A contiguous run of fields copied from the packed input to the padded output, with adjacent fields merged.
+        struct copy_run
+        {
+            u64 read_offset;
+            u64 write_offset;
+            u64 size;
+        };
+
         u64 packed_size = 0;
         u64 padded_size = 0;
         std::vector<pad> pads;
+        //Precompiled per-element copy plan, built once when the layout is created.
+        std::vector<copy_run> copy_runs;
     };
 
+    //Backend-facing reflection data, precomputed per program so locating and binding parameters never walks the compiler's reflection.
+    struct shader_parameter_reflection;
+    struct shader_reflection_table;
+
     struct shader_parameter_location
     {
         [[nodiscard]] shader_parameter_location index(u32 index) const;
         [[nodiscard]] shader_parameter_location field(const std::string_view& name) const;
-        [[nodiscard]] bool operator==(const shader_parameter_location& other) const = default;
+        [[nodiscard]] bool operator==(const shader_parameter_location& other) const;
 
-        void* root_ptr = nullptr;
-        void* offset_ptr = nullptr;
-        u32 root_idx = 0;
+        const shader_reflection_table* table = nullptr;
+        const shader_parameter_reflection* reflection = nullptr;
+        //Hash of the path from the root parameter. Array indices all hash the same - they're folded into the addresses below.
+        u64 path_hash = 0;
         u32 byte_address = 0;
-        u32 binding_range = 0;
         u32 binding_range_index = 0;
     };
 
@@ -49,7 +64,10 @@ namespace stardraw
         void* data;
         u32 data_size;
         void* internal_ptr;
+        shader_reflection_table* reflection_table = nullptr;
         graphics_api api;
+        //Hash of everything the program was generated from. Backends use it to key their own cached compilation results.
+        u64 content_hash = 0;
     };
 
     struct shader_macro
@@ -71,15 +89,86 @@ namespace stardraw
         bool operator==(const shader_entry_point& key) const = default;
     };
 
+    struct shader_module_source
+    {
+        std::string module_name;
+        std::string source;
+    };
+
     [[nodiscard]] status setup_shader_compiler(const std::vector<shader_macro>& macro_defines = {});
+
+    /*
+    Enables the persistent shader cache. Slang IR for modules loaded from source, generated SPIR-V, transpiled GLSL and driver program binaries are stored in the directory,
+    keyed by a hash of the source, compiler macros, compiler version and (for program binaries) the driver. Later loads of unchanged shaders skip the matching compile steps.
+    An empty path disables the cache. Entries are never evicted automatically - use clear_shader_cache.
+    */
+    [[nodiscard]] status set_shader_cache_directory(const std::filesystem::path& directory);
+    [[nodiscard]] status clear_shader_cache();
     [[nodiscard]] status load_shader_module(const std::string_view& module_name, const std::string_view& source);
     [[nodiscard]] status load_shader_module(const std::string_view& module_name, const void* cache_ptr, const u64 cache_size);
+
+    /*
+    Loads modules in parallel. Shader loading, linking and program creation are safe from any thread - each thread compiles in its own session, and sees every module loaded so far.
+    Modules may be in any order: ones whose imports haven't loaded yet are retried once the rest have. A max_threads of 0 uses every hardware thread.
+    */
+    [[nodiscard]] status load_shader_library(const std::vector<shader_module_source>& modules, const u32 max_threads = 0);
+
+    //Loads a module from a file on disk. Unlike modules loaded from memory, file modules (and anything importing them) can be hot reloaded when the file or its includes change.
+    [[nodiscard]] status load_shader_module_file(const std::string_view& module_name, const std::filesystem::path& path);
+
+    /*
+    Watches the files of every module loaded with load_shader_module_file. When one changes, the affected modules are recompiled and relinked on a background thread,
+    and programs created from the relinked sets are regenerated. Nothing changes until apply_shader_reloads is called - usually at a frame boundary through render_context::apply_shader_reloads.
+    Modules loaded from memory as source are recompiled against reloaded imports, but modules loaded from cached IR keep building against the old imports. Shader variants
+    aren't reloaded.
+    */
+    [[nodiscard]] status set_shader_hot_reload(const bool enabled);
+
+    /*
+    Swaps every finished reload into its existing shader_program, so pointers to programs stay valid. Parameter locations found before a reload stay usable, but must be
+    remapped with the new program's reflection before binding.
+    Each caller passes the generation it last saw, starting from shader_reload_generation(), and gets every program reloaded since then - including ones another caller
+    swapped in - along with the latest reload failure if it's newer, in which case the affected programs were left as they were. Without a generation, callers share one.
+    */
+    [[nodiscard]] status apply_shader_reloads(std::vector<shader_program*>* out_reloaded_programs = nullptr, u64* io_seen_generation = nullptr);
+    [[nodiscard]] u64 shader_reload_generation();
     [[nodiscard]] status cache_shader_module(const std::string& module_name, void** out_cache_ptr, u64& out_cache_size);
     [[nodiscard]] status link_shader_modules(const std::string& linked_set_name, const std::vector<shader_entry_point>& entry_points, const std::vector<std::string>& additional_modules = {});
 
     [[nodiscard]] status create_shader_program(const std::string& linked_set_name, const shader_entry_point& entry_point, const graphics_api& api, shader_program** out_shader_program);
     [[nodiscard]] status delete_shader_program(shader_program** shader_program);
 
+    struct shader_variant_set_info
+    {
+        //Modules in dependency order - each module may only import modules listed before it.
+        std::vector<shader_module_source> modules;
+        std::vector<shader_entry_point> entry_points;
+        //Macro names a permutation may define. Anything else in a permutation is rejected.
+        std::vector<std::string> permutation_keys;
+    };
+
+    /*
+    Declares a set of shader variants. Nothing is compiled here - each permutation of the keys is compiled in its own session on first use, with the macros from setup_shader_compiler
+    plus the permutation's macros defined. Permutations are matched regardless of macro order, and variants whose generated code is identical share a single program.
+    */
+    [[nodiscard]] status declare_shader_variants(const std::string& variant_set_name, const shader_variant_set_info& info);
+
+    //Returns the program for a permutation, compiling it if needed. The program is owned by the variant set and stays valid until delete_shader_variants.
+    [[nodiscard]] status get_shader_variant(const std::string& variant_set_name, const std::vector<shader_macro>& permutation, const shader_entry_point& entry_point, const graphics_api& api, shader_program** out_shader_program);
+
+    //Compiles every entry point of each listed permutation on a background thread. Variants requested while this runs wait only if they are the one being compiled.
+    //Manifests passed while a precompile is running are queued onto it. Waiting returns the first failure across everything queued.
+    [[nodiscard]] status precompile_shader_variants(const std::string& variant_set_name, const std::vector<std::vector<shader_macro>>& manifest, const graphics_api& api);
+    [[nodiscard]] status wait_shader_variant_precompile(const std::string& variant_set_name);
+    [[nodiscard]] status delete_shader_variants(const std::string& variant_set_name);
+
+    /*
+    Generates a C++ header mirroring every buffer-of-struct parameter in a loaded module, padded to the module's buffer layout rules, with static_asserted offsets and sizes.
+    Data in the generated structs can be copied straight into buffers without a layout_shader_buffer_memory pass. Normally run at build time through the stardraw-reflect tool.
+    Structs are named after their layout rules (eg. light_std140, light_std430), as a struct used in both uniform and storage buffers needs a definition for each.
+    */
+    [[nodiscard]] status generate_shader_struct_header(const std::string_view& module_name, const std::string_view& namespace_name, std::string& out_header);
+
     [[nodiscard]] status create_shader_buffer_layout(const shader_program* program, const std::string_view& buffer_name, shader_buffer_layout** out_buffer_layout);
     [[nodiscard]] status delete_shader_buffer_layout(shader_buffer_layout** buffer_layout);
 
@@ -90,4 +179,10 @@ namespace stardraw
     Support for other types is dependent on the api, and attempting to use types an API does not support is undefined behaviour.
     */
     [[nodiscard]] void* layout_shader_buffer_memory(const shader_buffer_layout* layout, const void* data, const u64 data_size);
+
+    /*
+    Writes the data laid out according to the given buffer layout directly into the destination, such as a mapped memory transfer, without an intermediate allocation.
+    The destination must have room for padded_size bytes per element. Padding bytes in the destination are left untouched.
+    */
+    [[nodiscard]] status layout_shader_buffer_memory(const shader_buffer_layout* layout, const void* data, const u64 data_size, void* destination, const u64 destination_size);
 }
@@ -24,6 +24,7 @@ namespace stardraw
         ALREADY_INITIALIZED, NOT_INITIALIZED,
         UNKNOWN, DUPLICATE, UNEXPECTED, RANGE_OVERFLOW, TIMEOUT,
         BACKEND_ERROR, INVALID,
+        PENDING, //Work was started but hasn't finished yet, eg. an asynchronous shader compile. Not an error.
     };
 
     struct status
@@ -41,6 +42,7 @@ namespace stardraw
         switch (status.type)
         {
             case status_type::NOTHING_TO_DO:
+            case status_type::PENDING:
             case status_type::SUCCESS: return false;
             default: return true;
         }
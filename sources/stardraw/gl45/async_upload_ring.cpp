@@ -0,0 +1,179 @@
+#include "async_upload_ring.hpp"
+
+#include <algorithm>
+#include <format>
+
+#include <tracy/Tracy.hpp>
+#include <tracy/TracyOpenGL.hpp>
+
+namespace stardraw::gl45
+{
+    async_upload_ring::~async_upload_ring()
+    {
+        for (const retire_batch& batch : in_flight_batches)
+        {
+            glDeleteSync(batch.fence);
+        }
+
+        gl_memory_transfer_handle* handle = submitted_handles.exchange(nullptr);
+        while (handle != nullptr)
+        {
+            gl_memory_transfer_handle* next = handle->next_submitted;
+            delete handle;
+            handle = next;
+        }
+
+        if (ring_buffer_id != 0) glDeleteBuffers(1, &ring_buffer_id);
+    }
+
+    status async_upload_ring::initialize(const u64 size)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Allocate async upload ring");
+
+        if (is_initialized()) return {status_type::ALREADY_INITIALIZED, "Async uploads have already been configured for this context"};
+        if (size == 0) return {status_type::INVALID, "Async upload ring size must be greater than zero"};
+
+        glCreateBuffers(1, &ring_buffer_id);
+        if (ring_buffer_id == 0) return {status_type::BACKEND_ERROR, "Unable to create async upload ring"};
+
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glNamedBufferStorage(ring_buffer_id, size, nullptr, flags);
+
+        ring_buffer_ptr = static_cast<GLbyte*>(glMapNamedBufferRange(ring_buffer_id, 0, size, flags));
+        if (ring_buffer_ptr == nullptr)
+        {
+            glDeleteBuffers(1, &ring_buffer_id);
+            ring_buffer_id = 0;
+            return {status_type::BACKEND_ERROR, "Unable to map async upload ring"};
+        }
+
+        ring_size = size;
+        return status_type::SUCCESS;
+    }
+
+    u64 async_upload_ring::allocated_bytes() const
+    {
+        return ring_size;
+    }
+
+    bool async_upload_ring::is_initialized() const
+    {
+        return ring_buffer_ptr != nullptr;
+    }
+
+    status async_upload_ring::reserve(const std::string& target, const u64 address, const u64 bytes, gl_memory_transfer_handle** out_handle)
+    {
+        if (!is_initialized()) return {status_type::NOT_INITIALIZED, "Async uploads haven't been configured for this context"};
+        if (bytes == 0) return {status_type::INVALID, "Can't reserve an empty async upload"};
+        if (bytes > ring_size) return {status_type::RANGE_OVERFLOW, std::format("Async upload of {0} bytes is larger than the async upload ring ({1} bytes)", bytes, ring_size)};
+
+        u64 reservation_begin = ring_head.load(std::memory_order_relaxed);
+        u64 data_begin;
+        u64 reservation_end;
+        do
+        {
+            //Reservations never straddle the end of the ring - if it doesn't fit, the remainder is skipped and retired along with this reservation.
+            const u64 ring_offset = reservation_begin % ring_size;
+            data_begin = (ring_offset + bytes > ring_size) ? reservation_begin + (ring_size - ring_offset) : reservation_begin;
+            reservation_end = data_begin + bytes;
+
+            if (reservation_end - ring_tail.load(std::memory_order_acquire) > ring_size) return {status_type::RANGE_OVERFLOW, "Async upload ring is full - process memory transfers on the render thread and try again"};
+        }
+        while (!ring_head.compare_exchange_weak(reservation_begin, reservation_end, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        gl_memory_transfer_handle* handle = new gl_memory_transfer_handle();
+        handle->transfer_buffer_ptr = ring_buffer_ptr + (data_begin % ring_size);
+        handle->transfer_buffer_id = ring_buffer_id;
+        handle->transfer_buffer_address = data_begin % ring_size;
+        handle->transfer_destination_address = address;
+        handle->transfer_size = bytes;
+        handle->is_async = true;
+        handle->async_target = target;
+        handle->async_reservation_begin = reservation_begin;
+        handle->async_reservation_end = reservation_end;
+        unsubmitted_handles.fetch_add(1, std::memory_order_relaxed);
+        *out_handle = handle;
+        return status_type::SUCCESS;
+    }
+
+    void async_upload_ring::submit(gl_memory_transfer_handle* handle)
+    {
+        gl_memory_transfer_handle* head = submitted_handles.load(std::memory_order_relaxed);
+        do
+        {
+            handle->next_submitted = head;
+        }
+        while (!submitted_handles.compare_exchange_weak(head, handle, std::memory_order_release, std::memory_order_relaxed));
+        unsubmitted_handles.fetch_sub(1, std::memory_order_release);
+    }
+
+    bool async_upload_ring::has_unsubmitted_handles() const
+    {
+        return unsubmitted_handles.load(std::memory_order_acquire) > 0;
+    }
+
+    std::vector<gl_memory_transfer_handle*> async_upload_ring::drain()
+    {
+        ZoneScoped;
+        release_completed_regions();
+
+        std::vector<gl_memory_transfer_handle*> handles;
+        gl_memory_transfer_handle* handle = submitted_handles.exchange(nullptr, std::memory_order_acquire);
+        while (handle != nullptr)
+        {
+            handles.push_back(handle);
+            handle = handle->next_submitted;
+        }
+
+        //The submission stack is LIFO - put the handles back into submission order so overlapping writes land in the order they were flushed.
+        std::ranges::reverse(handles);
+        return handles;
+    }
+
+    void async_upload_ring::retire(const std::vector<gl_memory_transfer_handle*>& handles)
+    {
+        if (handles.empty()) return;
+
+        retire_batch batch;
+        batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        for (const gl_memory_transfer_handle* handle : handles)
+        {
+            batch.regions.emplace_back(handle->async_reservation_begin, handle->async_reservation_end);
+            delete handle;
+        }
+        in_flight_batches.push_back(std::move(batch));
+    }
+
+    GLuint async_upload_ring::gl_id() const
+    {
+        return ring_buffer_id;
+    }
+
+    void async_upload_ring::release_completed_regions()
+    {
+        std::erase_if(in_flight_batches, [this](const retire_batch& batch)
+        {
+            const GLenum status = glClientWaitSync(batch.fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return false;
+
+            glDeleteSync(batch.fence);
+            for (const auto& [begin, end] : batch.regions)
+            {
+                completed_regions[begin] = end;
+            }
+            return true;
+        });
+
+        //Handles can be flushed out of order, so the tail only moves over a contiguous run of completed reservations.
+        u64 tail = ring_tail.load(std::memory_order_relaxed);
+        auto region = completed_regions.find(tail);
+        while (region != completed_regions.end())
+        {
+            tail = region->second;
+            completed_regions.erase(region);
+            region = completed_regions.find(tail);
+        }
+        ring_tail.store(tail, std::memory_order_release);
+    }
+}
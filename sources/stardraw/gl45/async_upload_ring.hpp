@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gl_headers.hpp"
+#include "types.hpp"
+#include "stardraw/api/types.hpp"
+
+namespace stardraw::gl45
+{
+    //Persistently mapped upload ring shared by every thread. Reserving space and submitting finished handles is lock-free and never touches GL,
+    //so worker threads can write straight into staging memory. The GL thread drains the submissions, issues the copies, and retires ring space once they're fenced.
+    class async_upload_ring
+    {
+    public:
+        ~async_upload_ring();
+
+        //GL thread only.
+        [[nodiscard]] status initialize(const u64 size);
+        [[nodiscard]] bool is_initialized() const;
+
+        //Any thread.
+        [[nodiscard]] status reserve(const std::string& target, const u64 address, const u64 bytes, gl_memory_transfer_handle** out_handle);
+        void submit(gl_memory_transfer_handle* handle);
+        //True while some thread holds a reservation it hasn't submitted yet. Their targets aren't known until they're drained.
+        [[nodiscard]] bool has_unsubmitted_handles() const;
+
+        //GL thread only. Returns submitted handles in submission order; ownership passes to the caller, who must hand them back through retire() after issuing copies.
+        [[nodiscard]] std::vector<gl_memory_transfer_handle*> drain();
+        void retire(const std::vector<gl_memory_transfer_handle*>& handles);
+        [[nodiscard]] GLuint gl_id() const;
+        [[nodiscard]] u64 allocated_bytes() const;
+
+    private:
+        struct retire_batch
+        {
+            GLsync fence = nullptr;
+            std::vector<std::pair<u64, u64>> regions;
+        };
+
+        void release_completed_regions();
+
+        GLuint ring_buffer_id = 0;
+        GLbyte* ring_buffer_ptr = nullptr;
+        u64 ring_size = 0;
+
+        //Head and tail are monotonic byte counters; the ring offset is the counter modulo the ring size.
+        std::atomic<u64> ring_head = 0;
+        std::atomic<u64> ring_tail = 0;
+        std::atomic<gl_memory_transfer_handle*> submitted_handles = nullptr;
+        std::atomic<u64> unsubmitted_handles = 0;
+
+        std::vector<retire_batch> in_flight_batches;
+        std::map<u64, u64> completed_regions;
+    };
+}
@@ -106,6 +106,7 @@ namespace stardraw::gl45
         ZoneScoped;
         TracyGpuZone("[Stardraw] Execute draw cmd");
         if (active_draw_specification == nullptr) return {status_type::INVALID, "No draw specification is currently active"};
+        if (active_shader_pending) return status_type::NOTHING_TO_DO;
         glDrawArraysInstancedBaseInstance(gl_draw_mode(cmd->mode), cmd->start_vertex, cmd->count, cmd->instances, cmd->start_instance);
         return status_type::SUCCESS;
     }
@@ -116,12 +117,13 @@ namespace stardraw::gl45
         TracyGpuZone("[Stardraw] Execute draw indexed cmd");
 
         if (active_draw_specification == nullptr) return {status_type::INVALID, "No draw specification is currently active"};
+        if (active_shader_pending) return status_type::NOTHING_TO_DO;
         if (!active_draw_specification->has_index_buffer) return {status_type::INVALID, "The current draw specification does not have an index buffer for indexed drawing"};
 
         const GLenum index_element_type = gl_index_size(cmd->index_type);
         const u32 index_element_size = gl_type_size(index_element_type);
 
-        glDrawElementsInstancedBaseVertexBaseInstance(gl_draw_mode(cmd->mode), cmd->count, index_element_type, reinterpret_cast<const void*>(cmd->start_index * index_element_size), cmd->instances, cmd->vertex_index_offset, cmd->start_instance);
+        glDrawElementsInstancedBaseVertexBaseInstance(gl_draw_mode(cmd->mode), cmd->count, index_element_type, reinterpret_cast<const void*>(active_index_buffer_offset + cmd->start_index * index_element_size), cmd->instances, cmd->vertex_index_offset, cmd->start_instance);
 
         return status_type::SUCCESS;
     }
@@ -132,6 +134,7 @@ namespace stardraw::gl45
         TracyGpuZone("[Stardraw] Execute draw indirect cmd");
 
         if (active_draw_specification == nullptr) return {status_type::INVALID, "No draw specification is currently active"};
+        if (active_shader_pending) return status_type::NOTHING_TO_DO;
 
         glMultiDrawArraysIndirect(gl_draw_mode(cmd->mode), reinterpret_cast<const void*>(cmd->indirect_offset * sizeof(draw_arrays_indirect_params)), cmd->draw_count, 0);
         return status_type::SUCCESS;
@@ -143,8 +146,12 @@ namespace stardraw::gl45
         TracyGpuZone("[Stardraw] Execute draw indirect cmd");
 
         if (active_draw_specification == nullptr) return {status_type::INVALID, "No draw specification is currently active"};
+        if (active_shader_pending) return status_type::NOTHING_TO_DO;
         if (!active_draw_specification->has_index_buffer) return {status_type::INVALID, "The current draw specification does not have an index buffer for indexed drawing"};
 
+        //Indirect draws read their first index from the command buffer, so there's nowhere to apply a pooled index buffer's offset.
+        if (active_index_buffer_offset != 0) return {status_type::UNSUPPORTED, "Indexed indirect draws can't use an index buffer suballocated from a buffer pool"};
+
         const GLenum index_element_type = gl_index_size(cmd->index_type);
 
         glMultiDrawElementsIndirect(gl_draw_mode(cmd->mode), index_element_type, reinterpret_cast<const void*>(cmd->indirect_offset * sizeof(draw_elements_indirect_params)), cmd->draw_count, 0);
@@ -167,7 +174,128 @@ namespace stardraw::gl45
         if (!source_state->is_in_buffer_range(cmd->source_address, cmd->bytes)) return {status_type::RANGE_OVERFLOW, std::format("Requested copy range is out of range in buffer '{0}'", cmd->source_buffer.name)};
         if (!dest_state->is_in_buffer_range(cmd->dest_address, cmd->bytes)) return {status_type::RANGE_OVERFLOW, std::format("Requested copy range is out of range in buffer '{0}'", cmd->dest_buffer.name)};
 
-        return dest_state->copy_data(source_state->gl_id(), cmd->source_address, cmd->dest_address, cmd->bytes);
+        mark_used(source_state);
+        mark_used(dest_state);
+        source_state->record_pending_range(static_cast<GLintptr>(cmd->source_address), static_cast<GLsizeiptr>(cmd->bytes));
+        return dest_state->copy_data(source_state->gl_id(), source_state->gl_offset() + cmd->source_address, cmd->dest_address, cmd->bytes);
+    }
+
+    status render_context::execute_texture_copy(const texture_copy_command* cmd)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Execute texture copy cmd");
+
+        const texture_state* read_state = find_texture_state(cmd->read_texture);
+        if (read_state == nullptr) return { status_type::UNKNOWN, std::format("No texture with name '{0}' in context", cmd->read_texture.name) };
+
+        const texture_state* write_state = find_texture_state(cmd->write_texture);
+        if (write_state == nullptr) return { status_type::UNKNOWN, std::format("No texture with name '{0}' in context", cmd->write_texture.name) };
+
+        //Validate every region before copying any, so a bad region doesn't leave the batch half applied.
+        for (const texture_copy_info& region : cmd->regions)
+        {
+            const status validate_status = write_state->validate_copy(read_state, region);
+            if (is_status_error(validate_status)) return validate_status;
+        }
+
+        for (const texture_copy_info& region : cmd->regions)
+        {
+            const status copy_status = write_state->copy_pixels(read_state, region);
+            if (is_status_error(copy_status)) return copy_status;
+        }
+
+        mark_used(read_state);
+        mark_used(write_state);
+        return status_type::SUCCESS;
+    }
+
+    inline u64 pixel_data_type_size(const texture_memory_transfer_info::pixel_data_type data_type)
+    {
+        switch (data_type)
+        {
+            case texture_memory_transfer_info::pixel_data_type::U8:
+            case texture_memory_transfer_info::pixel_data_type::I8: return 1;
+            case texture_memory_transfer_info::pixel_data_type::U32:
+            case texture_memory_transfer_info::pixel_data_type::I32:
+            case texture_memory_transfer_info::pixel_data_type::F32: return 4;
+        }
+        return 1;
+    }
+
+    status render_context::execute_buffer_to_texture_copy(const buffer_to_texture_copy_command* cmd)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Execute buffer to texture copy cmd");
+
+        const buffer_state* buffer = find_buffer_state(cmd->source_buffer);
+        if (buffer == nullptr) return { status_type::UNKNOWN, std::format("No buffer with name '{0}' in context", cmd->source_buffer.name) };
+        if (!buffer->is_valid()) return{ status_type::INVALID, std::format("Buffer '{0}' is in an invalid state", cmd->source_buffer.name) };
+
+        const texture_state* texture = find_texture_state(cmd->dest_texture);
+        if (texture == nullptr) return { status_type::UNKNOWN, std::format("No texture with name '{0}' in context", cmd->dest_texture.name) };
+
+        const u64 address = cmd->copy_info.buffer_address;
+        if (address > static_cast<u64>(buffer->get_size())) return {status_type::RANGE_OVERFLOW, std::format("Requested copy range is out of range in buffer '{0}'", cmd->source_buffer.name)};
+        //GL requires pixel buffer offsets to be aligned to the size of the pixel components.
+        if ((buffer->gl_offset() + address) % pixel_data_type_size(cmd->copy_info.data_type) != 0) return {status_type::INVALID, std::format("Pixel data in buffer '{0}' is misaligned for its data type", cmd->source_buffer.name)};
+
+        mark_used(buffer);
+        buffer->record_pending_range(static_cast<GLintptr>(address), buffer->get_size() - static_cast<GLsizeiptr>(address));
+        mark_used(texture);
+        return texture->unpack_from_buffer(cmd->copy_info, buffer->gl_id(), buffer->gl_offset() + address, buffer->get_size() - address);
+    }
+
+    status render_context::execute_texture_to_buffer_copy(const texture_to_buffer_copy_command* cmd)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Execute texture to buffer copy cmd");
+
+        const texture_state* texture = find_texture_state(cmd->source_texture);
+        if (texture == nullptr) return { status_type::UNKNOWN, std::format("No texture with name '{0}' in context", cmd->source_texture.name) };
+
+        const buffer_state* buffer = find_buffer_state(cmd->dest_buffer);
+        if (buffer == nullptr) return { status_type::UNKNOWN, std::format("No buffer with name '{0}' in context", cmd->dest_buffer.name) };
+        if (!buffer->is_valid()) return{ status_type::INVALID, std::format("Buffer '{0}' is in an invalid state", cmd->dest_buffer.name) };
+
+        const u64 address = cmd->copy_info.buffer_address;
+        if (address > static_cast<u64>(buffer->get_size())) return {status_type::RANGE_OVERFLOW, std::format("Requested copy range is out of range in buffer '{0}'", cmd->dest_buffer.name)};
+        if ((buffer->gl_offset() + address) % pixel_data_type_size(cmd->copy_info.data_type) != 0) return {status_type::INVALID, std::format("Pixel data in buffer '{0}' is misaligned for its data type", cmd->dest_buffer.name)};
+
+        const status pack_status = texture->pack_to_buffer(cmd->copy_info, buffer->gl_id(), buffer->gl_offset() + address, buffer->get_size() - address);
+        if (is_status_error(pack_status)) return pack_status;
+
+        buffer->record_pending_range(address, texture->buffer_copy_bytes(cmd->copy_info));
+        mark_used(texture);
+        mark_used(buffer);
+        return status_type::SUCCESS;
+    }
+
+    status render_context::execute_clear_buffer(const clear_buffer_command* cmd)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Execute clear buffer cmd");
+
+        const buffer_state* state = find_buffer_state(cmd->buffer);
+        if (state == nullptr) return { status_type::UNKNOWN, std::format("No buffer with name '{0}' in context", cmd->buffer.name) };
+        if (!state->is_valid()) return{ status_type::INVALID, std::format("Buffer '{0}' is in an invalid state", cmd->buffer.name) };
+        if (cmd->address > static_cast<u64>(state->get_size())) return {status_type::RANGE_OVERFLOW, std::format("Requested clear range is out of range in buffer '{0}'", cmd->buffer.name)};
+
+        mark_used(state);
+        if (cmd->bytes != 0) return state->clear_data(cmd->address, cmd->bytes, cmd->pattern.bytes.data(), cmd->pattern.size);
+
+        //Clearing to the end can leave a tail shorter than the pattern, which is filled with the pattern's leading bytes one at a time.
+        const u64 remaining = state->get_size() - cmd->address;
+        const u64 body_bytes = remaining - remaining % cmd->pattern.size;
+        status clear_status = body_bytes == 0 ? status_type::NOTHING_TO_DO : state->clear_data(cmd->address, body_bytes, cmd->pattern.bytes.data(), cmd->pattern.size);
+        if (is_status_error(clear_status)) return clear_status;
+
+        for (u64 idx = 0; idx < remaining - body_bytes; idx++)
+        {
+            clear_status = state->clear_data(cmd->address + body_bytes + idx, 1, &cmd->pattern.bytes[idx], 1);
+            if (is_status_error(clear_status)) return clear_status;
+        }
+
+        return remaining == 0 ? status_type::NOTHING_TO_DO : status_type::SUCCESS;
     }
 
     status render_context::execute_draw_config(const draw_config_command* cmd)
@@ -363,7 +491,8 @@ namespace stardraw::gl45
         TracyGpuZone("[Stardraw] Execute shader parameters upload cmd");
         shader_state* shader = find_shader_state(cmd->shader);
         if (shader == nullptr) return { status_type::UNKNOWN, std::format("Referenced shader object '{0}' not found in context (referenced by shader parameters upload command)", cmd->shader.name) };
-        if (!shader->is_valid()) return {status_type::INVALID, std::format("Shader object '{0}' is in an invalid state (referenced by shader parameters upload command)", cmd->shader.name) };
+        //Parameters for a still compiling shader are stored, and applied once it's ready.
+        if (!shader->is_valid() && !shader->is_pending()) return {status_type::INVALID, std::format("Shader object '{0}' is in an invalid state (referenced by shader parameters upload command)", cmd->shader.name) };
 
         if (cmd->erase_previous) shader->clear_parameters();
 
@@ -376,6 +505,73 @@ namespace stardraw::gl45
         return status_type::SUCCESS;
     }
 
+    status render_context::execute_parameter_set(const parameter_set_command* cmd)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Execute parameter set cmd");
+
+        parameter_set_state* set = find_parameter_set_state(cmd->parameter_set);
+        if (set == nullptr) return {status_type::UNKNOWN, std::format("Parameter set '{0}' not found in context", cmd->parameter_set.name)};
+        if (active_draw_specification == nullptr || active_draw_specification->shader.hash != set->shader.hash) return {status_type::INVALID, std::format("Parameter set '{0}' must be bound after a draw config using shader '{1}'", cmd->parameter_set.name, set->shader.name)};
+        if (active_shader_pending) return status_type::NOTHING_TO_DO;
+
+        if (set->resolved_generation != binding_generation)
+        {
+            const status resolve_status = resolve_parameter_set(set);
+            //A fallback is drawing with its own parameters while the set's shader compiles.
+            if (resolve_status.type == status_type::PENDING) return status_type::NOTHING_TO_DO;
+            if (is_status_error(resolve_status)) return resolve_status;
+        }
+
+        mark_used(set);
+        for (const parameter_set_state::slot_bind& bind : set->binds)
+        {
+            status bind_status = status_type::SUCCESS;
+            switch (bind.type)
+            {
+                case parameter_set_state::slot_bind::bind_type::TEXTURE:
+                {
+                    mark_used(bind.texture);
+                    bind_status = bind.texture->bind_to_texture_slot(bind.slot);
+                    break;
+                }
+                case parameter_set_state::slot_bind::bind_type::IMAGE:
+                {
+                    mark_used(bind.texture);
+                    bind_status = bind.texture->bind_to_image_slot(bind.slot, bind.value->image_texture_mipmap, bind.value->image_texture_layer, bind.value->image_texture_array, bind.value->image_access);
+                    break;
+                }
+                case parameter_set_state::slot_bind::bind_type::BUFFER:
+                {
+                    mark_used(bind.buffer);
+                    bind_status = bind.buffer->bind_to_slot(bind.buffer_target, bind.slot);
+                    note_buffer_binding(bind.buffer_target, bind.slot, bind.buffer_hash);
+                    break;
+                }
+                case parameter_set_state::slot_bind::bind_type::DATA_BLOCK:
+                {
+                    glBindBufferBase(bind.buffer_target, bind.slot, bind.block_buffer_id);
+                    break;
+                }
+            }
+
+            if (is_status_error(bind_status)) return bind_status;
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    status render_context::execute_push_constants(const push_constants_command* cmd)
+    {
+        ZoneScoped;
+        if (cmd->bytes == 0) return status_type::NOTHING_TO_DO;
+        if (cmd->offset > max_push_constant_bytes || cmd->bytes > max_push_constant_bytes - cmd->offset) return {status_type::RANGE_OVERFLOW, std::format("Push constants are limited to {0} bytes", max_push_constant_bytes)};
+
+        memcpy(push_constant_data.data() + cmd->offset, cmd->data.data(), cmd->bytes);
+        //The whole block is always bound, so shaders never read past the end of a smaller binding.
+        return push_constants.push(push_constant_data.data(), max_push_constant_bytes);
+    }
+
     status render_context::execute_signal(const signal_command* cmd)
     {
         ZoneScoped;
@@ -0,0 +1,184 @@
+#include "buffer_pool_state.hpp"
+
+#include <format>
+#include <tracy/Tracy.hpp>
+#include <tracy/TracyOpenGL.hpp>
+
+namespace stardraw::gl45
+{
+    buffer_pool_state::buffer_pool_state(const buffer_pool_descriptor& desc, status& out_status) : memory(desc.memory), explicit_flush(desc.mapping == buffer_mapping_mode::EXPLICIT_FLUSH)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Create buffer pool object");
+
+        pool_name = desc.identifier().name;
+
+        GLint uniform_alignment = 1;
+        GLint storage_alignment = 1;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_alignment);
+        allocation_granularity = std::max<u64>({static_cast<u64>(uniform_alignment), static_cast<u64>(storage_alignment), 16});
+
+        glCreateBuffers(1, &pool_buffer_id);
+        if (pool_buffer_id == 0)
+        {
+            out_status = {status_type::BACKEND_ERROR, std::format("Creating buffer pool {0} failed", pool_name)};
+            return;
+        }
+
+        const GLbitfield coherence_flags = explicit_flush ? 0 : GL_MAP_COHERENT_BIT;
+        const GLbitfield flags = (desc.memory == buffer_memory_storage::SYSRAM) ? GL_MAP_PERSISTENT_BIT | coherence_flags | GL_MAP_WRITE_BIT | GL_CLIENT_STORAGE_BIT : 0;
+
+        if (desc.size == 0)
+        {
+            out_status = {status_type::INVALID, std::format("Buffer pool {0} can't be empty", pool_name)};
+            return;
+        }
+
+        //Round up so the pool only ever hands out whole granules, and is never smaller than asked for.
+        pool_size = (desc.size + allocation_granularity - 1) / allocation_granularity * allocation_granularity;
+        glNamedBufferStorage(pool_buffer_id, pool_size, nullptr, flags);
+        insert_free_block(0, pool_size);
+        out_status = status_type::SUCCESS;
+    }
+
+    buffer_pool_state::~buffer_pool_state()
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Delete buffer pool object");
+        glDeleteBuffers(1, &pool_buffer_id);
+    }
+
+    descriptor_type buffer_pool_state::object_type() const
+    {
+        return descriptor_type::BUFFER_POOL;
+    }
+
+    u64 buffer_pool_state::memory_usage() const
+    {
+        return pool_size;
+    }
+
+    bool buffer_pool_state::is_valid() const
+    {
+        return pool_buffer_id != 0;
+    }
+
+    bool buffer_pool_state::has_allocations() const
+    {
+        return !allocations.empty();
+    }
+
+    status buffer_pool_state::allocate(const u64 bytes, u64& out_offset)
+    {
+        const u64 granules = std::max<u64>(bytes, 1) + allocation_granularity - 1;
+        const u64 size = granules - granules % allocation_granularity;
+
+        const auto best_fit = free_blocks_by_size.lower_bound(size);
+        if (best_fit == free_blocks_by_size.end())
+        {
+            const u64 largest_free = free_blocks_by_size.empty() ? 0 : free_blocks_by_size.rbegin()->first;
+            return {status_type::RANGE_OVERFLOW, std::format("Buffer pool '{0}' can't fit {1} bytes (largest free block is {2} bytes)", pool_name, bytes, largest_free)};
+        }
+
+        const u64 block_size = best_fit->first;
+        const u64 block_offset = best_fit->second;
+        remove_free_block(block_offset, block_size);
+        if (block_size > size) insert_free_block(block_offset + size, block_size - size);
+
+        allocations[block_offset] = size;
+        used_bytes += size;
+        out_offset = block_offset;
+        return status_type::SUCCESS;
+    }
+
+    void buffer_pool_state::free(const u64 offset)
+    {
+        if (!allocations.contains(offset)) return;
+
+        u64 block_offset = offset;
+        u64 block_size = allocations[offset];
+        allocations.erase(offset);
+        used_bytes -= block_size;
+
+        //Merge with the following free block
+        const auto next = free_blocks_by_offset.find(block_offset + block_size);
+        if (next != free_blocks_by_offset.end())
+        {
+            const u64 next_size = next->second;
+            remove_free_block(block_offset + block_size, next_size);
+            block_size += next_size;
+        }
+
+        //Merge with the preceding free block
+        const auto after = free_blocks_by_offset.upper_bound(block_offset);
+        if (after != free_blocks_by_offset.begin())
+        {
+            const auto previous = std::prev(after);
+            if (previous->first + previous->second == block_offset)
+            {
+                const u64 previous_offset = previous->first;
+                const u64 previous_size = previous->second;
+                remove_free_block(previous_offset, previous_size);
+                block_offset = previous_offset;
+                block_size += previous_size;
+            }
+        }
+
+        insert_free_block(block_offset, block_size);
+    }
+
+    status buffer_pool_state::map(GLbyte** out_ptr)
+    {
+        if (pool_buffer_ptr == nullptr)
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | (explicit_flush ? GL_MAP_FLUSH_EXPLICIT_BIT : GL_MAP_COHERENT_BIT);
+            pool_buffer_ptr = static_cast<GLbyte*>(glMapNamedBufferRange(pool_buffer_id, 0, pool_size, flags));
+            if (pool_buffer_ptr == nullptr) return {status_type::BACKEND_ERROR, std::format("Unable to write directly to buffer pool '{0}' (you probably need to create it with the SYSRAM memory hint?)", pool_name)};
+        }
+
+        *out_ptr = pool_buffer_ptr;
+        return status_type::SUCCESS;
+    }
+
+    bool buffer_pool_state::is_explicit_flush() const
+    {
+        return explicit_flush;
+    }
+
+    buffer_pool_info buffer_pool_state::info() const
+    {
+        buffer_pool_info pool_info;
+        pool_info.size = pool_size;
+        pool_info.used_bytes = used_bytes;
+        pool_info.free_bytes = pool_size - used_bytes;
+        pool_info.largest_free_block = free_blocks_by_size.empty() ? 0 : free_blocks_by_size.rbegin()->first;
+        pool_info.allocations = static_cast<u32>(allocations.size());
+        pool_info.free_blocks = static_cast<u32>(free_blocks_by_offset.size());
+        pool_info.fragmentation = pool_info.free_bytes == 0 ? 0 : 1.0f - static_cast<f32>(pool_info.largest_free_block) / static_cast<f32>(pool_info.free_bytes);
+        return pool_info;
+    }
+
+    GLuint buffer_pool_state::gl_id() const
+    {
+        return pool_buffer_id;
+    }
+
+    void buffer_pool_state::insert_free_block(const u64 offset, const u64 size)
+    {
+        free_blocks_by_size.emplace(size, offset);
+        free_blocks_by_offset[offset] = size;
+    }
+
+    void buffer_pool_state::remove_free_block(const u64 offset, const u64 size)
+    {
+        auto [begin, end] = free_blocks_by_size.equal_range(size);
+        for (auto it = begin; it != end; ++it)
+        {
+            if (it->second != offset) continue;
+            free_blocks_by_size.erase(it);
+            break;
+        }
+        free_blocks_by_offset.erase(offset);
+    }
+}
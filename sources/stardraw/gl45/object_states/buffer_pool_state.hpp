@@ -0,0 +1,51 @@
+#pragma once
+#include <map>
+#include <unordered_map>
+
+#include "../gl_headers.hpp"
+#include "../types.hpp"
+
+namespace stardraw::gl45
+{
+    //Shared backend buffer that buffer objects can be suballocated from. Uses a best-fit free list with coalescing;
+    //every block is a multiple of the strictest buffer binding alignment, so suballocations can always be bound as uniform/storage ranges.
+    class buffer_pool_state final : public object_state
+    {
+    public:
+        explicit buffer_pool_state(const buffer_pool_descriptor& desc, status& out_status);
+        ~buffer_pool_state() override;
+
+        [[nodiscard]] descriptor_type object_type() const override;
+        [[nodiscard]] u64 memory_usage() const override;
+
+        [[nodiscard]] bool is_valid() const;
+        [[nodiscard]] bool has_allocations() const;
+
+        [[nodiscard]] status allocate(const u64 bytes, u64& out_offset);
+        void free(const u64 offset);
+
+        [[nodiscard]] status map(GLbyte** out_ptr);
+        [[nodiscard]] bool is_explicit_flush() const;
+
+        [[nodiscard]] buffer_pool_info info() const;
+        [[nodiscard]] GLuint gl_id() const;
+
+    private:
+        void insert_free_block(const u64 offset, const u64 size);
+        void remove_free_block(const u64 offset, const u64 size);
+
+        GLuint pool_buffer_id = 0;
+        u64 pool_size = 0;
+        u64 allocation_granularity = 1;
+        u64 used_bytes = 0;
+        buffer_memory_storage memory;
+        bool explicit_flush = false;
+        GLbyte* pool_buffer_ptr = nullptr;
+
+        std::multimap<u64, u64> free_blocks_by_size;
+        std::map<u64, u64> free_blocks_by_offset;
+        std::unordered_map<u64, u64> allocations;
+
+        std::string pool_name;
+    };
+}
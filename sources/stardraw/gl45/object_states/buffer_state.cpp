@@ -1,6 +1,8 @@
 #include "buffer_state.hpp"
 
+#include <algorithm>
 #include <format>
+#include <limits>
 #include <tracy/Tracy.hpp>
 #include <tracy/TracyOpenGL.hpp>
 #include "../gl_headers.hpp"
@@ -10,7 +12,7 @@
 
 namespace stardraw::gl45
 {
-    buffer_state::buffer_state(const buffer_descriptor& desc, status& out_status)
+    buffer_state::buffer_state(const buffer_descriptor& desc, status& out_status) : staging_uploader(desc.mapping == buffer_mapping_mode::EXPLICIT_FLUSH)
     {
         ZoneScoped;
         TracyGpuZone("[Stardraw] Create buffer object");
@@ -24,10 +26,34 @@ namespace stardraw::gl45
             return;
         }
 
-        const GLbitfield flags = (desc.memory == buffer_memory_storage::SYSRAM) ? GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT | GL_MAP_WRITE_BIT | GL_CLIENT_STORAGE_BIT : 0;
+        explicit_flush = desc.mapping == buffer_mapping_mode::EXPLICIT_FLUSH;
+        const GLbitfield coherence_flags = explicit_flush ? 0 : GL_MAP_COHERENT_BIT;
+        storage_flags = (desc.memory == buffer_memory_storage::SYSRAM) ? GL_MAP_PERSISTENT_BIT | coherence_flags | GL_MAP_WRITE_BIT | GL_CLIENT_STORAGE_BIT : 0;
 
         main_buffer_size = desc.size;
-        glNamedBufferStorage(main_buffer_id, main_buffer_size, nullptr, flags);
+        glNamedBufferStorage(main_buffer_id, main_buffer_size, nullptr, storage_flags);
+        out_status = status_type::SUCCESS;
+    }
+
+    buffer_state::buffer_state(const buffer_descriptor& desc, buffer_pool_state* pool, status& out_status) : pool(pool), staging_uploader(desc.mapping == buffer_mapping_mode::EXPLICIT_FLUSH)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Create pooled buffer object");
+
+        buffer_name = desc.identifier().name;
+
+        u64 offset;
+        const status allocate_status = pool->allocate(desc.size, offset);
+        if (is_status_error(allocate_status))
+        {
+            out_status = allocate_status;
+            return;
+        }
+
+        main_buffer_id = pool->gl_id();
+        main_buffer_offset = offset;
+        explicit_flush = pool->is_explicit_flush();
+        main_buffer_size = desc.size;
         out_status = status_type::SUCCESS;
     }
 
@@ -35,6 +61,11 @@ namespace stardraw::gl45
     {
         ZoneScoped;
         TracyGpuZone("[Stardraw] Delete buffer object");
+        if (pool != nullptr)
+        {
+            if (main_buffer_id != 0) pool->free(main_buffer_offset);
+            return;
+        }
         glDeleteBuffers(1, &main_buffer_id);
     }
 
@@ -43,6 +74,16 @@ namespace stardraw::gl45
         return descriptor_type::BUFFER;
     }
 
+    u64 buffer_state::memory_usage() const
+    {
+        return pool == nullptr ? main_buffer_size : 0;
+    }
+
+    u64 buffer_state::staging_memory_usage() const
+    {
+        return staging_uploader.allocated_bytes();
+    }
+
     bool buffer_state::is_valid() const
     {
         return main_buffer_id != 0;
@@ -60,7 +101,7 @@ namespace stardraw::gl45
     {
         ZoneScoped;
         TracyGpuZone("[Stardraw] Bind buffer (slot binding)");
-        glBindBufferRange(target, slot, main_buffer_id, 0, main_buffer_size);
+        glBindBufferRange(target, slot, main_buffer_id, main_buffer_offset, main_buffer_size);
         return status_type::SUCCESS;
     }
 
@@ -69,7 +110,7 @@ namespace stardraw::gl45
         ZoneScoped;
         TracyGpuZone("[Stardraw] Bind buffer (slot binding)");
         if (!is_in_buffer_range(address, bytes)) return {status_type::RANGE_OVERFLOW, std::format("Requested bind range is out of range in buffer '{0}'", buffer_name)};
-        glBindBufferRange(target, slot, main_buffer_id, address, bytes);
+        glBindBufferRange(target, slot, main_buffer_id, main_buffer_offset + address, bytes);
         return status_type::SUCCESS;
     }
 
@@ -90,9 +131,10 @@ namespace stardraw::gl45
     {
         ZoneScoped;
         TracyGpuZone("[Stardraw] Flush staged buffer upload");
-        const gl_memory_transfer_handle* staged_handle = dynamic_cast<gl_memory_transfer_handle*>(handle);
+        gl_memory_transfer_handle* staged_handle = dynamic_cast<gl_memory_transfer_handle*>(handle);
         if (staged_handle == nullptr) return {status_type::INVALID, "Invalid memory transfer handle cast - this is an internal bug!"};
-        status copy_status = copy_data(staged_handle->transfer_buffer_id, staged_handle->transfer_buffer_address, staged_handle->transfer_destination_address, staged_handle->transfer_size);
+        staged_handle->flush_mapped_writes();
+        status copy_status = copy_staged_data(staged_handle);
         if (is_status_error(copy_status)) return copy_status;
         return staging_buffer_uploader::flush_upload(staged_handle);
     }
@@ -132,12 +174,67 @@ namespace stardraw::gl45
         const gl_memory_transfer_handle* chunked_handle = dynamic_cast<gl_memory_transfer_handle*>(handle);
         if (chunked_handle == nullptr) return {status_type::INVALID, "Invalid memory transfer handle cast - this is an internal bug!"};
         glUnmapNamedBuffer(chunked_handle->transfer_buffer_id);
-        status copy_status = copy_data(chunked_handle->transfer_buffer_id, chunked_handle->transfer_buffer_address, chunked_handle->transfer_destination_address, chunked_handle->transfer_size);
+        status copy_status = copy_staged_data(chunked_handle);
         glDeleteBuffers(1, &chunked_handle->transfer_buffer_id);
         delete handle;
         return copy_status;
     }
 
+    status buffer_state::prepare_upload_regions(const std::vector<buffer_memory_region>& regions, const bool streaming, memory_transfer_handle** out_handle)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Prepare scatter buffer upload");
+
+        //Staging keeps the caller's order, so the source data (and callback or region writes into staging) line up with the documented packing.
+        std::vector<gl_transfer_region> staged_regions;
+        staged_regions.reserve(regions.size());
+        u64 source_offset = 0;
+        for (const buffer_memory_region& region : regions)
+        {
+            if (!is_in_buffer_range(region.address, region.bytes)) return {status_type::RANGE_OVERFLOW, std::format("Requested upload region is out of range in buffer '{0}'", buffer_name)};
+            staged_regions.push_back({source_offset, source_offset, region.address, region.bytes});
+            source_offset += region.bytes;
+        }
+
+        //Only the copy list is sorted by destination. Regions adjacent in both destination and staging memory share a copy.
+        std::vector<gl_transfer_region> sorted_regions = staged_regions;
+        std::ranges::sort(sorted_regions, {}, &gl_transfer_region::destination_address);
+
+        std::vector<gl_transfer_region> copy_runs;
+        u64 previous_end = 0;
+        bool has_previous = false;
+        for (const gl_transfer_region& region : sorted_regions)
+        {
+            if (has_previous && previous_end > region.destination_address) return {status_type::INVALID, std::format("Scatter upload regions overlap in buffer '{0}'", buffer_name)};
+            if (region.bytes == 0) continue;
+            previous_end = region.destination_address + region.bytes;
+            has_previous = true;
+
+            if (!copy_runs.empty())
+            {
+                gl_transfer_region& run = copy_runs.back();
+                if (run.destination_address + run.bytes == region.destination_address && run.staging_offset + run.bytes == region.staging_offset)
+                {
+                    run.bytes += region.bytes;
+                    continue;
+                }
+            }
+
+            copy_runs.push_back(region);
+        }
+
+        //The regions don't overlap and are all in range, so the total always fits the buffer.
+        memory_transfer_handle* handle;
+        const status prepare_status = streaming ? prepare_upload_data_streaming(0, source_offset, &handle) : prepare_upload_data_chunked(0, source_offset, &handle);
+        if (is_status_error(prepare_status)) return prepare_status;
+
+        gl_memory_transfer_handle* gl_handle = dynamic_cast<gl_memory_transfer_handle*>(handle);
+        gl_handle->regions = std::move(staged_regions);
+        gl_handle->copy_runs = std::move(copy_runs);
+        *out_handle = handle;
+        return status_type::SUCCESS;
+    }
+
     status buffer_state::prepare_upload_data_unchecked(const GLintptr address, const GLintptr bytes, memory_transfer_handle** out_handle)
     {
         ZoneScoped;
@@ -153,26 +250,201 @@ namespace stardraw::gl45
         gl_memory_transfer_handle* handle = new gl_memory_transfer_handle();
         handle->transfer_size = bytes;
         handle->transfer_destination_address = address;
-        handle->transfer_buffer_id = main_buffer_size;
-        handle->transfer_buffer_ptr = main_buff_pointer;
-        handle->transfer_buffer_address = 0;
+        handle->transfer_buffer_id = main_buffer_id;
+        handle->transfer_buffer_ptr = main_buff_pointer + address;
+        handle->transfer_buffer_address = main_buffer_offset + address;
+        handle->explicit_flush = explicit_flush;
         *out_handle = handle;
         return status_type::SUCCESS;
     }
 
-    status buffer_state::flush_upload_data_unchecked(const memory_transfer_handle* handle)
+    status buffer_state::flush_upload_data_unchecked(memory_transfer_handle* handle)
     {
+        gl_memory_transfer_handle* direct_handle = dynamic_cast<gl_memory_transfer_handle*>(handle);
+        if (direct_handle == nullptr) return {status_type::INVALID, "Invalid memory transfer handle cast - this is an internal bug!"};
+        direct_handle->flush_mapped_writes();
         delete handle;
         return status_type::SUCCESS;
     }
 
+    status buffer_state::prepare_upload_data_tracked(const GLintptr address, const GLintptr bytes, memory_transfer_handle** out_handle)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Prepare tracked buffer upload");
+        if (!is_in_buffer_range(address, bytes)) return {status_type::RANGE_OVERFLOW, std::format("Requested upload range is out of range in buffer '{0}'", buffer_name)};
+
+        if (!tracks_ranges)
+        {
+            //Work submitted before tracking started wasn't recorded, so the first tracked write waits for all of it.
+            in_flight_ranges.push_back({0, main_buffer_size, make_shared_gl_fence()});
+            tracks_ranges = true;
+        }
+        const status wait_status = wait_for_range(address, bytes);
+        if (is_status_error(wait_status)) return wait_status;
+
+        return prepare_upload_data_unchecked(address, bytes, out_handle);
+    }
+
+    status buffer_state::flush_upload_data_tracked(memory_transfer_handle* handle) const
+    {
+        gl_memory_transfer_handle* direct_handle = dynamic_cast<gl_memory_transfer_handle*>(handle);
+        if (direct_handle == nullptr) return {status_type::INVALID, "Invalid memory transfer handle cast - this is an internal bug!"};
+
+        //The write is referenced by whatever work is submitted before the next fence point.
+        if (direct_handle->current_status != memory_transfer_status::READY) record_pending_range(direct_handle->transfer_destination_address, direct_handle->transfer_size);
+        return flush_upload_data_unchecked(handle);
+    }
+
+    void buffer_state::fence_pending_ranges(const shared_gl_fence& fence)
+    {
+        //Drop ranges whose work has already completed before adding new ones.
+        std::erase_if(in_flight_ranges, [](const tracked_range& range)
+        {
+            const GLenum wait_result = glClientWaitSync(range.fence.get(), 0, 0);
+            return wait_result == GL_ALREADY_SIGNALED || wait_result == GL_CONDITION_SATISFIED;
+        });
+
+        for (tracked_range& range : pending_ranges)
+        {
+            range.fence = fence;
+            in_flight_ranges.push_back(std::move(range));
+        }
+        pending_ranges.clear();
+    }
+
+    bool buffer_state::is_tracking_ranges() const
+    {
+        return tracks_ranges;
+    }
+
+    status buffer_state::wait_for_range(const GLintptr address, const GLsizeiptr bytes)
+    {
+        ZoneScoped;
+        const auto overlaps = [address, bytes](const tracked_range& range)
+        {
+            return range.address < address + bytes && address < range.address + range.bytes;
+        };
+
+        //Work submitted since the last fence point may still reference pending ranges, so fence them now.
+        if (std::ranges::any_of(pending_ranges, overlaps)) fence_pending_ranges(make_shared_gl_fence());
+
+        for (const tracked_range& range : in_flight_ranges)
+        {
+            if (!overlaps(range)) continue;
+            const GLenum wait_result = glClientWaitSync(range.fence.get(), GL_SYNC_FLUSH_COMMANDS_BIT, std::numeric_limits<GLuint64>::max());
+            if (wait_result == GL_WAIT_FAILED) return {status_type::BACKEND_ERROR, std::format("Waiting for in flight work on buffer '{0}' failed", buffer_name)};
+        }
+
+        std::erase_if(in_flight_ranges, overlaps);
+        return status_type::SUCCESS;
+    }
+
+    void buffer_state::record_pending_range(const GLintptr address, const GLsizeiptr bytes) const
+    {
+        if (!tracks_ranges || bytes <= 0) return;
+
+        //Extend the previous range when writes are sequential, as they are for rings.
+        if (!pending_ranges.empty() && pending_ranges.back().address + pending_ranges.back().bytes == address)
+        {
+            pending_ranges.back().bytes += bytes;
+            return;
+        }
+
+        pending_ranges.push_back({address, bytes, nullptr});
+    }
+
+    status buffer_state::prepare_download_data(const GLintptr address, const GLintptr bytes, staging_buffer_downloader& downloader, const memory_transfer_ready_callback& callback, memory_transfer_handle** out_handle) const
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Prepare buffer download");
+        if (!is_in_buffer_range(address, bytes)) return {status_type::RANGE_OVERFLOW, std::format("Requested download range is out of range in buffer '{0}'", buffer_name)};
+
+        gl_memory_transfer_handle* handle = nullptr;
+        status allocate_status = downloader.allocate_download(bytes, callback, &handle);
+        if (is_status_error(allocate_status)) return allocate_status;
+
+        glCopyNamedBufferSubData(main_buffer_id, handle->transfer_buffer_id, main_buffer_offset + address, handle->transfer_buffer_address, bytes);
+        staging_buffer_downloader::fence_download(handle);
+        *out_handle = handle;
+        return status_type::SUCCESS;
+    }
+
+    status buffer_state::resize(const GLsizeiptr new_size, const bool preserve)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Resize buffer");
+
+        const GLsizeiptr preserved_bytes = preserve ? std::min(new_size, main_buffer_size) : 0;
+
+        if (pool != nullptr)
+        {
+            u64 new_offset;
+            const status allocate_status = pool->allocate(new_size, new_offset);
+            if (is_status_error(allocate_status)) return allocate_status;
+
+            //Both blocks are live at this point, so the ranges can't overlap.
+            if (preserved_bytes > 0) glCopyNamedBufferSubData(main_buffer_id, main_buffer_id, main_buffer_offset, new_offset, preserved_bytes);
+            pool->free(main_buffer_offset);
+            main_buffer_offset = new_offset;
+        }
+        else
+        {
+            GLuint new_buffer_id;
+            glCreateBuffers(1, &new_buffer_id);
+            if (new_buffer_id == 0) return {status_type::BACKEND_ERROR, std::format("Creating resized storage for buffer '{0}' failed", buffer_name)};
+            glNamedBufferStorage(new_buffer_id, new_size, nullptr, storage_flags);
+
+            if (preserved_bytes > 0) glCopyNamedBufferSubData(main_buffer_id, new_buffer_id, 0, 0, preserved_bytes);
+            glDeleteBuffers(1, &main_buffer_id);
+            main_buffer_id = new_buffer_id;
+        }
+
+        //Any direct mapping pointed into the old storage. Tracked ranges referred to it too, except the preserving copy.
+        main_buff_pointer = nullptr;
+        main_buffer_size = new_size;
+        in_flight_ranges.clear();
+        pending_ranges.clear();
+        record_pending_range(0, preserved_bytes);
+        return status_type::SUCCESS;
+    }
+
     status buffer_state::copy_data(const GLuint source_buffer_id, const GLintptr read_address, const GLintptr write_address, const GLintptr bytes) const
     {
         ZoneScoped;
         TracyGpuZone("[Stardraw] Buffer data transfer");
 
-        if (!is_in_buffer_range(read_address, bytes)) return {status_type::RANGE_OVERFLOW, std::format("Requested upload range is out of range in buffer '{0}'", buffer_name)};
-        glCopyNamedBufferSubData(source_buffer_id, main_buffer_id, read_address, write_address, bytes);
+        if (!is_in_buffer_range(write_address, bytes)) return {status_type::RANGE_OVERFLOW, std::format("Requested upload range is out of range in buffer '{0}'", buffer_name)};
+        glCopyNamedBufferSubData(source_buffer_id, main_buffer_id, read_address, main_buffer_offset + write_address, bytes);
+        record_pending_range(write_address, bytes);
+        return status_type::SUCCESS;
+    }
+
+    status buffer_state::clear_data(const GLintptr address, const GLsizeiptr bytes, const void* pattern, const u32 pattern_size) const
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Buffer clear");
+
+        //Pattern bytes are reinterpreted as unsigned integers so they're written bit-for-bit, without any format conversion.
+        GLenum internal_format;
+        GLenum format;
+        GLenum type = GL_UNSIGNED_INT;
+        switch (pattern_size)
+        {
+            case 1: internal_format = GL_R8UI; format = GL_RED_INTEGER; type = GL_UNSIGNED_BYTE; break;
+            case 2: internal_format = GL_R16UI; format = GL_RED_INTEGER; type = GL_UNSIGNED_SHORT; break;
+            case 4: internal_format = GL_R32UI; format = GL_RED_INTEGER; break;
+            case 8: internal_format = GL_RG32UI; format = GL_RG_INTEGER; break;
+            case 12: internal_format = GL_RGB32UI; format = GL_RGB_INTEGER; break;
+            case 16: internal_format = GL_RGBA32UI; format = GL_RGBA_INTEGER; break;
+            default: return {status_type::INVALID, std::format("Unsupported clear pattern size {0} for buffer '{1}'", pattern_size, buffer_name)};
+        }
+
+        if (address % pattern_size != 0 || bytes % pattern_size != 0) return {status_type::INVALID, std::format("Clear range in buffer '{0}' must be aligned to the {1} byte clear pattern", buffer_name, pattern_size)};
+        if (!is_in_buffer_range(address, bytes)) return {status_type::RANGE_OVERFLOW, std::format("Requested clear range is out of range in buffer '{0}'", buffer_name)};
+        if (bytes == 0) return status_type::NOTHING_TO_DO;
+
+        glClearNamedBufferSubData(main_buffer_id, internal_format, main_buffer_offset + address, bytes, format, type, pattern);
+        record_pending_range(address, bytes);
         return status_type::SUCCESS;
     }
 
@@ -191,11 +463,37 @@ namespace stardraw::gl45
         return main_buffer_id;
     }
 
+    GLintptr buffer_state::gl_offset() const
+    {
+        return main_buffer_offset;
+    }
+
+    status buffer_state::copy_staged_data(const gl_memory_transfer_handle* handle) const
+    {
+        if (handle->copy_runs.empty()) return copy_data(handle->transfer_buffer_id, handle->transfer_buffer_address, handle->transfer_destination_address, handle->transfer_size);
+
+        for (const gl_transfer_region& run : handle->copy_runs)
+        {
+            const status copy_status = copy_data(handle->transfer_buffer_id, handle->transfer_buffer_address + run.staging_offset, run.destination_address, run.bytes);
+            if (is_status_error(copy_status)) return copy_status;
+        }
+        return status_type::SUCCESS;
+    }
+
     status buffer_state::map_main_buffer()
     {
         if (main_buff_pointer != nullptr) return status_type::NOTHING_TO_DO;
-        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
-        main_buff_pointer = glMapNamedBufferRange(main_buffer_id, 0, main_buffer_size, flags);
+        if (pool != nullptr)
+        {
+            GLbyte* pool_pointer;
+            const status map_status = pool->map(&pool_pointer);
+            if (is_status_error(map_status)) return map_status;
+            main_buff_pointer = pool_pointer + main_buffer_offset;
+            return status_type::SUCCESS;
+        }
+
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | (explicit_flush ? GL_MAP_FLUSH_EXPLICIT_BIT : GL_MAP_COHERENT_BIT);
+        main_buff_pointer = static_cast<GLbyte*>(glMapNamedBufferRange(main_buffer_id, 0, main_buffer_size, flags));
         if (main_buff_pointer == nullptr) return {status_type::BACKEND_ERROR, std::format("Unable to write directly to buffer '{0}' (you probably need to create it with the SYSRAM memory hint?)", buffer_name)};
         return status_type::SUCCESS;
     }
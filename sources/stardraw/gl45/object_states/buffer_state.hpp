@@ -1,4 +1,6 @@
 #pragma once
+#include "buffer_pool_state.hpp"
+#include "../staging_buffer_downloader.hpp"
 #include "../staging_buffer_uploader.hpp"
 #include "../types.hpp"
 #include "glad/glad.h"
@@ -8,9 +10,13 @@ namespace stardraw::gl45
     {
     public:
         explicit buffer_state(const buffer_descriptor& desc, status& out_status);
+        explicit buffer_state(const buffer_descriptor& desc, buffer_pool_state* pool, status& out_status);
         ~buffer_state() override;
 
         [[nodiscard]] descriptor_type object_type() const override;
+        //Pooled buffers report zero, their memory is owned by the pool.
+        [[nodiscard]] u64 memory_usage() const override;
+        [[nodiscard]] u64 staging_memory_usage() const;
 
         [[nodiscard]] bool is_valid() const;
 
@@ -24,14 +30,36 @@ namespace stardraw::gl45
         [[nodiscard]] status prepare_upload_data_chunked(const GLintptr address, const GLintptr bytes, memory_transfer_handle** out_handle);
         [[nodiscard]] status flush_upload_data_chunked(memory_transfer_handle* handle) const;
 
+        //Scatter upload into several regions through a single staging allocation. Flush with the matching streaming/chunked flush.
+        [[nodiscard]] status prepare_upload_regions(const std::vector<buffer_memory_region>& regions, const bool streaming, memory_transfer_handle** out_handle);
+
         [[nodiscard]] status prepare_upload_data_unchecked(const GLintptr address, const GLintptr bytes, memory_transfer_handle** out_handle);
-        [[nodiscard]] static status flush_upload_data_unchecked(const memory_transfer_handle* handle);
+        [[nodiscard]] static status flush_upload_data_unchecked(memory_transfer_handle* handle);
+
+        //Direct writes that wait on the fences of overlapping ranges still in use by the GPU. Enables range tracking for this buffer.
+        [[nodiscard]] status prepare_upload_data_tracked(const GLintptr address, const GLintptr bytes, memory_transfer_handle** out_handle);
+        [[nodiscard]] status flush_upload_data_tracked(memory_transfer_handle* handle) const;
+
+        //Covers every range touched since the last fence point with the given fence. Called after work referencing the buffer has been submitted.
+        void fence_pending_ranges(const shared_gl_fence& fence);
+        [[nodiscard]] bool is_tracking_ranges() const;
+        //Notes a GPU write to the range, for writes issued outside of the buffer's own copy and clear functions.
+        void record_pending_range(const GLintptr address, const GLsizeiptr bytes) const;
+
+        [[nodiscard]] status prepare_download_data(const GLintptr address, const GLintptr bytes, staging_buffer_downloader& downloader, const memory_transfer_ready_callback& callback, memory_transfer_handle** out_handle) const;
+
+        //Reallocates the buffer's storage (in its pool, if pooled). Contents up to the smaller of the two sizes are copied GPU-side when preserving.
+        [[nodiscard]] status resize(const GLsizeiptr new_size, const bool preserve);
 
         [[nodiscard]] status copy_data(const GLuint source_buffer_id, const GLintptr read_address, const GLintptr write_address, const GLintptr bytes) const;
+        //Fills the range with a repeated 1, 2, 4, 8, 12 or 16 byte pattern on the GPU. Address and bytes must be multiples of the pattern size.
+        [[nodiscard]] status clear_data(const GLintptr address, const GLsizeiptr bytes, const void* pattern, const u32 pattern_size) const;
 
         [[nodiscard]] GLsizeiptr get_size() const;
         [[nodiscard]] bool is_in_buffer_range(const GLintptr address, const GLsizeiptr size) const;
         [[nodiscard]] GLuint gl_id() const;
+        //Offset of this buffer's memory inside gl_id() - non-zero for buffers suballocated from a pool.
+        [[nodiscard]] GLintptr gl_offset() const;
 
     private:
         enum class upload_chunk_state
@@ -39,14 +67,32 @@ namespace stardraw::gl45
             RESERVED, TRANSFERRING
         };
 
+        struct tracked_range
+        {
+            GLintptr address;
+            GLsizeiptr bytes;
+            shared_gl_fence fence;
+        };
+
         [[nodiscard]] status map_main_buffer();
+        [[nodiscard]] status wait_for_range(const GLintptr address, const GLsizeiptr bytes);
+        [[nodiscard]] status copy_staged_data(const gl_memory_transfer_handle* handle) const;
 
         GLuint main_buffer_id = 0;
+        GLintptr main_buffer_offset = 0;
         GLsizeiptr main_buffer_size = 0;
-        void* main_buff_pointer = nullptr;
+        GLbyte* main_buff_pointer = nullptr;
+        GLbitfield storage_flags = 0;
+        bool explicit_flush = false;
+        buffer_pool_state* pool = nullptr;
 
         staging_buffer_uploader staging_uploader;
 
+        bool tracks_ranges = false;
+        //Ranges written by the CPU or by GPU copies since the last fence point. Mutable so const copy paths can record into it.
+        mutable std::vector<tracked_range> pending_ranges;
+        std::vector<tracked_range> in_flight_ranges;
+
         std::string buffer_name;
     };
 }
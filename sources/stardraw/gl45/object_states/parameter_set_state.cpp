@@ -0,0 +1,49 @@
+#include "parameter_set_state.hpp"
+
+#include "tracy/Tracy.hpp"
+#include "tracy/TracyOpenGL.hpp"
+
+namespace stardraw::gl45
+{
+    parameter_set_state::parameter_set_state(const parameter_set_descriptor& descriptor) : shader(descriptor.shader), parameters(descriptor.parameters) {}
+
+    parameter_set_state::~parameter_set_state()
+    {
+        clear_binds();
+    }
+
+    descriptor_type parameter_set_state::object_type() const
+    {
+        return descriptor_type::PARAMETER_SET;
+    }
+
+    u64 parameter_set_state::memory_usage() const
+    {
+        return data_block_bytes;
+    }
+
+    status parameter_set_state::add_data_block(const GLuint slot, const std::vector<u8>& data)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Create parameter set data block");
+
+        GLuint buffer_id = 0;
+        glCreateBuffers(1, &buffer_id);
+        if (buffer_id == 0) return {status_type::BACKEND_ERROR, "Unable to create parameter set data block"};
+
+        glNamedBufferStorage(buffer_id, static_cast<GLsizeiptr>(data.size()), data.data(), 0);
+        data_blocks.push_back(buffer_id);
+        data_block_bytes += data.size();
+        binds.push_back({.type = slot_bind::bind_type::DATA_BLOCK, .slot = slot, .buffer_target = GL_UNIFORM_BUFFER, .block_buffer_id = buffer_id});
+        return status_type::SUCCESS;
+    }
+
+    void parameter_set_state::clear_binds()
+    {
+        if (!data_blocks.empty()) glDeleteBuffers(static_cast<GLsizei>(data_blocks.size()), data_blocks.data());
+        data_blocks.clear();
+        data_block_bytes = 0;
+        binds.clear();
+        resolved_generation = 0;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "buffer_state.hpp"
+#include "texture_state.hpp"
+#include "../types.hpp"
+#include "stardraw/api/commands.hpp"
+
+namespace stardraw::gl45
+{
+    class parameter_set_state final : public object_state
+    {
+    public:
+        //One bind of a resolved set. Resolving is done by the context, which can find the referenced objects.
+        struct slot_bind
+        {
+            enum class bind_type : u8
+            {
+                TEXTURE, IMAGE, BUFFER, DATA_BLOCK
+            };
+
+            bind_type type;
+            GLuint slot;
+            GLenum buffer_target = 0;
+            const texture_state* texture = nullptr;
+            const buffer_state* buffer = nullptr;
+            u64 buffer_hash = 0;
+            GLuint block_buffer_id = 0;
+            //Image bind settings.
+            const shader_parameter_value* value = nullptr;
+        };
+
+        explicit parameter_set_state(const parameter_set_descriptor& descriptor);
+        ~parameter_set_state() override;
+
+        [[nodiscard]] descriptor_type object_type() const override;
+        [[nodiscard]] u64 memory_usage() const override;
+
+        //Creates an immutable uniform buffer holding packed plain data, and adds a bind for it.
+        [[nodiscard]] status add_data_block(const GLuint slot, const std::vector<u8>& data);
+
+        //Drops every bind and data block, before the set is resolved again.
+        void clear_binds();
+
+        object_identifier shader;
+        std::vector<shader_parameter> parameters;
+        std::vector<slot_bind> binds;
+        //The context's binding generation the binds were resolved at. Zero until the set is first resolved.
+        u64 resolved_generation = 0;
+
+    private:
+        std::vector<GLuint> data_blocks;
+        u64 data_block_bytes = 0;
+    };
+}
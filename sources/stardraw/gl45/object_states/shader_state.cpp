@@ -2,7 +2,9 @@
 #include <format>
 #include <spirv_glsl.hpp>
 
+#include "../push_constant_ring.hpp"
 #include "stardraw/internal/internal.hpp"
+#include "stardraw/internal/shader_cache.hpp"
 #include "tracy/Tracy.hpp"
 #include "tracy/TracyOpenGL.hpp"
 
@@ -13,13 +15,17 @@ namespace stardraw::gl45
     {
         ZoneScoped;
         TracyGpuZone("[Stardraw] Create shader object");
-        out_status = create_from_stages(desc.stages);
+        fallback_shader = desc.fallback;
+        stages = desc.stages;
+        out_status = create_from_stages(desc.stages, desc.compile_mode == shader_compile_mode::ASYNCHRONOUS);
     }
 
     shader_state::~shader_state()
     {
         ZoneScoped;
         TracyGpuZone("[Stardraw] Delete shader object")
+        //Still-running transpiles are waited on by the future's destructor; the worker only touches its own copies of the stages.
+        discard_pending_compile();
         if (!is_valid()) return;
 
         glDeleteProgram(shader_program_id);
@@ -31,6 +37,44 @@ namespace stardraw::gl45
         return shader_program_id != 0;
     }
 
+    bool shader_state::is_pending() const
+    {
+        return state == compile_state::TRANSPILING || state == compile_state::COMPILING;
+    }
+
+    status shader_state::poll_compile()
+    {
+        ZoneScoped;
+        if (state == compile_state::TRANSPILING)
+        {
+            if (pending_transpile.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return status_type::PENDING;
+            const status begin_status = begin_compile(pending_transpile.get());
+            if (is_status_error(begin_status)) return begin_status;
+        }
+
+        if (state == compile_state::COMPILING)
+        {
+            //Without parallel compile support, checking the status is what makes the driver compile, so the first poll blocks.
+            if (GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile)
+            {
+                GLint completed = GL_FALSE;
+                glGetProgramiv(pending_program, GL_COMPLETION_STATUS_KHR, &completed);
+                if (completed != GL_TRUE) return status_type::PENDING;
+            }
+
+            return finish_compile();
+        }
+
+        if (state == compile_state::FAILED) return compile_failure;
+        return status_type::SUCCESS;
+    }
+
+    void shader_state::configure_parallel_compile()
+    {
+        if (GLAD_GL_KHR_parallel_shader_compile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        else if (GLAD_GL_ARB_parallel_shader_compile) glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    }
+
     status shader_state::make_active() const
     {
         if (!is_valid()) return {status_type::BACKEND_ERROR, "Shader object not valid!"};
@@ -41,12 +85,37 @@ namespace stardraw::gl45
     status shader_state::upload_parameter(const shader_parameter& parameter)
     {
         if (parameter.location == invalid_shader_paramter_location) return {status_type::UNKNOWN, "Shader parameter location not found in shader"};
-        const auto existing_param = std::ranges::find(parameter_store, parameter);
-        if (existing_param == parameter_store.end()) parameter_store.push_back(parameter);
-        else parameter_store.emplace(existing_param, parameter);
+        const shader_parameter_location location = relocate_parameter(parameter.location);
+        if (location == invalid_shader_paramter_location) return {status_type::UNKNOWN, "Shader parameter location not found in reloaded shader"};
+
+        const shader_parameter relocated = {location, parameter.value};
+        const auto existing_param = std::ranges::find(parameter_store, relocated);
+        if (existing_param == parameter_store.end()) parameter_store.push_back(relocated);
+        else parameter_store.emplace(existing_param, relocated);
         return status_type::SUCCESS;
     }
 
+    bool shader_state::uses_program(const shader_program* program) const
+    {
+        return std::ranges::find(stages, program, &shader_stage::program) != stages.end();
+    }
+
+    shader_parameter_location shader_state::relocate_parameter(const shader_parameter_location& location) const
+    {
+        for (const shader_stage& stage : stages)
+        {
+            if (location.table == stage.program->reflection_table) return location;
+        }
+
+        for (const shader_stage& stage : stages)
+        {
+            const shader_parameter_location relocated = relocate_shader_parameter(location, stage.program);
+            if (relocated != invalid_shader_paramter_location) return relocated;
+        }
+
+        return invalid_shader_paramter_location;
+    }
+
     void shader_state::clear_parameters()
     {
         parameter_store.clear();
@@ -57,60 +126,323 @@ namespace stardraw::gl45
         return descriptor_type::SHADER;
     }
 
-    status shader_state::create_from_stages(const std::vector<shader_stage>& stages)
+    status shader_state::create_from_stages(const std::vector<shader_stage>& stages, const bool async)
     {
-        std::vector<std::string> converted_sources;
-        status convert_status = remap_spirv_stages(stages, converted_sources);
-        if (is_status_error(convert_status)) return convert_status;
-
-        status stages_compile_status = status_type::SUCCESS;
-        std::vector<GLuint> shader_stages;
-        for (u32 idx = 0; idx < stages.size(); idx++)
+        for (const shader_stage& stage : stages)
         {
-            const shader_stage& stage = stages[idx];
+            if (stage.program->api != graphics_api::GL45) return {status_type::INVALID, std::format("A provided shader program is non-GL45!")};
 
             const GLenum shader_type = gl_shader_type(stage.type);
-            if (shader_type == 0)
+            if (shader_type == 0) return {status_type::BACKEND_ERROR, "A provided shader stage is not supported on this API!"};
+            stage_types.push_back(shader_type);
+        }
+
+        use_cache = is_shader_cache_enabled();
+        const u64 sources_key = use_cache ? stages_content_hash(stages) : 0;
+        program_cache_key = use_cache ? fnv1a_hash_value(driver_content_hash(), sources_key) : 0;
+        if (use_cache && load_cached_program(program_cache_key)) return status_type::SUCCESS;
+
+        if (!async)
+        {
+            const status begin_status = begin_compile(load_or_remap_spirv_stages(stages, use_cache, sources_key));
+            if (is_status_error(begin_status)) return begin_status;
+            return finish_compile();
+        }
+
+        //The caller's shader programs may be deleted as soon as creation returns, so the worker gets its own copy of the SPIR-V.
+        std::vector<std::vector<u8>> spirv_copies;
+        std::vector<shader_stage_type> types;
+        for (const shader_stage& stage : stages)
+        {
+            const u8* spirv = static_cast<const u8*>(stage.program->data);
+            spirv_copies.emplace_back(spirv, spirv + stage.program->data_size);
+            types.push_back(stage.type);
+        }
+
+        state = compile_state::TRANSPILING;
+        pending_transpile = std::async(std::launch::async, [spirv_copies = std::move(spirv_copies), types = std::move(types), cached = use_cache, sources_key]
+        {
+            ZoneScopedN("[Stardraw] Transpile shader stages");
+            std::vector<shader_program> programs(spirv_copies.size());
+            std::vector<shader_stage> worker_stages;
+            for (u64 idx = 0; idx < spirv_copies.size(); idx++)
             {
-                stages_compile_status = {status_type::BACKEND_ERROR, "A provided shader stage is not supported on this API!"};
-                break;
+                programs[idx] = {const_cast<u8*>(spirv_copies[idx].data()), static_cast<u32>(spirv_copies[idx].size()), nullptr, nullptr, graphics_api::GL45};
+                worker_stages.push_back({types[idx], &programs[idx]});
             }
+            return load_or_remap_spirv_stages(worker_stages, cached, sources_key);
+        });
 
-            const std::string& source = converted_sources[idx];
-            GLuint compiled_stage;
-            const status compile_status = compile_shader_stage(source, shader_type, compiled_stage);
-            if (is_status_error(compile_status))
+        return status_type::PENDING;
+    }
+
+    shader_state::transpile_result shader_state::load_or_remap_spirv_stages(const std::vector<shader_stage>& stages, const bool use_cache, const u64 sources_key)
+    {
+        if (GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_gl_spirv)
+        {
+            transpile_result patched = patch_spirv_stages(stages);
+            if (patched.result.type != status_type::UNSUPPORTED) return patched;
+        }
+
+        transpile_result transpiled;
+        if (use_cache && load_cached_sources(sources_key, stages.size(), transpiled)) return transpiled;
+
+        transpiled = remap_spirv_stages(stages);
+        if (use_cache && !is_status_error(transpiled.result)) store_cached_sources(sources_key, transpiled);
+        return transpiled;
+    }
+
+    status shader_state::begin_compile(transpile_result&& transpiled)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Begin shader compile");
+        if (is_status_error(transpiled.result)) return fail_compile(transpiled.result);
+        descriptor_set_binding_offsets = std::move(transpiled.binding_offsets);
+        pending_fallback_spirv = std::move(transpiled.fallback_spirv);
+
+        pending_program = glCreateProgram();
+        if (pending_program == 0) return fail_compile({status_type::BACKEND_ERROR, "Creating shader failed (glCreateProgram)"});
+        if (use_cache) glProgramParameteri(pending_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+        const bool from_spirv = !transpiled.spirv_modules.empty();
+        const u64 stage_count = from_spirv ? transpiled.spirv_modules.size() : transpiled.sources.size();
+        for (u32 idx = 0; idx < stage_count; idx++)
+        {
+            const GLuint shader = glCreateShader(stage_types[idx]);
+            if (shader == 0) return fail_compile({status_type::BACKEND_ERROR, "Creating shader failed (glCreateShader)"});
+            pending_stages.push_back(shader);
+
+            if (from_spirv)
             {
-                stages_compile_status = compile_status;
-                break;
+                const std::vector<u32>& module = transpiled.spirv_modules[idx];
+                glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V, module.data(), static_cast<GLsizei>(module.size() * sizeof(u32)));
+                glSpecializeShader(shader, transpiled.entry_points[idx].c_str(), 0, nullptr, nullptr);
             }
+            else
+            {
+                const char* c_str = transpiled.sources[idx].c_str();
+                glShaderSource(shader, 1, &c_str, nullptr);
+                glCompileShader(shader);
+            }
+
+            glAttachShader(pending_program, shader);
+        }
+
+        glLinkProgram(pending_program);
+        state = compile_state::COMPILING;
+        return status_type::SUCCESS;
+    }
+
+    status shader_state::finish_compile()
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Finish shader compile");
+        for (const GLuint shader : pending_stages)
+        {
+            GLint success = GL_TRUE;
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+            if (success != GL_TRUE) return retry_through_glsl({status_type::BACKEND_ERROR, std::format("Shader stage compilation failed with error: \n {0}", get_shader_log(shader))});
+        }
+
+        GLint success = GL_TRUE;
+        glGetProgramiv(pending_program, GL_LINK_STATUS, &success);
+        if (success != GL_TRUE) return retry_through_glsl({status_type::BACKEND_ERROR, std::format("Shader validation failed with error: \n {0}", get_program_log(pending_program))});
+
+        shader_program_id = pending_program;
+        pending_program = 0;
+        pending_fallback_spirv.clear();
+        discard_pending_compile();
+        state = compile_state::READY;
+
+        if (use_cache) store_cached_program(program_cache_key);
+        return status_type::SUCCESS;
+    }
+
+    status shader_state::fail_compile(const status& failure)
+    {
+        discard_pending_compile();
+        state = compile_state::FAILED;
+        compile_failure = failure;
+        return failure;
+    }
+
+    status shader_state::retry_through_glsl(const status& failure)
+    {
+        if (pending_fallback_spirv.empty()) return fail_compile(failure);
+
+        //Drivers can reject SPIR-V the GLSL path handles fine, so a failed specialize or link gets one more go through SPIRV-Cross. This is rare, so it runs here rather than on a worker.
+        const std::vector<std::pair<shader_stage_type, std::vector<u8>>> spirv = std::move(pending_fallback_spirv);
+        pending_fallback_spirv.clear();
+        discard_pending_compile();
+
+        std::vector<shader_program> programs(spirv.size());
+        std::vector<shader_stage> fallback_stages;
+        for (u64 idx = 0; idx < spirv.size(); idx++)
+        {
+            const auto& [type, code] = spirv[idx];
+            programs[idx] = {const_cast<u8*>(code.data()), static_cast<u32>(code.size()), nullptr, nullptr, graphics_api::GL45};
+            fallback_stages.push_back({type, &programs[idx]});
+        }
+
+        const status begin_status = begin_compile(remap_spirv_stages(fallback_stages));
+        if (is_status_error(begin_status)) return begin_status;
+        return finish_compile();
+    }
+
+    void shader_state::discard_pending_compile()
+    {
+        for (const GLuint shader : pending_stages)
+        {
+            glDeleteShader(shader);
+        }
+        pending_stages.clear();
+
+        if (pending_program != 0) glDeleteProgram(pending_program);
+        pending_program = 0;
+    }
+
+    //Cache entries are flat u32 streams: the binding offsets first, then the payload.
+    static void append_cache_u32(std::vector<u8>& data, const u32 value)
+    {
+        const u8* bytes = reinterpret_cast<const u8*>(&value);
+        data.insert(data.end(), bytes, bytes + sizeof(u32));
+    }
 
-            shader_stages.push_back(compiled_stage);
+    static bool read_cache_u32(const std::vector<u8>& data, u64& offset, u32& out_value)
+    {
+        if (offset + sizeof(u32) > data.size()) return false;
+        memcpy(&out_value, data.data() + offset, sizeof(u32));
+        offset += sizeof(u32);
+        return true;
+    }
+
+    static bool read_cache_offsets(const std::vector<u8>& data, u64& offset, std::vector<u32>& out_offsets)
+    {
+        u32 count;
+        if (!read_cache_u32(data, offset, count)) return false;
+        out_offsets.resize(count);
+        for (u32& binding_offset : out_offsets)
+        {
+            if (!read_cache_u32(data, offset, binding_offset)) return false;
         }
+        return true;
+    }
 
-        if (is_status_error(stages_compile_status))
+    u64 shader_state::stages_content_hash(const std::vector<shader_stage>& stages)
+    {
+        //Transpiled sources have the push constant binding baked in.
+        u64 hash = fnv1a_hash_value(push_constant_binding, fnv1a_offset_basis);
+        for (const shader_stage& stage : stages)
         {
-            for (const GLuint& compiled_stage : shader_stages)
+            const u64 program_hash = stage.program->content_hash != 0 ? stage.program->content_hash : fnv1a_hash(stage.program->data, stage.program->data_size);
+            hash = fnv1a_hash_value(program_hash, fnv1a_hash_value(static_cast<u64>(stage.type), hash));
+        }
+        return hash;
+    }
+
+    u64 shader_state::driver_content_hash()
+    {
+        static const u64 hash = []
+        {
+            u64 driver_hash = fnv1a_offset_basis;
+            for (const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
             {
-                glDeleteShader(compiled_stage);
+                const GLubyte* value = glGetString(name);
+                if (value != nullptr) driver_hash = fnv1a_hash(reinterpret_cast<const char*>(value), driver_hash);
             }
+            return driver_hash;
+        }();
+        return hash;
+    }
+
+    bool shader_state::load_cached_program(const u64 key)
+    {
+        ZoneScoped;
+        std::vector<u8> data;
+        if (!read_shader_cache(key, "glprogram", data)) return false;
 
-            return stages_compile_status;
+        u64 offset = 0;
+        u32 binary_format;
+        std::vector<u32> binding_offsets;
+        if (!read_cache_u32(data, offset, binary_format) || !read_cache_offsets(data, offset, binding_offsets)) return false;
+
+        const GLuint program = glCreateProgram();
+        if (program == 0) return false;
+
+        //Drivers reject binaries they can no longer use (eg. after an update that didn't change the version string), in which case we fall back to compiling.
+        glProgramBinary(program, binary_format, data.data() + offset, static_cast<GLsizei>(data.size() - offset));
+        GLint success = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (success != GL_TRUE)
+        {
+            glDeleteProgram(program);
+            return false;
         }
 
-        GLuint shader_program;
-        status link_status = link_shader(shader_stages, shader_program);
+        shader_program_id = program;
+        descriptor_set_binding_offsets = std::move(binding_offsets);
+        return true;
+    }
+
+    void shader_state::store_cached_program(const u64 key) const
+    {
+        ZoneScoped;
+        GLint binary_length = 0;
+        glGetProgramiv(shader_program_id, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+        if (binary_length <= 0) return;
+
+        std::vector<u8> data;
+        append_cache_u32(data, 0);
+        append_cache_u32(data, descriptor_set_binding_offsets.size());
+        for (const u32 binding_offset : descriptor_set_binding_offsets) append_cache_u32(data, binding_offset);
+
+        const u64 header_size = data.size();
+        data.resize(header_size + binary_length);
+
+        GLenum binary_format = 0;
+        glGetProgramBinary(shader_program_id, binary_length, nullptr, &binary_format, data.data() + header_size);
+        memcpy(data.data(), &binary_format, sizeof(u32));
+
+        write_shader_cache(key, "glprogram", data.data(), data.size());
+    }
+
+    bool shader_state::load_cached_sources(const u64 key, const u64 stage_count, transpile_result& out_result)
+    {
+        ZoneScoped;
+        std::vector<u8> data;
+        if (!read_shader_cache(key, "glsl", data)) return false;
 
-        for (const GLuint shader : shader_stages)
+        u64 offset = 0;
+        std::vector<u32> binding_offsets;
+        u32 source_count;
+        if (!read_cache_offsets(data, offset, binding_offsets) || !read_cache_u32(data, offset, source_count) || source_count != stage_count) return false;
+
+        for (u32 idx = 0; idx < source_count; idx++)
         {
-            glDeleteShader(shader);
+            u32 length;
+            if (!read_cache_u32(data, offset, length) || offset + length > data.size()) return false;
+            out_result.sources.emplace_back(reinterpret_cast<const char*>(data.data() + offset), length);
+            offset += length;
         }
 
-        if (is_status_error(link_status)) return link_status;
+        out_result.binding_offsets = std::move(binding_offsets);
+        return true;
+    }
 
-        shader_program_id = shader_program;
+    void shader_state::store_cached_sources(const u64 key, const transpile_result& transpiled)
+    {
+        std::vector<u8> data;
+        append_cache_u32(data, transpiled.binding_offsets.size());
+        for (const u32 binding_offset : transpiled.binding_offsets) append_cache_u32(data, binding_offset);
 
-        return status_type::SUCCESS;
+        append_cache_u32(data, transpiled.sources.size());
+        for (const std::string& source : transpiled.sources)
+        {
+            append_cache_u32(data, source.size());
+            data.insert(data.end(), source.begin(), source.end());
+        }
+
+        write_shader_cache(key, "glsl", data.data(), data.size());
     }
 
     GLenum shader_state::gl_shader_type(const shader_stage_type stage)
@@ -128,13 +460,9 @@ namespace stardraw::gl45
         return 0;
     }
 
-    status shader_state::remap_spirv_stages(const std::vector<shader_stage>& stages, std::vector<std::string>& out_sources)
+    shader_state::transpile_result shader_state::remap_spirv_stages(const std::vector<shader_stage>& stages)
     {
-        for (const shader_stage& stage : stages)
-        {
-            if (stage.program->api != graphics_api::GL45) return {status_type::INVALID, std::format("A provided shader program is non-GL45!")};
-        }
-
+        transpile_result transpiled;
         struct stage_compiler
         {
             spirv_cross::CompilerGLSL compiler;
@@ -142,7 +470,6 @@ namespace stardraw::gl45
         };
 
         std::vector<stage_compiler*> stage_compilers;
-        status result_status = status_type::SUCCESS;
 
         constexpr spirv_cross::CompilerGLSL::Options options = spirv_cross::CompilerGLSL::Options {
             .version = 450,
@@ -181,23 +508,34 @@ namespace stardraw::gl45
                 }
             }
 
-            descriptor_set_binding_offsets.resize(bindings_per_set.size());
+            transpiled.binding_offsets.resize(bindings_per_set.size());
 
             u32 binding_offset = 0;
             for (u32 idx = 0; idx < bindings_per_set.size(); idx++)
             {
-                descriptor_set_binding_offsets[idx] = binding_offset;
+                transpiled.binding_offsets[idx] = binding_offset;
                 binding_offset += bindings_per_set[idx];
             }
 
+            if (binding_offset > push_constant_binding) transpiled.result = {status_type::UNSUPPORTED, std::format("Shader uses more bindings than fit below the push constant binding ({0})", push_constant_binding)};
+
             for (stage_compiler* stage : stage_compilers)
             {
+                if (is_status_error(transpiled.result)) break;
+
                 for (const spirv_cross::Resource& resource : stage->resources_with_binding_sets)
                 {
                     const u32 descriptor_set = stage->compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
                     const u32 binding_index = stage->compiler.get_decoration(resource.id, spv::DecorationBinding);
                     stage->compiler.unset_decoration(resource.id, spv::DecorationDescriptorSet);
-                    stage->compiler.set_decoration(resource.id, spv::DecorationBinding, binding_index + descriptor_set_binding_offsets[descriptor_set]);
+                    stage->compiler.set_decoration(resource.id, spv::DecorationBinding, binding_index + transpiled.binding_offsets[descriptor_set]);
+                }
+
+                //Push constant blocks become uniform blocks, fed from the context's push constant ring.
+                const spirv_cross::ShaderResources resources = stage->compiler.get_shader_resources();
+                for (const spirv_cross::Resource& push_constants : resources.push_constant_buffers)
+                {
+                    stage->compiler.set_decoration(push_constants.id, spv::DecorationBinding, push_constant_binding);
                 }
 
                 //Handle merging sampler states with samplers where possible, transfer binding and name from original sampler.
@@ -215,16 +553,16 @@ namespace stardraw::gl45
                 const std::string source = stage->compiler.compile();
                 if (source.empty())
                 {
-                    result_status = {status_type::BACKEND_ERROR, "Failed to transpile SPIR-V into OpenGL compatible GLSL"};
+                    transpiled.result = {status_type::BACKEND_ERROR, "Failed to transpile SPIR-V into OpenGL compatible GLSL"};
                     break;
                 }
 
-                out_sources.push_back(source);
+                transpiled.sources.push_back(source);
             }
         }
         catch (std::exception& _)
         {
-            result_status = {status_type::BACKEND_ERROR, "Failed to transpile SPIR-V into OpenGL compatible GLSL"};
+            transpiled.result = {status_type::BACKEND_ERROR, "Failed to transpile SPIR-V into OpenGL compatible GLSL"};
         }
 
         for (const stage_compiler* stage : stage_compilers)
@@ -232,58 +570,142 @@ namespace stardraw::gl45
             delete stage;
         }
 
-        return result_status;
+        return transpiled;
     }
 
-    status shader_state::link_shader(const std::vector<GLuint>& stages, GLuint& out_shader_id)
+    //The handful of SPIR-V opcodes and enums needed to patch bindings without a full parser.
+    namespace spirv_patch
     {
-        const GLuint program = glCreateProgram();
-        if (program == 0) return {status_type::BACKEND_ERROR, "Creating shader failed (glCreateProgram)"};
+        constexpr u32 magic_number = 0x07230203;
+        constexpr u32 header_words = 5;
+        constexpr u32 op_entry_point = 15;
+        constexpr u32 op_type_sampler = 26;
+        constexpr u32 op_variable = 59;
+        constexpr u32 op_decorate = 71;
+        constexpr u32 decoration_binding = 33;
+        constexpr u32 decoration_descriptor_set = 34;
+        constexpr u32 storage_class_push_constant = 9;
+
+        inline u32 opcode(const u32 word) { return word & 0xFFFF; }
+        inline u32 word_count(const u32 word) { return word >> 16; }
+    }
 
-        for (const GLuint shader : stages)
+    shader_state::transpile_result shader_state::patch_spirv_stages(const std::vector<shader_stage>& stages)
+    {
+        ZoneScoped;
+        using namespace spirv_patch;
+        transpile_result patched;
+        const auto fail = [](status failure)
         {
-            if (shader != 0)
-                glAttachShader(program, shader);
-        }
-
-        glLinkProgram(program);
+            transpile_result failed;
+            failed.result = std::move(failure);
+            return failed;
+        };
 
-        GLint success = GL_TRUE;
-        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        struct stage_bindings
+        {
+            std::unordered_map<u32, u32> descriptor_sets; //Result id -> descriptor set
+        };
+        std::vector<stage_bindings> bindings(stages.size());
+        std::vector<u32> bindings_per_set;
 
-        if (success != GL_TRUE)
+        //The SPIR-V version isn't checked - many drivers take newer modules than GL requires, and the ones that don't fail the specialize, which retries through GLSL.
+        //First pass: validate, find entry points and work out how many bindings each descriptor set needs across every stage.
+        for (u64 stage_idx = 0; stage_idx < stages.size(); stage_idx++)
         {
-            glDeleteProgram(program);
-            return {status_type::BACKEND_ERROR, std::format("Shader validation failed with error: \n {0}", get_program_log(program))};
-        }
+            const u32* words = static_cast<const u32*>(stages[stage_idx].program->data);
+            const u64 total_words = stages[stage_idx].program->data_size / sizeof(u32);
+            if (total_words < header_words || words[0] != magic_number) return fail({status_type::INVALID, "Shader program does not contain valid SPIR-V"});
 
-        out_shader_id = program;
+            std::unordered_map<u32, u32> binding_indexes;
+            std::string entry_point;
+            for (u64 word = header_words; word < total_words;)
+            {
+                const u32 count = word_count(words[word]);
+                if (count == 0 || word + count > total_words) return fail({status_type::INVALID, "Shader program contains malformed SPIR-V"});
 
-        return status_type::SUCCESS;
-    }
+                switch (opcode(words[word]))
+                {
+                    //GL has no separate samplers, and wants push constants as uniform blocks - both need the GLSL path's rewrites.
+                    case op_type_sampler: return fail({status_type::UNSUPPORTED, "Separate samplers need combining through the GLSL path"});
+                    case op_variable:
+                    {
+                        if (count >= 4 && words[word + 3] == storage_class_push_constant) return fail({status_type::UNSUPPORTED, "Push constants need converting through the GLSL path"});
+                        break;
+                    }
+                    case op_entry_point:
+                    {
+                        if (entry_point.empty() && count > 3) entry_point = reinterpret_cast<const char*>(&words[word + 3]);
+                        break;
+                    }
+                    case op_decorate:
+                    {
+                        if (count < 4) break;
+                        if (words[word + 2] == decoration_descriptor_set) bindings[stage_idx].descriptor_sets[words[word + 1]] = words[word + 3];
+                        if (words[word + 2] == decoration_binding) binding_indexes[words[word + 1]] = words[word + 3];
+                        break;
+                    }
+                    default: break;
+                }
 
-    status shader_state::compile_shader_stage(const std::string& source, const GLuint type, GLuint& out_shader_id)
-    {
-        const GLuint shader = glCreateShader(type);
-        if (shader == 0) return {status_type::BACKEND_ERROR, "Creating shader failed (glCreateShader)"};
+                word += count;
+            }
 
-        const char* c_str = source.c_str();
-        glShaderSource(shader, 1, &c_str, nullptr);
-        glCompileShader(shader);
+            if (entry_point.empty()) return fail({status_type::INVALID, "Shader program SPIR-V has no entry point"});
+            patched.entry_points.push_back(entry_point);
 
-        GLint success = GL_TRUE;
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+            for (const auto& [id, descriptor_set] : bindings[stage_idx].descriptor_sets)
+            {
+                if (descriptor_set >= bindings_per_set.size()) bindings_per_set.resize(descriptor_set + 1);
+                bindings_per_set[descriptor_set] = std::max(bindings_per_set[descriptor_set], binding_indexes[id] + 1);
+            }
+        }
 
-        if (success != GL_TRUE)
+        patched.binding_offsets.resize(bindings_per_set.size());
+        u32 binding_offset = 0;
+        for (u32 idx = 0; idx < bindings_per_set.size(); idx++)
         {
-            const std::string log = get_shader_log(shader);
-            glDeleteShader(shader);
-            return {status_type::BACKEND_ERROR, std::format("Shader stage compilation failed with error: \n {0}", log)};
+            patched.binding_offsets[idx] = binding_offset;
+            binding_offset += bindings_per_set[idx];
         }
 
-        out_shader_id = shader;
+        //Second pass: copy each module, offsetting bindings by their set's base and dropping the descriptor set decorations.
+        for (u64 stage_idx = 0; stage_idx < stages.size(); stage_idx++)
+        {
+            const u32* words = static_cast<const u32*>(stages[stage_idx].program->data);
+            const u64 total_words = stages[stage_idx].program->data_size / sizeof(u32);
+            const std::unordered_map<u32, u32>& descriptor_sets = bindings[stage_idx].descriptor_sets;
 
-        return status_type::SUCCESS;
+            const u8* spirv = static_cast<const u8*>(stages[stage_idx].program->data);
+            patched.fallback_spirv.emplace_back(stages[stage_idx].type, std::vector<u8>(spirv, spirv + stages[stage_idx].program->data_size));
+
+            std::vector<u32>& module = patched.spirv_modules.emplace_back();
+            module.reserve(total_words);
+            module.insert(module.end(), words, words + header_words);
+
+            for (u64 word = header_words; word < total_words;)
+            {
+                const u32 count = word_count(words[word]);
+                const bool is_decorate = opcode(words[word]) == op_decorate && count >= 4;
+
+                if (is_decorate && words[word + 2] == decoration_descriptor_set)
+                {
+                    word += count;
+                    continue;
+                }
+
+                const u64 start = module.size();
+                module.insert(module.end(), words + word, words + word + count);
+                if (is_decorate && words[word + 2] == decoration_binding && descriptor_sets.contains(words[word + 1]))
+                {
+                    module[start + 3] += patched.binding_offsets[descriptor_sets.at(words[word + 1])];
+                }
+
+                word += count;
+            }
+        }
+
+        return patched;
     }
 
     status shader_state::validate_program(const GLuint program)
@@ -1,5 +1,6 @@
 #pragma once
 #include <format>
+#include <future>
 #include <queue>
 #include <unordered_map>
 
@@ -23,23 +24,68 @@ namespace stardraw::gl45
         ~shader_state() override;
 
         [[nodiscard]] bool is_valid() const;
+        [[nodiscard]] bool is_pending() const;
+
+        //Advances an asynchronous compile without blocking. Returns PENDING until the program is ready, then SUCCESS, or the error the compile failed with.
+        [[nodiscard]] status poll_compile();
+
+        //Enables the driver's background compiler threads, if it has them. Called once per context.
+        static void configure_parallel_compile();
 
         [[nodiscard]] status make_active() const;
         [[nodiscard]] status upload_parameter(const shader_parameter& parameter);
+        [[nodiscard]] bool uses_program(const shader_program* program) const;
+        //Locations found before a program was hot reloaded point at its old reflection, and are remapped onto the stage that has the same parameter.
+        [[nodiscard]] shader_parameter_location relocate_parameter(const shader_parameter_location& location) const;
         void clear_parameters();
         [[nodiscard]] descriptor_type object_type() const override;
 
         std::vector<u32> descriptor_set_binding_offsets;
         std::vector<shader_parameter> parameter_store;
         std::unordered_map<u32, std::string> bound_objects;
+        std::string fallback_shader;
+        //Kept so the shader can be rebuilt when its programs are hot reloaded.
+        std::vector<shader_stage> stages;
     private:
-        [[nodiscard]] status create_from_stages(const std::vector<shader_stage>& stages);
+        enum class compile_state : u8
+        {
+            TRANSPILING, COMPILING, READY, FAILED
+        };
+
+        //Either GLSL sources, or (with ARB_gl_spirv) patched SPIR-V modules and their entry point names.
+        struct transpile_result
+        {
+            status result = status_type::SUCCESS;
+            std::vector<std::string> sources;
+            std::vector<std::vector<u32>> spirv_modules;
+            std::vector<std::string> entry_points;
+            std::vector<u32> binding_offsets;
+            //The unpatched SPIR-V, kept so the GLSL path can be tried if the driver rejects the patched modules.
+            std::vector<std::pair<shader_stage_type, std::vector<u8>>> fallback_spirv;
+        };
+
+        [[nodiscard]] status create_from_stages(const std::vector<shader_stage>& stages, const bool async);
 
         [[nodiscard]] static GLenum gl_shader_type(shader_stage_type stage);
-        [[nodiscard]] status remap_spirv_stages(const std::vector<shader_stage>& stages, std::vector<std::string>& out_sources);
+        [[nodiscard]] static transpile_result remap_spirv_stages(const std::vector<shader_stage>& stages);
+        //Applies the same binding remap by rewriting SPIR-V decorations, for drivers that accept SPIR-V directly. UNSUPPORTED if the stages use features GL SPIR-V lacks.
+        [[nodiscard]] static transpile_result patch_spirv_stages(const std::vector<shader_stage>& stages);
+        [[nodiscard]] static transpile_result load_or_remap_spirv_stages(const std::vector<shader_stage>& stages, const bool use_cache, const u64 sources_key);
 
-        [[nodiscard]] static status link_shader(const std::vector<GLuint>& stages, GLuint& out_shader_id);
-        [[nodiscard]] static status compile_shader_stage(const std::string& source, const GLuint type, GLuint& out_shader_id);
+        //Shader cache steps. Program binaries are driver specific, transpiled GLSL only depends on the SPIR-V.
+        [[nodiscard]] static u64 stages_content_hash(const std::vector<shader_stage>& stages);
+        [[nodiscard]] static u64 driver_content_hash();
+        [[nodiscard]] bool load_cached_program(const u64 key);
+        void store_cached_program(const u64 key) const;
+        [[nodiscard]] static bool load_cached_sources(const u64 key, const u64 stage_count, transpile_result& out_result);
+        static void store_cached_sources(const u64 key, const transpile_result& transpiled);
+
+        //Compilation is split so the driver can work on it in the background: begin issues the compile and link without querying anything, finish checks the results.
+        [[nodiscard]] status begin_compile(transpile_result&& transpiled);
+        [[nodiscard]] status finish_compile();
+        [[nodiscard]] status fail_compile(const status& failure);
+        [[nodiscard]] status retry_through_glsl(const status& failure);
+        void discard_pending_compile();
 
         [[nodiscard]] static status validate_program(const GLuint program);
 
@@ -47,5 +93,15 @@ namespace stardraw::gl45
         [[nodiscard]] static std::string get_program_log(const GLuint program);
 
         GLuint shader_program_id = 0;
+
+        compile_state state = compile_state::READY;
+        status compile_failure = status_type::SUCCESS;
+        std::future<transpile_result> pending_transpile;
+        std::vector<GLenum> stage_types;
+        std::vector<GLuint> pending_stages;
+        GLuint pending_program = 0;
+        std::vector<std::pair<shader_stage_type, std::vector<u8>>> pending_fallback_spirv;
+        bool use_cache = false;
+        u64 program_cache_key = 0;
     };
 }
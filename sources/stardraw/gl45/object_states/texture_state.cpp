@@ -246,6 +246,17 @@ namespace stardraw::gl45
             }
         }
 
+        //Non-array cubemaps still allocate all six faces.
+        const u64 layer_count = (shape == texture_shape::CUBE_MAP && num_texture_array_layers < 6) ? 6 : std::max(num_texture_array_layers, 1u);
+        for (u32 level = 0; level < num_texture_mipmap_levels; level++)
+        {
+            const u64 level_width = std::max(width >> level, 1u);
+            const u64 level_height = shape == texture_shape::_1D ? 1 : std::max(height >> level, 1u);
+            const u64 level_depth = shape == texture_shape::_3D ? std::max(depth >> level, 1u) : 1;
+            allocated_bytes += level_width * level_height * level_depth * bytes_per_pixel;
+        }
+        allocated_bytes *= layer_count * std::max(num_texture_msaa_samples, 1u);
+
         texture_sampling_conifg sampling_config = desc.default_sampling_config;
         sampling_config.mipmap_max_level = std::min(sampling_config.mipmap_max_level, num_texture_mipmap_levels - 1);
         out_status = set_sampling_config(sampling_config);
@@ -289,7 +300,7 @@ namespace stardraw::gl45
         glDeleteTextures(1, &gl_texture_id);
     }
 
-    status texture_state::unpack_pixels(const u32 mipmap_level, const u32 x, const u32 y, const u32 z, const u32 width, const u32 height, const u32 depth, const GLenum format, const GLenum gl_data_type) const
+    status texture_state::unpack_pixels(const u32 mipmap_level, const u32 x, const u32 y, const u32 z, const u32 width, const u32 height, const u32 depth, const GLenum format, const GLenum gl_data_type, const u64 buffer_address) const
     {
         texture_shape effective_shape = shape;
         if (num_texture_array_layers > 1 && shape == texture_shape::_1D) effective_shape = texture_shape::_2D;
@@ -301,25 +312,36 @@ namespace stardraw::gl45
         {
             case texture_shape::_1D:
             {
-                glTextureSubImage1D(gl_texture_id, mipmap_level, x, width, format, gl_data_type, nullptr);
+                glTextureSubImage1D(gl_texture_id, mipmap_level, x, width, format, gl_data_type, reinterpret_cast<void*>(buffer_address));
                 break;
             }
             case texture_shape::_2D:
             {
-                glTextureSubImage2D(gl_texture_id, mipmap_level, x, y, width, height, format, gl_data_type, nullptr);
+                glTextureSubImage2D(gl_texture_id, mipmap_level, x, y, width, height, format, gl_data_type, reinterpret_cast<void*>(buffer_address));
                 break;
             }
             case texture_shape::_3D:
             case texture_shape::CUBE_MAP:
             {
-                glTextureSubImage3D(gl_texture_id, mipmap_level, x, y, z, width, height, depth, format, gl_data_type, nullptr);
+                glTextureSubImage3D(gl_texture_id, mipmap_level, x, y, z, width, height, depth, format, gl_data_type, reinterpret_cast<void*>(buffer_address));
                 break;
             }
         }
         return status_type::SUCCESS;
     }
 
-    status texture_state::copy_pixels(const texture_state* read_texture, const texture_copy_info& copy_info) const
+    status texture_state::pack_pixels(const u32 mipmap_level, const u32 x, const u32 y, const u32 z, const u32 width, const u32 height, const u32 depth, const GLenum format, const GLenum gl_data_type, const u64 buffer_address, const u64 bytes) const
+    {
+        //Readbacks are tightly packed. The previous alignment is restored so other pack operations aren't affected.
+        GLint previous_alignment = 4;
+        glGetIntegerv(GL_PACK_ALIGNMENT, &previous_alignment);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glGetTextureSubImage(gl_texture_id, mipmap_level, x, y, z, width, height, depth, format, gl_data_type, bytes, reinterpret_cast<void*>(buffer_address));
+        glPixelStorei(GL_PACK_ALIGNMENT, previous_alignment);
+        return status_type::SUCCESS;
+    }
+
+    status texture_state::validate_copy(const texture_state* read_texture, const texture_copy_info& copy_info) const
     {
         if (!is_view_format_compatible(gl_texture_format, read_texture->gl_texture_format)) return {status_type::INVALID, "Can't transfer between textures; incompatible data formats"};
         if (!is_view_target_compatible(gl_texture_target, read_texture->gl_texture_target)) return {status_type::INVALID, "Can't transfer between textures; incompatible texture shapes"};
@@ -349,15 +371,27 @@ namespace stardraw::gl45
         if (copy_info.read_mipmap_level >= read_texture->num_texture_mipmap_levels) return {status_type::RANGE_OVERFLOW, "Texture copy mipmap level is outside the bounds of the read texture"};
         if (copy_info.write_mipmap_level >= num_texture_mipmap_levels) return {status_type::RANGE_OVERFLOW, "Texture copy mipmap level is outside the bounds of the write texture"};
 
-        if (copy_info.read_layer + copy_info.copy_layers >= read_texture->num_texture_array_layers) return {status_type::RANGE_OVERFLOW, "Texture copy array layers are outside the bounds of the read texture"};
-        if (copy_info.write_layer + copy_info.copy_layers >= num_texture_array_layers) return {status_type::RANGE_OVERFLOW, "Texture copy array layers are outside the bounds of the write texture"};
+        if (copy_info.read_layer + copy_info.copy_layers > read_texture->num_texture_array_layers) return {status_type::RANGE_OVERFLOW, "Texture copy array layers are outside the bounds of the read texture"};
+        if (copy_info.write_layer + copy_info.copy_layers > num_texture_array_layers) return {status_type::RANGE_OVERFLOW, "Texture copy array layers are outside the bounds of the write texture"};
+
+        return status_type::SUCCESS;
+    }
+
+    status texture_state::copy_pixels(const texture_state* read_texture, const texture_copy_info& copy_info) const
+    {
+        const u32 read_x = copy_info.read_x;
+        const u32 read_y = copy_info.read_y;
+        const u32 read_z = copy_info.read_z;
+        const u32 write_x = copy_info.write_x;
+        const u32 write_y = copy_info.write_y;
+        const u32 write_z = copy_info.write_z;
 
         switch (read_texture->shape)
         {
             case texture_shape::_1D: //Copy between 1D textures (or 1D texture arrays)
             {
                 glCopyImageSubData(read_texture->gl_texture_id, read_texture->gl_texture_target, copy_info.read_mipmap_level, read_x, copy_info.read_layer, 0,
-                                   gl_texture_id, gl_texture_target, copy_info.write_mipmap_level, write_x, copy_info.write_layer, 0, copy_info.copy_width, copy_info.copy_layers, 0);
+                                   gl_texture_id, gl_texture_target, copy_info.write_mipmap_level, write_x, copy_info.write_layer, 0, copy_info.copy_width, copy_info.copy_layers, 1);
                 break;
             }
             case texture_shape::_2D: //Copy between 2D textures (or 2D texture arrays. Cubemaps are a special kind of 2D texture array)
@@ -378,6 +412,31 @@ namespace stardraw::gl45
         return status_type::SUCCESS;
     }
 
+    texture_state::transfer_extent texture_state::effective_transfer_extent(const texture_memory_transfer_info& info) const
+    {
+        transfer_extent extent = {info.x, info.y, info.z, info.width, info.height, info.depth};
+        switch (shape)
+        {
+            case texture_shape::_1D:
+            {
+                extent.y = info.layer;
+                extent.height = info.layers;
+                extent.z = 0;
+                extent.depth = 1;
+                break;
+            }
+            case texture_shape::_2D:
+            case texture_shape::CUBE_MAP:
+            {
+                extent.z = info.layer;
+                extent.depth = info.layers;
+                break;
+            }
+            case texture_shape::_3D: break;
+        }
+        return extent;
+    }
+
     u64 texture_state::compute_bytes_in_transfer(const texture_memory_transfer_info& info) const
     {
         switch (shape)
@@ -476,21 +535,29 @@ namespace stardraw::gl45
         }
     }
 
-    status texture_state::prepare_upload(const texture_memory_transfer_info& info, memory_transfer_handle** out_handle) const
+    status texture_state::validate_transfer(const texture_memory_transfer_info& info) const
     {
-        ZoneScoped;
-        TracyGpuZone("[Stardraw] Prepare texture upload");
-
         if (info.x + info.width > size.x || info.y + info.height > size.y || info.z + info.depth > size.z)
         {
-            return {status_type::RANGE_OVERFLOW, "Texture upload dimensions outside the bounds of the texture"};
+            return {status_type::RANGE_OVERFLOW, "Texture transfer dimensions outside the bounds of the texture"};
         }
 
-        if (info.mipmap_level >= num_texture_mipmap_levels) return {status_type::RANGE_OVERFLOW, "Texture upload mipmap level is outside the bounds of the texture"};
-        if (info.layer + info.layers > num_texture_array_layers || info.layers < 1) return {status_type::RANGE_OVERFLOW, "Texture upload array layers are outside the bounds of the texture"};
+        if (info.mipmap_level >= num_texture_mipmap_levels) return {status_type::RANGE_OVERFLOW, "Texture transfer mipmap level is outside the bounds of the texture"};
+        if (info.layer + info.layers > num_texture_array_layers || info.layers < 1) return {status_type::RANGE_OVERFLOW, "Texture transfer array layers are outside the bounds of the texture"};
+
+        if (info.channels == texture_memory_transfer_info::pixel_channels::STENCIL && !does_texture_data_type_have_stencil(data_type)) return {status_type::INVALID, "Texture transfer channels is set to stencil, but this texture does not contain stencil data!"};
+        if (info.channels == texture_memory_transfer_info::pixel_channels::DEPTH && !does_texture_data_type_have_depth(data_type)) return {status_type::INVALID, "Texture transfer channels is set to depth, but this texture does not contain depth data!"};
+
+        return status_type::SUCCESS;
+    }
+
+    status texture_state::prepare_upload(const texture_memory_transfer_info& info, memory_transfer_handle** out_handle) const
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Prepare texture upload");
 
-        if (info.channels == texture_memory_transfer_info::pixel_channels::STENCIL && !does_texture_data_type_have_stencil(data_type)) return {status_type::INVALID, "Texture upload channels is set to stencil, but this texture does not contain stencil data!"};
-        if (info.channels == texture_memory_transfer_info::pixel_channels::DEPTH && !does_texture_data_type_have_depth(data_type)) return {status_type::INVALID, "Texture upload channels is set to depth, but this texture does not contain depth data!"};
+        const status validation_status = validate_transfer(info);
+        if (is_status_error(validation_status)) return validation_status;
 
         GLuint temp_buffer;
         glCreateBuffers(1, &temp_buffer);
@@ -543,6 +610,58 @@ namespace stardraw::gl45
         return -1;
     }
 
+    texture_memory_transfer_info transfer_info_for_buffer_copy(const texture_buffer_copy_info& copy_info)
+    {
+        texture_memory_transfer_info info;
+        info.x = copy_info.x;
+        info.y = copy_info.y;
+        info.z = copy_info.z;
+        info.width = copy_info.width;
+        info.height = copy_info.height;
+        info.depth = copy_info.depth;
+        info.mipmap_level = copy_info.mipmap_level;
+        info.layer = copy_info.layer;
+        info.layers = copy_info.layers;
+        info.data_type = copy_info.data_type;
+        info.channels = copy_info.channels;
+        return info;
+    }
+
+    u64 texture_state::buffer_copy_bytes(const texture_buffer_copy_info& copy_info) const
+    {
+        return compute_bytes_in_transfer(transfer_info_for_buffer_copy(copy_info));
+    }
+
+    status texture_state::unpack_from_buffer(const texture_buffer_copy_info& copy_info, const GLuint buffer_id, const u64 buffer_address, const u64 buffer_bytes) const
+    {
+        const texture_memory_transfer_info info = transfer_info_for_buffer_copy(copy_info);
+        const status validation_status = validate_transfer(info);
+        if (is_status_error(validation_status)) return validation_status;
+        if (compute_bytes_in_transfer(info) > buffer_bytes) return {status_type::RANGE_OVERFLOW, "Texture copy reads past the end of the source buffer"};
+
+        const transfer_extent extent = effective_transfer_extent(info);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer_id);
+        const status unpack_status = unpack_pixels(info.mipmap_level, extent.x, extent.y, extent.z, extent.width, extent.height, extent.depth, gl_channels_format(info.channels), gl_memory_transfer_data_type(info.data_type), buffer_address);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return unpack_status;
+    }
+
+    status texture_state::pack_to_buffer(const texture_buffer_copy_info& copy_info, const GLuint buffer_id, const u64 buffer_address, const u64 buffer_bytes) const
+    {
+        const texture_memory_transfer_info info = transfer_info_for_buffer_copy(copy_info);
+        const status validation_status = validate_transfer(info);
+        if (is_status_error(validation_status)) return validation_status;
+
+        const u64 bytes = compute_bytes_in_transfer(info);
+        if (bytes > buffer_bytes) return {status_type::RANGE_OVERFLOW, "Texture copy writes past the end of the destination buffer"};
+
+        const transfer_extent extent = effective_transfer_extent(info);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer_id);
+        const status pack_status = pack_pixels(info.mipmap_level, extent.x, extent.y, extent.z, extent.width, extent.height, extent.depth, gl_channels_format(info.channels), gl_memory_transfer_data_type(info.data_type), buffer_address, bytes);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return pack_status;
+    }
+
     status texture_state::flush_upload(const texture_memory_transfer_info& info, memory_transfer_handle* handle) const
     {
         ZoneScoped;
@@ -550,13 +669,74 @@ namespace stardraw::gl45
         const gl_memory_transfer_handle* gl_handle = dynamic_cast<gl_memory_transfer_handle*>(handle);
         if (gl_handle == nullptr) return {status_type::INVALID, "Invalid memory transfer handle cast - this is an internal bug!"};
         glUnmapNamedBuffer(gl_handle->transfer_buffer_id);
-        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, gl_handle->transfer_buffer_id);
-        status unpack_status = unpack_pixels(info.mipmap_level, info.x, info.y, info.z, info.width, info.height, info.depth, gl_channels_format(info.channels), gl_memory_transfer_data_type(info.data_type));
+        status unpack_status = unpack_slices(info, gl_handle->transfer_buffer_id, 0, transfer_slice_count(info));
         glDeleteBuffers(1, &gl_handle->transfer_buffer_id);
         delete handle;
         return unpack_status;
     }
 
+    u64 texture_state::transfer_slice_count(const texture_memory_transfer_info& info) const
+    {
+        const transfer_extent extent = effective_transfer_extent(info);
+        if (extent.depth > 1) return extent.depth;
+        if (extent.height > 1) return extent.height;
+        return 1;
+    }
+
+    u64 texture_state::transfer_byte_count(const texture_memory_transfer_info& info) const
+    {
+        return compute_bytes_in_transfer(info);
+    }
+
+    status texture_state::unpack_slices(const texture_memory_transfer_info& info, const GLuint staging_buffer_id, const u64 first_slice, const u64 slice_count) const
+    {
+        const u64 total_slices = transfer_slice_count(info);
+        if (first_slice + slice_count > total_slices) return {status_type::RANGE_OVERFLOW, "Texture upload slices are outside the bounds of the transfer"};
+
+        transfer_extent extent = effective_transfer_extent(info);
+        const u64 slice_bytes = compute_bytes_in_transfer(info) / total_slices;
+        if (extent.depth > 1)
+        {
+            extent.z += first_slice;
+            extent.depth = slice_count;
+        }
+        else if (extent.height > 1)
+        {
+            extent.y += first_slice;
+            extent.height = slice_count;
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging_buffer_id);
+        const status unpack_status = unpack_pixels(info.mipmap_level, extent.x, extent.y, extent.z, extent.width, extent.height, extent.depth, gl_channels_format(info.channels), gl_memory_transfer_data_type(info.data_type), first_slice * slice_bytes);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return unpack_status;
+    }
+
+    status texture_state::prepare_download(const texture_memory_transfer_info& info, staging_buffer_downloader& downloader, memory_transfer_handle** out_handle) const
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Prepare texture download");
+
+        const status validation_status = validate_transfer(info);
+        if (is_status_error(validation_status)) return validation_status;
+
+        const u64 bytes = compute_bytes_in_transfer(info);
+
+        gl_memory_transfer_handle* handle = nullptr;
+        const status allocate_status = downloader.allocate_download(bytes, info.ready_callback, &handle);
+        if (is_status_error(allocate_status)) return allocate_status;
+
+        const transfer_extent extent = effective_transfer_extent(info);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, handle->transfer_buffer_id);
+        const status pack_status = pack_pixels(info.mipmap_level, extent.x, extent.y, extent.z, extent.width, extent.height, extent.depth, gl_channels_format(info.channels), gl_memory_transfer_data_type(info.data_type), handle->transfer_buffer_address, bytes);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        staging_buffer_downloader::fence_download(handle);
+
+        *out_handle = handle;
+        return pack_status;
+    }
+
     GLenum gl_filter_mode_from_modes(const texture_filtering_mode filter, const texture_filtering_mode mipmap_selection, const bool with_mipmaps)
     {
         if (!with_mipmaps)
@@ -778,4 +958,9 @@ namespace stardraw::gl45
     {
         return shape;
     }
+
+    u64 texture_state::memory_usage() const
+    {
+        return allocated_bytes;
+    }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../gl_headers.hpp"
+#include "../staging_buffer_downloader.hpp"
 #include "../types.hpp"
 #include "stardraw/api/commands.hpp"
 #include "starlib/math/glm.hpp"
@@ -16,12 +17,28 @@ namespace stardraw::gl45
         explicit texture_state(const texture_state* original, const texture_descriptor& desc, status& out_status);
         ~texture_state() override;
 
-        [[nodiscard]] status unpack_pixels(const u32 mipmap_level, const u32 x, const u32 y, const u32 z, const u32 width, const u32 height, const u32 depth, const GLenum format, const GLenum gl_data_type) const;
+        [[nodiscard]] status unpack_pixels(const u32 mipmap_level, const u32 x, const u32 y, const u32 z, const u32 width, const u32 height, const u32 depth, const GLenum format, const GLenum gl_data_type, const u64 buffer_address = 0) const;
+        [[nodiscard]] status pack_pixels(const u32 mipmap_level, const u32 x, const u32 y, const u32 z, const u32 width, const u32 height, const u32 depth, const GLenum format, const GLenum gl_data_type, const u64 buffer_address, const u64 bytes) const;
+        //The region must already have passed validate_copy.
         [[nodiscard]] status copy_pixels(const texture_state* read_texture, const texture_copy_info& copy_info) const;
+        //Checks a copy region against both textures without issuing the copy, so batched copies can be rejected before any of them run.
+        [[nodiscard]] status validate_copy(const texture_state* read_texture, const texture_copy_info& copy_info) const;
+
+        //GPU-side copies between the texture and pixels in a buffer. buffer_address is relative to buffer_id, and buffer_bytes is how much of it is available from there.
+        [[nodiscard]] status unpack_from_buffer(const texture_buffer_copy_info& copy_info, const GLuint buffer_id, const u64 buffer_address, const u64 buffer_bytes) const;
+        [[nodiscard]] status pack_to_buffer(const texture_buffer_copy_info& copy_info, const GLuint buffer_id, const u64 buffer_address, const u64 buffer_bytes) const;
+        [[nodiscard]] u64 buffer_copy_bytes(const texture_buffer_copy_info& copy_info) const;
 
         [[nodiscard]] status prepare_upload(const texture_memory_transfer_info& info, memory_transfer_handle** out_handle) const;
         [[nodiscard]] status flush_upload(const texture_memory_transfer_info& info, memory_transfer_handle* handle) const;
 
+        //Uploads are split along their outermost axis (rows, slices or layers) so they can be spread over several frames.
+        [[nodiscard]] u64 transfer_slice_count(const texture_memory_transfer_info& info) const;
+        [[nodiscard]] u64 transfer_byte_count(const texture_memory_transfer_info& info) const;
+        [[nodiscard]] status unpack_slices(const texture_memory_transfer_info& info, const GLuint staging_buffer_id, const u64 first_slice, const u64 slice_count) const;
+
+        [[nodiscard]] status prepare_download(const texture_memory_transfer_info& info, staging_buffer_downloader& downloader, memory_transfer_handle** out_handle) const;
+
         [[nodiscard]] bool is_valid() const;
         [[nodiscard]] status bind_to_texture_slot(u32 slot) const;
         [[nodiscard]] status bind_to_image_slot(u32 slot, u32 mipmap_level, u32 array_layer, bool entire_array, shader_parameter_value::image_texture_access access) const;
@@ -31,13 +48,25 @@ namespace stardraw::gl45
         [[nodiscard]] status set_sampling_config(const texture_sampling_conifg& config) const;
 
         [[nodiscard]] texture_shape get_shape() const;
+        //Texture views share their original's storage and report zero.
+        [[nodiscard]] u64 memory_usage() const override;
         [[nodiscard]] descriptor_type object_type() const override
         {
             return descriptor_type::TEXTURE;
         }
 
     private:
+        struct transfer_extent
+        {
+            u32 x, y, z;
+            u32 width, height, depth;
+        };
+
+        //Array layers (and cubemap faces) are addressed through the axis after the last real one.
+        [[nodiscard]] transfer_extent effective_transfer_extent(const texture_memory_transfer_info& info) const;
+
         u64 compute_bytes_in_transfer(const texture_memory_transfer_info& info) const;
+        status validate_transfer(const texture_memory_transfer_info& info) const;
         status initalize_and_validate_texture_descriptor(const texture_descriptor& desc);
 
         GLuint gl_texture_id = 0;
@@ -49,6 +78,7 @@ namespace stardraw::gl45
         u32 num_texture_array_layers;
         u32 num_texture_msaa_samples;
         u32 bytes_per_pixel;
+        u64 allocated_bytes = 0;
 
         texture_shape shape;
         texture_data_type data_type;
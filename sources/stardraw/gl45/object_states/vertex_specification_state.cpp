@@ -21,9 +21,9 @@ namespace stardraw::gl45
     {
         ZoneScoped;
         if (vertex_array_id == 0) return false;
-        for (const GLuint buffer : vertex_buffers)
+        for (const vertex_buffer_attachment& buffer : vertex_buffers)
         {
-            if (!glIsBuffer(buffer)) return false;
+            if (!glIsBuffer(buffer.id)) return false;
         }
 
         if (index_buffer != 0 && !glIsBuffer(index_buffer)) return false;
@@ -44,21 +44,47 @@ namespace stardraw::gl45
         return status_type::SUCCESS;
     }
 
-    status vertex_specification_state::attach_vertex_buffer(const GLuint slot, const GLuint id, const GLintptr offset, const GLsizei stride)
+    status vertex_specification_state::attach_vertex_buffer(const GLuint slot, const u64 buffer_hash, const GLuint id, const GLintptr offset, const GLsizei stride)
     {
         ZoneScoped;
         TracyGpuZone("[Stardraw] Attach vertex buffer to vertex specification");
         glVertexArrayVertexBuffer(vertex_array_id, slot, id, offset, stride);
-        vertex_buffers.push_back(id);
+        vertex_buffers.push_back({slot, buffer_hash, id, offset, stride});
         return status_type::SUCCESS;
     }
 
-    status vertex_specification_state::attach_index_buffer(const GLuint index_buffer_id)
+    status vertex_specification_state::attach_index_buffer(const u64 buffer_hash, const GLuint index_buffer_id, const GLintptr index_buffer_offset)
     {
         ZoneScoped;
         TracyGpuZone("[Stardraw] Attach index buffer to vertex specification");
         glVertexArrayElementBuffer(vertex_array_id, index_buffer_id);
         index_buffer = index_buffer_id;
+        index_buffer_hash = buffer_hash;
+        this->index_buffer_offset = index_buffer_offset;
         return status_type::SUCCESS;
     }
-}
\ No newline at end of file
+
+    bool vertex_specification_state::repoint_buffer(const u64 buffer_hash, const GLuint id, const GLintptr offset)
+    {
+        ZoneScoped;
+        bool repointed = false;
+        for (vertex_buffer_attachment& attachment : vertex_buffers)
+        {
+            if (attachment.buffer_hash != buffer_hash) continue;
+            attachment.id = id;
+            attachment.offset = offset;
+            glVertexArrayVertexBuffer(vertex_array_id, attachment.slot, id, offset, attachment.stride);
+            repointed = true;
+        }
+
+        if (index_buffer != 0 && index_buffer_hash == buffer_hash)
+        {
+            index_buffer = id;
+            index_buffer_offset = offset;
+            glVertexArrayElementBuffer(vertex_array_id, id);
+            repointed = true;
+        }
+
+        return repointed;
+    }
+}
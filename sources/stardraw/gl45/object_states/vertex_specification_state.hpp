@@ -15,16 +15,31 @@ namespace stardraw::gl45
         [[nodiscard]] bool has_index_buffer() const;
 
         [[nodiscard]] status bind() const;
-        [[nodiscard]] status attach_vertex_buffer(const GLuint slot, const GLuint id, const GLintptr offset, const GLsizei stride);
-        [[nodiscard]] status attach_index_buffer(GLuint index_buffer_id);
+        [[nodiscard]] status attach_vertex_buffer(const GLuint slot, const u64 buffer_hash, const GLuint id, const GLintptr offset, const GLsizei stride);
+        [[nodiscard]] status attach_index_buffer(const u64 buffer_hash, GLuint index_buffer_id, GLintptr index_buffer_offset);
+
+        //Points every attachment of the given buffer at its new storage (after the buffer has been resized). Returns true if anything was attached to it.
+        bool repoint_buffer(const u64 buffer_hash, const GLuint id, const GLintptr offset);
 
         [[nodiscard]] descriptor_type object_type() const override
         {
             return descriptor_type::VERTEX_SPECIFICATION;
         }
 
-        std::vector<GLuint> vertex_buffers;
+        struct vertex_buffer_attachment
+        {
+            GLuint slot;
+            u64 buffer_hash;
+            GLuint id;
+            GLintptr offset;
+            GLsizei stride;
+        };
+
+        std::vector<vertex_buffer_attachment> vertex_buffers;
+        u64 index_buffer_hash = 0;
         GLuint index_buffer = 0;
+        //Element buffers can't be bound at an offset, so indexed draws add this to their index address instead.
+        GLintptr index_buffer_offset = 0;
         GLuint vertex_array_id = 0;
     };
 }
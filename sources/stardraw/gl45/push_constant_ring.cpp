@@ -0,0 +1,154 @@
+#include "push_constant_ring.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+
+#include <tracy/Tracy.hpp>
+#include <tracy/TracyOpenGL.hpp>
+
+namespace stardraw::gl45
+{
+    push_constant_ring::~push_constant_ring()
+    {
+        for (const GLsync fence : segment_fences)
+        {
+            if (fence != nullptr) glDeleteSync(fence);
+        }
+
+        for (const retired_ring& retired : retired_rings)
+        {
+            glDeleteSync(retired.fence);
+            glDeleteBuffers(1, &retired.buffer_id);
+        }
+
+        if (ring_buffer_id != 0) glDeleteBuffers(1, &ring_buffer_id);
+    }
+
+    status push_constant_ring::push(const void* data, const u32 bytes)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Push constants");
+
+        if (offset_alignment == 0)
+        {
+            GLint alignment = 0;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+            offset_alignment = std::max<u64>(alignment, 1);
+        }
+
+        if (ring_buffer_ptr == nullptr)
+        {
+            const u64 aligned_bytes = (bytes + offset_alignment - 1) / offset_alignment * offset_alignment;
+            const status init_status = initialize(aligned_bytes * initial_pushes_per_segment * segment_count);
+            if (is_status_error(init_status)) return init_status;
+        }
+
+        u64 address = (ring_head + offset_alignment - 1) / offset_alignment * offset_alignment;
+        if (address + bytes > (current_segment + 1) * segment_size)
+        {
+            const status advance_status = advance_segment();
+            if (is_status_error(advance_status)) return advance_status;
+            address = ring_head;
+        }
+
+        memcpy(ring_buffer_ptr + address, data, bytes);
+        ring_head = address + bytes;
+        glBindBufferRange(GL_UNIFORM_BUFFER, push_constant_binding, ring_buffer_id, static_cast<GLintptr>(address), bytes);
+        return status_type::SUCCESS;
+    }
+
+    u64 push_constant_ring::allocated_bytes() const
+    {
+        u64 total = ring_buffer_ptr == nullptr ? 0 : ring_size;
+        for (const retired_ring& retired : retired_rings) total += retired.size;
+        return total;
+    }
+
+    status push_constant_ring::initialize(const u64 size)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Allocate push constant ring");
+
+        glCreateBuffers(1, &ring_buffer_id);
+        if (ring_buffer_id == 0) return {status_type::BACKEND_ERROR, "Unable to create push constant ring"};
+
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glNamedBufferStorage(ring_buffer_id, static_cast<GLsizeiptr>(size), nullptr, flags);
+
+        ring_buffer_ptr = static_cast<GLbyte*>(glMapNamedBufferRange(ring_buffer_id, 0, static_cast<GLsizeiptr>(size), flags));
+        if (ring_buffer_ptr == nullptr)
+        {
+            glDeleteBuffers(1, &ring_buffer_id);
+            ring_buffer_id = 0;
+            return {status_type::BACKEND_ERROR, "Unable to map push constant ring"};
+        }
+
+        ring_size = size;
+        segment_size = size / segment_count;
+        ring_head = 0;
+        current_segment = 0;
+        return status_type::SUCCESS;
+    }
+
+    status push_constant_ring::advance_segment()
+    {
+        ZoneScoped;
+        release_retired_rings();
+        const u64 next_segment = (current_segment + 1) % segment_count;
+
+        //Everything issued so far may read the segment being left. A fence left from an earlier failed advance is covered by this one.
+        if (segment_fences[current_segment] != nullptr) glDeleteSync(segment_fences[current_segment]);
+        segment_fences[current_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        GLsync& next_fence = segment_fences[next_segment];
+        if (next_fence != nullptr)
+        {
+            GLenum wait_status = glClientWaitSync(next_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            const bool signalled = wait_status == GL_ALREADY_SIGNALED || wait_status == GL_CONDITION_SATISFIED;
+            //More constants are in flight than the ring holds - grow rather than stall, until the ring is as big as it's allowed to get.
+            if (!signalled && wait_status != GL_WAIT_FAILED && ring_size * 2 <= max_ring_size) return grow();
+            if (!signalled && wait_status != GL_WAIT_FAILED) wait_status = glClientWaitSync(next_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+
+            //The fence is kept until the wait succeeds, so a failed advance never moves into memory the GPU may still be reading.
+            if (wait_status == GL_TIMEOUT_EXPIRED) return {status_type::TIMEOUT, "Timed out waiting for the GPU to release push constant memory"};
+            if (wait_status == GL_WAIT_FAILED) return {status_type::BACKEND_ERROR, "Failed waiting for the GPU to release push constant memory"};
+            glDeleteSync(next_fence);
+            next_fence = nullptr;
+        }
+
+        current_segment = next_segment;
+        ring_head = next_segment * segment_size;
+        return status_type::SUCCESS;
+    }
+
+    status push_constant_ring::grow()
+    {
+        ZoneScoped;
+        //The fence on the segment just left covers every draw that can read the old buffer, so the others can go.
+        retired_rings.push_back({ring_buffer_id, ring_size, segment_fences[current_segment]});
+        segment_fences[current_segment] = nullptr;
+        for (GLsync& fence : segment_fences)
+        {
+            if (fence != nullptr) glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        ring_buffer_id = 0;
+        ring_buffer_ptr = nullptr;
+        return initialize(ring_size * 2);
+    }
+
+    void push_constant_ring::release_retired_rings()
+    {
+        std::erase_if(retired_rings, [](const retired_ring& retired)
+        {
+            const GLenum wait_status = glClientWaitSync(retired.fence, 0, 0);
+            if (wait_status != GL_ALREADY_SIGNALED && wait_status != GL_CONDITION_SATISFIED) return false;
+
+            glDeleteSync(retired.fence);
+            glDeleteBuffers(1, &retired.buffer_id);
+            return true;
+        });
+    }
+}
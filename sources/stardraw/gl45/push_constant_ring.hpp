@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <vector>
+
+#include "gl_headers.hpp"
+#include "stardraw/api/types.hpp"
+
+namespace stardraw::gl45
+{
+    using namespace starlib_stdint;
+
+    //Uniform buffer binding reserved for push constant blocks. Transpiled shaders bind their push constants here, and other uniform buffers are kept below it.
+    constexpr u32 push_constant_binding = 63;
+
+    //Persistently mapped uniform buffer that push constant blocks are written into. Each write takes a fresh slice, so draws already issued keep reading their own values.
+    //The ring is split into segments that are fenced as they fill up, so a segment is only reused once the GPU is done with every draw reading it.
+    //If the GPU is still reading the next segment, the ring grows instead of stalling, and the old buffer is deleted once its fence signals.
+    class push_constant_ring
+    {
+    public:
+        ~push_constant_ring();
+
+        //Copies the block into the ring and binds it to push_constant_binding.
+        [[nodiscard]] status push(const void* data, const u32 bytes);
+        [[nodiscard]] u64 allocated_bytes() const;
+
+    private:
+        static constexpr u64 segment_count = 4;
+        //Aligned pushes each segment has room for when the ring is first created.
+        static constexpr u64 initial_pushes_per_segment = 1024;
+        static constexpr u64 max_ring_size = 64 * 1024 * 1024;
+
+        struct retired_ring
+        {
+            GLuint buffer_id;
+            u64 size;
+            GLsync fence;
+        };
+
+        [[nodiscard]] status initialize(const u64 size);
+        [[nodiscard]] status advance_segment();
+        [[nodiscard]] status grow();
+        void release_retired_rings();
+
+        GLuint ring_buffer_id = 0;
+        GLbyte* ring_buffer_ptr = nullptr;
+        u64 ring_size = 0;
+        u64 segment_size = 0;
+        u64 offset_alignment = 0;
+        u64 ring_head = 0;
+        u64 current_segment = 0;
+        std::array<GLsync, segment_count> segment_fences = {};
+        std::vector<retired_ring> retired_rings;
+    };
+}
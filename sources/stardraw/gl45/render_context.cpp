@@ -1,8 +1,13 @@
 #include "render_context.hpp"
 #include "window.hpp"
 
+#include <algorithm>
 #include <format>
+#include <map>
+#include <ranges>
 #include <slang-com-helper.h>
+#include <tracy/Tracy.hpp>
+#include <tracy/TracyOpenGL.hpp>
 
 #include "stardraw/internal/internal.hpp"
 
@@ -64,12 +69,13 @@ namespace stardraw::gl45
         return {-1, -1, false, false};
     }
 
-    render_context::render_context(window* window) : parent_window(window) {}
+    render_context::render_context(window* window) : parent_window(window), seen_shader_reload_generation(shader_reload_generation()) {}
 
     [[nodiscard]] status render_context::execute_command_buffer(const std::string_view& name)
     {
         status context_status = parent_window->make_gl_context_active();
         if (is_status_error(context_status)) return context_status;
+        poll_pending_shaders();
 
         //Opengl doesn't have any persistant command buffers, so we just execute it like a temporary one without consuming it.
         if (!command_lists.contains(std::string(name))) return status_type::UNKNOWN;
@@ -81,6 +87,7 @@ namespace stardraw::gl45
             if (is_status_error(result)) return result;
         }
 
+        fence_tracked_ranges();
         return status_from_last_gl_error();
     }
 
@@ -88,6 +95,7 @@ namespace stardraw::gl45
     {
         status context_status = parent_window->make_gl_context_active();
         if (is_status_error(context_status)) return context_status;
+        poll_pending_shaders();
 
         for (const starlib::polymorphic<command>& cmd : commands)
         {
@@ -95,6 +103,7 @@ namespace stardraw::gl45
             if (is_status_error(result)) return result;
         }
 
+        fence_tracked_ranges();
         return status_from_last_gl_error();
     }
 
@@ -123,7 +132,9 @@ namespace stardraw::gl45
             if (is_status_error(create_status)) return create_status;
         }
 
-        return status_from_last_gl_error();
+        const status gl_status = status_from_last_gl_error();
+        if (is_status_error(gl_status)) return gl_status;
+        return enforce_memory_budget();
     }
 
     [[nodiscard]] status render_context::delete_object(const descriptor_type type, const std::string_view& name)
@@ -132,12 +143,288 @@ namespace stardraw::gl45
         if (!objects.contains(type)) return status_type::NOTHING_TO_DO;
         if (!objects[type].contains(identifier.hash)) return status_type::NOTHING_TO_DO;
 
+        if (type == descriptor_type::BUFFER_POOL)
+        {
+            const buffer_pool_state* pool = find_buffer_pool_state(identifier);
+            if (pool != nullptr && pool->has_allocations()) return {status_type::INVALID, std::format("Can't delete buffer pool '{0}' - buffers are still allocated from it", name)};
+        }
+
         delete objects[type][identifier.hash];
         objects[type].erase(identifier.hash);
+        if (type == descriptor_type::BUFFER || type == descriptor_type::TEXTURE || type == descriptor_type::SHADER) binding_generation++;
+        if (type == descriptor_type::SHADER && reloading_shaders.contains(identifier.hash))
+        {
+            delete reloading_shaders[identifier.hash];
+            reloading_shaders.erase(identifier.hash);
+        }
+        if (evictable_objects.contains(type)) evictable_objects[type].erase(identifier.hash);
 
         return status_from_last_gl_error();
     }
 
+    [[nodiscard]] status render_context::get_buffer_pool_info(const std::string_view& name, buffer_pool_info* out_info)
+    {
+        const buffer_pool_state* pool = find_buffer_pool_state(object_identifier(name));
+        if (pool == nullptr) return {status_type::UNKNOWN, std::format("No buffer pool with name '{0}' in context", name)};
+        *out_info = pool->info();
+        return status_type::SUCCESS;
+    }
+
+    [[nodiscard]] status render_context::resize_buffer(const std::string_view& name, const u64 new_size, const bool preserve)
+    {
+        const status context_status = parent_window->make_gl_context_active();
+        if (is_status_error(context_status)) return context_status;
+
+        const object_identifier identifier = object_identifier(name);
+        buffer_state* buffer = find_buffer_state(identifier);
+        if (buffer == nullptr) return {status_type::UNKNOWN, std::format("No buffer with name '{0}' in context", name)};
+        if (!buffer->is_valid()) return {status_type::INVALID, std::format("Buffer '{0}' is in an invalid state", name)};
+        if (new_size == 0) return {status_type::INVALID, std::format("Can't resize buffer '{0}' to zero bytes", name)};
+        if (static_cast<u64>(buffer->get_size()) == new_size) return status_type::NOTHING_TO_DO;
+
+        //Unchecked uploads write straight into the mapped storage, which is about to go away.
+        for (const buffer_memory_transfer_info& transfer : buffer_transfers | std::views::values)
+        {
+            const bool is_direct = transfer.transfer_type == buffer_memory_transfer_info::type::UPLOAD_UNCHECKED || transfer.transfer_type == buffer_memory_transfer_info::type::UPLOAD_TRACKED;
+            if (is_direct && object_identifier(transfer.target).hash == identifier.hash)
+            {
+                return {status_type::INVALID, std::format("Can't resize buffer '{0}' while it has unflushed direct uploads", name)};
+            }
+        }
+
+        const status resize_status = buffer->resize(new_size, preserve);
+        if (is_status_error(resize_status)) return resize_status;
+
+        if (objects.contains(descriptor_type::VERTEX_SPECIFICATION))
+        {
+            for (object_state* state : objects[descriptor_type::VERTEX_SPECIFICATION] | std::views::values)
+            {
+                dynamic_cast<vertex_specification_state*>(state)->repoint_buffer(identifier.hash, buffer->gl_id(), buffer->gl_offset());
+            }
+        }
+
+        //Every other binding point still names the old GL buffer, so anywhere this buffer is bound gets bound again. Vertex and index bindings live in the vertex arrays repointed above.
+        for (const auto& [binding, hash] : bound_buffers)
+        {
+            if (hash != identifier.hash) continue;
+            const GLenum target = static_cast<GLenum>(binding >> 32);
+            const GLuint slot = static_cast<GLuint>(binding & 0xFFFFFFFF);
+            if (target == GL_ARRAY_BUFFER || target == GL_ELEMENT_ARRAY_BUFFER) continue;
+
+            const bool is_indexed = target == GL_UNIFORM_BUFFER || target == GL_SHADER_STORAGE_BUFFER || target == GL_ATOMIC_COUNTER_BUFFER || target == GL_TRANSFORM_FEEDBACK_BUFFER;
+            const status bind_status = is_indexed ? buffer->bind_to_slot(target, slot) : buffer->bind_to(target);
+            if (is_status_error(bind_status)) return bind_status;
+        }
+
+        if (active_draw_specification != nullptr)
+        {
+            const vertex_specification_state* active_vertex_spec = find_vertex_specification_state(active_draw_specification->vertex_specification);
+            if (active_vertex_spec != nullptr) active_index_buffer_offset = active_vertex_spec->index_buffer_offset;
+        }
+
+        const status gl_status = status_from_last_gl_error();
+        if (is_status_error(gl_status)) return gl_status;
+        return enforce_memory_budget();
+    }
+
+    [[nodiscard]] status render_context::ensure_buffer_size(const std::string_view& name, const u64 min_size, const bool preserve)
+    {
+        const buffer_state* buffer = find_buffer_state(object_identifier(name));
+        if (buffer == nullptr) return {status_type::UNKNOWN, std::format("No buffer with name '{0}' in context", name)};
+
+        const u64 current_size = buffer->get_size();
+        if (current_size >= min_size) return status_type::NOTHING_TO_DO;
+        return resize_buffer(name, std::max(min_size, current_size * 2), preserve);
+    }
+
+    status render_context::set_memory_budget(const u64 bytes)
+    {
+        const status context_status = parent_window->make_gl_context_active();
+        if (is_status_error(context_status)) return context_status;
+
+        memory_budget = bytes;
+        return enforce_memory_budget();
+    }
+
+    status render_context::get_memory_usage(memory_usage_info* out_info)
+    {
+        if (out_info == nullptr) return status_type::UNEXPECTED;
+        *out_info = compute_memory_usage();
+        return status_type::SUCCESS;
+    }
+
+    status render_context::get_object_memory_usage(const descriptor_type type, const std::string_view& name, u64* out_bytes)
+    {
+        if (out_bytes == nullptr) return status_type::UNEXPECTED;
+        const object_identifier identifier = object_identifier(name);
+        if (!objects.contains(type) || !objects[type].contains(identifier.hash)) return {status_type::UNKNOWN, std::format("No object with name '{0}' of the given type in context", name)};
+
+        *out_bytes = object_memory_usage(objects[type][identifier.hash]);
+        return status_type::SUCCESS;
+    }
+
+    status render_context::set_object_evictable(const descriptor_type type, const std::string_view& name, const object_eviction_callback& callback)
+    {
+        if (type != descriptor_type::BUFFER && type != descriptor_type::TEXTURE) return {status_type::UNSUPPORTED, "Only buffers and textures can be evicted"};
+        const object_identifier identifier = object_identifier(name);
+        if (!objects.contains(type) || !objects[type].contains(identifier.hash)) return {status_type::UNKNOWN, std::format("No object with name '{0}' of the given type in context", name)};
+
+        evictable_objects[type][identifier.hash] = {std::string(name), callback};
+        return status_type::SUCCESS;
+    }
+
+    status render_context::evict_objects(const u64 target_bytes)
+    {
+        const status context_status = parent_window->make_gl_context_active();
+        if (is_status_error(context_status)) return context_status;
+
+        u64 total_bytes = compute_memory_usage().total_bytes;
+        if (total_bytes <= target_bytes) return status_type::NOTHING_TO_DO;
+
+        //Submitted async uploads only name their target, so they're copied now rather than left to fail against an evicted buffer.
+        const status async_status = flush_async_uploads();
+        if (is_status_error(async_status)) return async_status;
+
+        struct eviction_candidate
+        {
+            descriptor_type type;
+            u64 hash;
+            u64 last_used;
+        };
+
+        std::vector<eviction_candidate> candidates;
+        for (const auto& [type, entries] : evictable_objects)
+        {
+            for (const u64 hash : entries | std::views::keys)
+            {
+                //Objects with outstanding transfers are skipped, the transfers still reference them.
+                if (!objects[type].contains(hash) || has_pending_transfers(type, hash)) continue;
+                //Pooled buffers and texture views own no memory of their own - evicting them frees nothing.
+                if (object_memory_usage(objects[type][hash]) == 0) continue;
+                candidates.push_back({type, hash, objects[type][hash]->last_used});
+            }
+        }
+
+        std::ranges::sort(candidates, {}, &eviction_candidate::last_used);
+
+        for (const eviction_candidate& candidate : candidates)
+        {
+            if (total_bytes <= target_bytes) break;
+
+            const evictable_object evicted = evictable_objects[candidate.type][candidate.hash];
+            const u64 evicted_bytes = object_memory_usage(objects[candidate.type][candidate.hash]);
+
+            const status delete_status = delete_object(candidate.type, evicted.name);
+            if (is_status_error(delete_status)) return delete_status;
+
+            total_bytes -= std::min(evicted_bytes, total_bytes);
+            if (evicted.callback) evicted.callback(candidate.type, evicted.name, evicted_bytes);
+        }
+
+        if (total_bytes > target_bytes) return {status_type::RANGE_OVERFLOW, std::format("Estimated GPU memory usage ({0} bytes) is still above {1} bytes after evicting every evictable object", total_bytes, target_bytes)};
+        return status_type::SUCCESS;
+    }
+
+    memory_usage_info render_context::compute_memory_usage()
+    {
+        memory_usage_info info;
+        info.budget_bytes = memory_budget;
+
+        for (const auto& [type, states] : objects)
+        {
+            for (const object_state* state : states | std::views::values)
+            {
+                if (type == descriptor_type::TEXTURE) info.texture_bytes += state->memory_usage();
+                else info.buffer_bytes += state->memory_usage();
+
+                if (type == descriptor_type::BUFFER) info.staging_bytes += dynamic_cast<const buffer_state*>(state)->staging_memory_usage();
+            }
+        }
+
+        info.staging_bytes += readback_downloader.allocated_bytes();
+        info.transient_bytes += async_uploader.allocated_bytes() + scheduled_uploader.staging_bytes() + push_constants.allocated_bytes();
+
+        //Scheduled buffer uploads and texture uploads own their staging buffers until they're flushed.
+        for (const auto& [handle, transfer] : buffer_transfers)
+        {
+            if (transfer.transfer_type == buffer_memory_transfer_info::type::UPLOAD_SCHEDULED) info.transient_bytes += dynamic_cast<const gl_memory_transfer_handle*>(handle)->transfer_size;
+        }
+
+        for (const auto& [handle, transfer] : texture_transfers)
+        {
+            if (transfer.transfer_type != texture_memory_transfer_info::type::DOWNLOAD) info.transient_bytes += dynamic_cast<const gl_memory_transfer_handle*>(handle)->transfer_size;
+        }
+
+        info.total_bytes = info.buffer_bytes + info.texture_bytes + info.staging_bytes + info.transient_bytes;
+        return info;
+    }
+
+    u64 render_context::object_memory_usage(const object_state* state)
+    {
+        if (state->object_type() == descriptor_type::BUFFER) return state->memory_usage() + dynamic_cast<const buffer_state*>(state)->staging_memory_usage();
+        return state->memory_usage();
+    }
+
+    bool render_context::has_pending_transfers(const descriptor_type type, const u64 hash)
+    {
+        if (type == descriptor_type::BUFFER)
+        {
+            //Async reservations still being written could target any buffer.
+            if (async_uploader.has_unsubmitted_handles() || scheduled_uploader.has_upload_for(false, hash)) return true;
+            return std::ranges::any_of(buffer_transfers | std::views::values, [hash](const buffer_memory_transfer_info& info) { return object_identifier(info.target).hash == hash; });
+        }
+
+        if (type == descriptor_type::TEXTURE)
+        {
+            if (scheduled_uploader.has_upload_for(true, hash)) return true;
+            return std::ranges::any_of(texture_transfers | std::views::values, [hash](const texture_memory_transfer_info& info) { return object_identifier(info.target).hash == hash; });
+        }
+
+        return false;
+    }
+
+    void render_context::note_buffer_binding(const GLenum target, const GLuint slot, const u64 buffer_hash)
+    {
+        bound_buffers[static_cast<u64>(target) << 32 | slot] = buffer_hash;
+    }
+
+    void render_context::record_bound_buffer_reads()
+    {
+        if (!objects.contains(descriptor_type::BUFFER)) return;
+        const std::unordered_map<u64, object_state*>& buffers = objects[descriptor_type::BUFFER];
+        for (const u64 hash : bound_buffers | std::views::values)
+        {
+            if (!range_tracked_buffers.contains(hash) || !buffers.contains(hash)) continue;
+            const buffer_state* buffer = dynamic_cast<const buffer_state*>(buffers.at(hash));
+            //Which part of a bound buffer a draw reads isn't known here, so all of it is treated as read.
+            buffer->record_pending_range(0, buffer->get_size());
+        }
+    }
+
+    void render_context::fence_tracked_ranges()
+    {
+        const bool record_reads = draws_since_fence;
+        draws_since_fence = false;
+        if (range_tracked_buffers.empty()) return;
+        if (record_reads) record_bound_buffer_reads();
+
+        //One fence covers every range touched since the last fence point, across all tracked buffers.
+        const shared_gl_fence fence = make_shared_gl_fence();
+        std::erase_if(range_tracked_buffers, [this, &fence](const u64 hash)
+        {
+            if (!objects[descriptor_type::BUFFER].contains(hash)) return true;
+            dynamic_cast<buffer_state*>(objects[descriptor_type::BUFFER][hash])->fence_pending_ranges(fence);
+            return false;
+        });
+    }
+
+    status render_context::enforce_memory_budget()
+    {
+        if (memory_budget == 0) return status_type::SUCCESS;
+        const status evict_status = evict_objects(memory_budget);
+        return evict_status.type == status_type::NOTHING_TO_DO ? status_type::SUCCESS : evict_status;
+    }
+
     [[nodiscard]] signal_status render_context::check_signal(const std::string_view& name)
     {
         return wait_signal(name, 0);
@@ -166,9 +453,33 @@ namespace stardraw::gl45
 
     status render_context::prepare_buffer_memory_transfer(const buffer_memory_transfer_info& info, memory_transfer_handle** out_handle)
     {
+        //Async uploads can be prepared from any thread, so they must not touch the object or transfer maps. The target is resolved when the upload is drained.
+        if (info.transfer_type == buffer_memory_transfer_info::type::UPLOAD_ASYNC)
+        {
+            gl_memory_transfer_handle* handle;
+            status reserve_status = async_uploader.reserve(info.target, info.address, info.bytes, &handle);
+            if (is_status_error(reserve_status)) return reserve_status;
+            *out_handle = handle;
+            return status_type::SUCCESS;
+        }
+
         buffer_state* buffer = find_buffer_state(object_identifier(info.target));
         if (buffer == nullptr) return {status_type::UNKNOWN, std::format("No buffer with name '{0}' in context", info.target)};
         if (!buffer->is_valid()) return {status_type::INVALID, std::format("Buffer '{0}' is in an invalid state", info.target)};
+        mark_used(buffer);
+
+        if (!info.regions.empty())
+        {
+            const bool streaming = info.transfer_type == buffer_memory_transfer_info::type::UPLOAD_STREAMING;
+            if (!streaming && info.transfer_type != buffer_memory_transfer_info::type::UPLOAD_CHUNK) return {status_type::UNSUPPORTED, "Scatter uploads are only supported for streaming and chunked uploads"};
+
+            memory_transfer_handle* handle;
+            status prepare_status = buffer->prepare_upload_regions(info.regions, streaming, &handle);
+            if (is_status_error(prepare_status)) return prepare_status;
+            buffer_transfers[handle] = info;
+            *out_handle = handle;
+            return status_type::SUCCESS;
+        }
 
         switch (info.transfer_type)
         {
@@ -182,6 +493,7 @@ namespace stardraw::gl45
                 return status_type::SUCCESS;
             }
             case buffer_memory_transfer_info::type::UPLOAD_CHUNK:
+            case buffer_memory_transfer_info::type::UPLOAD_SCHEDULED:
             {
                 memory_transfer_handle* handle;
                 status prepare_status = buffer->prepare_upload_data_chunked(info.address, info.bytes, &handle);
@@ -199,16 +511,60 @@ namespace stardraw::gl45
                 *out_handle = handle;
                 return status_type::SUCCESS;
             }
+            case buffer_memory_transfer_info::type::UPLOAD_TRACKED:
+            {
+                memory_transfer_handle* handle;
+                status prepare_status = buffer->prepare_upload_data_tracked(info.address, info.bytes, &handle);
+                if (is_status_error(prepare_status)) return prepare_status;
+                range_tracked_buffers.insert(object_identifier(info.target).hash);
+                buffer_transfers[handle] = info;
+                *out_handle = handle;
+                return status_type::SUCCESS;
+            }
+            case buffer_memory_transfer_info::type::DOWNLOAD:
+            {
+                memory_transfer_handle* handle;
+                status prepare_status = buffer->prepare_download_data(info.address, info.bytes, readback_downloader, info.ready_callback, &handle);
+                if (is_status_error(prepare_status)) return prepare_status;
+                buffer_transfers[handle] = info;
+                *out_handle = handle;
+                return status_type::SUCCESS;
+            }
             default: return {status_type::UNSUPPORTED};
         }
     }
 
     status render_context::flush_buffer_memory_transfer(memory_transfer_handle* handle)
     {
+        gl_memory_transfer_handle* gl_handle = dynamic_cast<gl_memory_transfer_handle*>(handle);
+        if (gl_handle != nullptr && gl_handle->is_async)
+        {
+            async_uploader.submit(gl_handle);
+            return status_type::SUCCESS;
+        }
+
         if (!buffer_transfers.contains(handle)) return {status_type::UNKNOWN, "Memory transfer handle not recognized - did you create it with a different context or type?"};
         const buffer_memory_transfer_info info = buffer_transfers[handle];
         buffer_transfers.erase(handle);
 
+        //Downloads only own ring memory, so they can be released even if the buffer has since been deleted.
+        if (info.transfer_type == buffer_memory_transfer_info::type::DOWNLOAD) return readback_downloader.free_download(dynamic_cast<gl_memory_transfer_handle*>(handle));
+
+        if (info.transfer_type == buffer_memory_transfer_info::type::UPLOAD_SCHEDULED)
+        {
+            const gl_memory_transfer_handle* staged_handle = dynamic_cast<gl_memory_transfer_handle*>(handle);
+            glUnmapNamedBuffer(staged_handle->transfer_buffer_id);
+
+            upload_scheduler::scheduled_upload upload;
+            upload.buffer_info = info;
+            upload.staging_buffer_id = staged_handle->transfer_buffer_id;
+            upload.slice_bytes = 1;
+            upload.total_slices = staged_handle->transfer_size;
+            scheduled_uploader.enqueue(info.priority, std::move(upload));
+            delete handle;
+            return status_type::SUCCESS;
+        }
+
         const buffer_state* buffer = find_buffer_state(object_identifier(info.target));
         if (buffer == nullptr) return {status_type::UNKNOWN, std::format("No buffer with name '{0}' in context", info.target)};
         if (!buffer->is_valid()) return {status_type::INVALID, std::format("Buffer '{0}' is in an invalid state", info.target)};
@@ -217,6 +573,7 @@ namespace stardraw::gl45
             case buffer_memory_transfer_info::type::UPLOAD_STREAMING: return buffer->flush_upload_data_streaming(handle);
             case buffer_memory_transfer_info::type::UPLOAD_CHUNK: return buffer->flush_upload_data_chunked(handle);
             case buffer_memory_transfer_info::type::UPLOAD_UNCHECKED: return buffer->flush_upload_data_unchecked(handle);
+            case buffer_memory_transfer_info::type::UPLOAD_TRACKED: return buffer->flush_upload_data_tracked(handle);
 
             default: return {status_type::UNSUPPORTED};
         }
@@ -227,9 +584,10 @@ namespace stardraw::gl45
         const texture_state* texture = find_texture_state(object_identifier(info.target));
         if (texture == nullptr) return {status_type::UNKNOWN, std::format("No texture with name '{0}' in context", info.target)};
         if (!texture->is_valid()) return {status_type::INVALID, std::format("Texture '{0}' is in an invalid state", info.target)};
+        mark_used(texture);
 
         memory_transfer_handle* handle;
-        status prepare_status = texture->prepare_upload(info, &handle);
+        status prepare_status = (info.transfer_type == texture_memory_transfer_info::type::DOWNLOAD) ? texture->prepare_download(info, readback_downloader, &handle) : texture->prepare_upload(info, &handle);
         if (is_status_error(prepare_status)) return prepare_status;
         texture_transfers[handle] = info;
         *out_handle = handle;
@@ -242,12 +600,125 @@ namespace stardraw::gl45
         const texture_memory_transfer_info info = texture_transfers[handle];
         texture_transfers.erase(handle);
 
+        if (info.transfer_type == texture_memory_transfer_info::type::DOWNLOAD) return readback_downloader.free_download(dynamic_cast<gl_memory_transfer_handle*>(handle));
+
         const texture_state* texture = find_texture_state(object_identifier(info.target));
         if (texture == nullptr) return {status_type::UNKNOWN, std::format("No texture with name '{0}' in context", info.target)};
         if (!texture->is_valid()) return {status_type::INVALID, std::format("Texture '{0}' is in an invalid state", info.target)};
+
+        if (info.transfer_type == texture_memory_transfer_info::type::UPLOAD_SCHEDULED)
+        {
+            const gl_memory_transfer_handle* staged_handle = dynamic_cast<gl_memory_transfer_handle*>(handle);
+            glUnmapNamedBuffer(staged_handle->transfer_buffer_id);
+
+            upload_scheduler::scheduled_upload upload;
+            upload.is_texture = true;
+            upload.texture_info = info;
+            upload.staging_buffer_id = staged_handle->transfer_buffer_id;
+            upload.total_slices = texture->transfer_slice_count(info);
+            upload.slice_bytes = std::max<u64>(texture->transfer_byte_count(info) / upload.total_slices, 1);
+            scheduled_uploader.enqueue(info.priority, std::move(upload));
+            delete handle;
+            return status_type::SUCCESS;
+        }
+
         return texture->flush_upload(info, handle);
     }
 
+    status render_context::configure_async_uploads(const u64 ring_bytes)
+    {
+        const status context_status = parent_window->make_gl_context_active();
+        if (is_status_error(context_status)) return context_status;
+
+        return async_uploader.initialize(ring_bytes);
+    }
+
+    status render_context::process_memory_transfers()
+    {
+        const status context_status = parent_window->make_gl_context_active();
+        if (is_status_error(context_status)) return context_status;
+
+        const status async_status = flush_async_uploads();
+        const status scheduled_status = flush_scheduled_uploads();
+        readback_downloader.update_downloads();
+        fence_tracked_ranges();
+        if (is_status_error(async_status)) return async_status;
+        if (is_status_error(scheduled_status)) return scheduled_status;
+        return status_from_last_gl_error();
+    }
+
+    status render_context::set_upload_budget(const u64 bytes_per_frame)
+    {
+        scheduled_uploader.set_frame_budget(bytes_per_frame);
+        return status_type::SUCCESS;
+    }
+
+    status render_context::get_upload_queue_info(upload_queue_info* out_info)
+    {
+        *out_info = scheduled_uploader.info();
+        return status_type::SUCCESS;
+    }
+
+    status render_context::flush_scheduled_uploads()
+    {
+        return scheduled_uploader.process([this](const upload_scheduler::scheduled_upload& upload, const u64 first_slice, const u64 slice_count) -> status
+        {
+            if (upload.is_texture)
+            {
+                const texture_state* texture = find_texture_state(object_identifier(upload.texture_info.target));
+                if (texture == nullptr) return {status_type::UNKNOWN, std::format("No texture with name '{0}' in context (scheduled upload)", upload.texture_info.target)};
+                if (!texture->is_valid()) return {status_type::INVALID, std::format("Texture '{0}' is in an invalid state (scheduled upload)", upload.texture_info.target)};
+                return texture->unpack_slices(upload.texture_info, upload.staging_buffer_id, first_slice, slice_count);
+            }
+
+            const buffer_state* buffer = find_buffer_state(object_identifier(upload.buffer_info.target));
+            if (buffer == nullptr) return {status_type::UNKNOWN, std::format("No buffer with name '{0}' in context (scheduled upload)", upload.buffer_info.target)};
+            if (!buffer->is_valid()) return {status_type::INVALID, std::format("Buffer '{0}' is in an invalid state (scheduled upload)", upload.buffer_info.target)};
+            return buffer->copy_data(upload.staging_buffer_id, first_slice, upload.buffer_info.address + first_slice, slice_count);
+        });
+    }
+
+    status render_context::flush_async_uploads()
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Flush async uploads");
+
+        if (!async_uploader.is_initialized()) return status_type::NOTHING_TO_DO;
+        const std::vector<gl_memory_transfer_handle*> handles = async_uploader.drain();
+
+        //Every drained handle is retired even if its copy fails, otherwise its ring space would never be reclaimed. The first failure is reported.
+        status result = status_type::SUCCESS;
+        for (const gl_memory_transfer_handle* handle : handles)
+        {
+            if (handle->current_status != memory_transfer_status::COMPLETE) continue; //Flushed without transferring - cancelled.
+
+            const buffer_state* buffer = find_buffer_state(object_identifier(handle->async_target));
+            status copy_status = status_type::SUCCESS;
+            if (buffer == nullptr) copy_status = {status_type::UNKNOWN, std::format("No buffer with name '{0}' in context (async upload)", handle->async_target)};
+            else if (!buffer->is_valid()) copy_status = {status_type::INVALID, std::format("Buffer '{0}' is in an invalid state (async upload)", handle->async_target)};
+            else if (!buffer->is_in_buffer_range(handle->transfer_destination_address, handle->transfer_size)) copy_status = {status_type::RANGE_OVERFLOW, std::format("Async upload range is out of range in buffer '{0}'", handle->async_target)};
+            else copy_status = buffer->copy_data(handle->transfer_buffer_id, handle->transfer_buffer_address, handle->transfer_destination_address, handle->transfer_size);
+
+            if (is_status_error(copy_status) && !is_status_error(result)) result = copy_status;
+        }
+
+        async_uploader.retire(handles);
+        return result;
+    }
+
+    signal_status render_context::wait_memory_transfer(memory_transfer_handle* handle, const u64 timeout_nanos)
+    {
+        const status context_status = parent_window->make_gl_context_active();
+        if (is_status_error(context_status)) return signal_status::CONTEXT_ERROR;
+
+        if (!buffer_transfers.contains(handle) && !texture_transfers.contains(handle)) return signal_status::UNKNOWN_SIGNAL;
+
+        gl_memory_transfer_handle* gl_handle = dynamic_cast<gl_memory_transfer_handle*>(handle);
+        if (gl_handle == nullptr) return signal_status::UNKNOWN_SIGNAL;
+        if (!gl_handle->is_download) return signal_status::SIGNALLED;
+        return readback_downloader.wait_download(gl_handle, timeout_nanos);
+    }
+
     status render_context::status_from_last_gl_error()
     {
         GLenum latest_status = glGetError();
@@ -291,6 +762,7 @@ namespace stardraw::gl45
         }
 
         const command_type type = cmd->type();
+        if (type == command_type::DRAW || type == command_type::DRAW_INDEXED || type == command_type::DRAW_INDIRECT || type == command_type::DRAW_INDEXED_INDIRECT) draws_since_fence = true;
         switch (type)
         {
             case command_type::DRAW: return execute_draw(dynamic_cast<const draw_command*>(cmd));
@@ -309,10 +781,14 @@ namespace stardraw::gl45
             case command_type::BUFFER_COPY: return execute_buffer_copy(dynamic_cast<const buffer_copy_command*>(cmd));
 
             case command_type::CLEAR_WINDOW: return execute_clear_window(dynamic_cast<const clear_window_command*>(cmd));
-            case command_type::CLEAR_BUFFER: return status_type::UNIMPLEMENTED; //TODO
+            case command_type::CLEAR_BUFFER: return execute_clear_buffer(dynamic_cast<const clear_buffer_command*>(cmd));
             case command_type::CONFIG_SHADER: return execute_shader_parameters_upload(dynamic_cast<const shader_config_command*>(cmd));
+            case command_type::CONFIG_PARAMETER_SET: return execute_parameter_set(dynamic_cast<const parameter_set_command*>(cmd));
+            case command_type::PUSH_CONSTANTS: return execute_push_constants(dynamic_cast<const push_constants_command*>(cmd));
             case command_type::SIGNAL: return execute_signal(dynamic_cast<const signal_command*>(cmd));
-            case command_type::TEXTURE_COPY: break; //TODO
+            case command_type::TEXTURE_COPY: return execute_texture_copy(dynamic_cast<const texture_copy_command*>(cmd));
+            case command_type::BUFFER_TO_TEXTURE_COPY: return execute_buffer_to_texture_copy(dynamic_cast<const buffer_to_texture_copy_command*>(cmd));
+            case command_type::TEXTURE_TO_BUFFER_COPY: return execute_texture_to_buffer_copy(dynamic_cast<const texture_to_buffer_copy_command*>(cmd));
         }
 
         return {status_type::UNSUPPORTED, "Unsupported command"};
@@ -329,6 +805,8 @@ namespace stardraw::gl45
             case descriptor_type::DRAW_SPECIFICATION: return create_draw_specification_state(dynamic_cast<const draw_specification_descriptor*>(descriptor));
             case descriptor_type::TEXTURE: return create_texture_state(dynamic_cast<const texture_descriptor*>(descriptor));
             case descriptor_type::TEXTURE_SAMPLER: return create_texture_sampler_state(dynamic_cast<const texture_sampler_descriptor*>(descriptor));
+            case descriptor_type::BUFFER_POOL: return create_buffer_pool_state(dynamic_cast<const buffer_pool_descriptor*>(descriptor));
+            case descriptor_type::PARAMETER_SET: return create_parameter_set_state(dynamic_cast<const parameter_set_descriptor*>(descriptor));
         }
         return status_type::UNIMPLEMENTED;
     }
@@ -336,7 +814,19 @@ namespace stardraw::gl45
     [[nodiscard]] status render_context::create_buffer_state(const buffer_descriptor* descriptor)
     {
         status create_status = status_type::SUCCESS;
-        buffer_state* buffer = new buffer_state(*descriptor, create_status);
+        buffer_state* buffer;
+        if (descriptor->pool.empty())
+        {
+            buffer = new buffer_state(*descriptor, create_status);
+        }
+        else
+        {
+            buffer_pool_state* pool = find_buffer_pool_state(object_identifier(descriptor->pool));
+            if (pool == nullptr) return {status_type::UNKNOWN, std::format("No buffer pool named '{0}' found while creating buffer '{1}'", descriptor->pool, descriptor->identifier().name)};
+            if (!pool->is_valid()) return {status_type::INVALID, std::format("Can't create buffer '{1}', buffer pool '{0}' is in an invalid state!", descriptor->pool, descriptor->identifier().name)};
+            buffer = new buffer_state(*descriptor, pool, create_status);
+        }
+
         if (!buffer->is_valid())
         {
             delete buffer;
@@ -346,8 +836,27 @@ namespace stardraw::gl45
         return record_object_state(descriptor->identifier(), buffer);
     }
 
+    status render_context::create_buffer_pool_state(const buffer_pool_descriptor* descriptor)
+    {
+        status create_status = status_type::SUCCESS;
+        buffer_pool_state* pool = new buffer_pool_state(*descriptor, create_status);
+        if (is_status_error(create_status))
+        {
+            delete pool;
+            return create_status;
+        }
+
+        return record_object_state(descriptor->identifier(), pool);
+    }
+
     status render_context::create_shader_state(const shader_descriptor* descriptor)
     {
+        if (!parallel_compile_configured)
+        {
+            shader_state::configure_parallel_compile();
+            parallel_compile_configured = true;
+        }
+
         status shader_create_status = status_type::SUCCESS;
         shader_state* shader = new shader_state(*descriptor, shader_create_status);
         if (is_status_error(shader_create_status))
@@ -356,9 +865,114 @@ namespace stardraw::gl45
             return shader_create_status;
         }
 
+        if (shader->is_pending()) pending_shaders.insert(descriptor->identifier().hash);
         return record_object_state(descriptor->identifier(), shader);
     }
 
+    void render_context::poll_pending_shaders()
+    {
+        poll_reloading_shaders();
+        if (pending_shaders.empty()) return;
+        ZoneScoped;
+
+        //Failed compiles stop being polled too - their error is reported when the shader is bound or queried.
+        std::erase_if(pending_shaders, [this](const u64 hash)
+        {
+            if (!objects[descriptor_type::SHADER].contains(hash)) return true;
+            shader_state* shader = dynamic_cast<shader_state*>(objects[descriptor_type::SHADER][hash]);
+            (void)shader->poll_compile();
+            return !shader->is_pending();
+        });
+    }
+
+    status render_context::apply_shader_reloads()
+    {
+        ZoneScoped;
+        std::vector<shader_program*> reloaded_programs;
+        //Programs are shared between contexts, so each context catches up on every reload since it last looked, whichever context swapped it in.
+        status reload_status = stardraw::apply_shader_reloads(&reloaded_programs, &seen_shader_reload_generation);
+        if (reloaded_programs.empty()) return reload_status;
+
+        status context_status = parent_window->make_gl_context_active();
+        if (is_status_error(context_status)) return context_status;
+
+        //One shader failing to rebuild doesn't stop the rest - the first failure is returned once they've all been tried.
+        for (const auto& [hash, state] : objects[descriptor_type::SHADER])
+        {
+            const shader_state* shader = dynamic_cast<shader_state*>(state);
+            const bool affected = std::ranges::any_of(reloaded_programs, [shader](const shader_program* program) { return shader->uses_program(program); });
+            if (!affected) continue;
+
+            //A reload landing while the previous one is still compiling supersedes it.
+            if (reloading_shaders.contains(hash)) delete reloading_shaders[hash];
+
+            status replacement_status = status_type::SUCCESS;
+            const shader_descriptor descriptor = shader_descriptor("", shader->stages, shader_compile_mode::ASYNCHRONOUS, shader->fallback_shader);
+            shader_state* replacement = new shader_state(descriptor, replacement_status);
+            if (is_status_error(replacement_status))
+            {
+                delete replacement;
+                reloading_shaders.erase(hash);
+                if (!is_status_error(reload_status)) reload_status = replacement_status;
+                continue;
+            }
+
+            reloading_shaders[hash] = replacement;
+        }
+
+        poll_reloading_shaders();
+        return reload_status;
+    }
+
+    void render_context::poll_reloading_shaders()
+    {
+        if (reloading_shaders.empty()) return;
+        ZoneScoped;
+
+        std::erase_if(reloading_shaders, [this](const std::pair<const u64, shader_state*>& entry)
+        {
+            const auto& [hash, replacement] = entry;
+            if (!objects[descriptor_type::SHADER].contains(hash))
+            {
+                delete replacement;
+                return true;
+            }
+
+            const status compile_status = replacement->poll_compile();
+            if (compile_status.type == status_type::PENDING) return false;
+
+            //A failed rebuild leaves the old shader in place. The error was already reported by the module reload if it came from the shader source.
+            if (is_status_error(compile_status) || !replacement->is_valid())
+            {
+                delete replacement;
+                return true;
+            }
+
+            shader_state* previous = dynamic_cast<shader_state*>(objects[descriptor_type::SHADER][hash]);
+            for (const shader_parameter& parameter : previous->parameter_store)
+            {
+                //Parameters the reloaded shader no longer has are dropped.
+                (void)replacement->upload_parameter(parameter);
+            }
+
+            replacement->last_used = previous->last_used;
+            objects[descriptor_type::SHADER][hash] = replacement;
+            delete previous;
+            binding_generation++;
+            return true;
+        });
+    }
+
+    status render_context::get_shader_status(const std::string_view& name)
+    {
+        shader_state* shader = find_shader_state(object_identifier(name));
+        if (shader == nullptr) return {status_type::UNKNOWN, std::format("Shader object '{0}' not found in context", name)};
+
+        status context_status = parent_window->make_gl_context_active();
+        if (is_status_error(context_status)) return context_status;
+        return shader->poll_compile();
+    }
+
     status render_context::create_texture_state(const texture_descriptor* descriptor)
     {
         status texture_create_status = status_type::SUCCESS;
@@ -452,7 +1066,7 @@ namespace stardraw::gl45
         for (const std::string& vertex_buffer : buffer_names)
         {
             const buffer_state* buffer_state = buffer_states[vertex_buffer];
-            const status attach_status = vertex_spec->attach_vertex_buffer(buffer_slots[vertex_buffer], buffer_state->gl_id(), 0, buffer_strides[buffer_slots[vertex_buffer]]);
+            const status attach_status = vertex_spec->attach_vertex_buffer(buffer_slots[vertex_buffer], object_identifier(vertex_buffer).hash, buffer_state->gl_id(), buffer_state->gl_offset(), buffer_strides[buffer_slots[vertex_buffer]]);
 
             if (is_status_error(attach_status))
             {
@@ -470,7 +1084,7 @@ namespace stardraw::gl45
                 return {status_type::UNKNOWN, std::format("No buffer named '{0}' found while creating vertex specification '{1}'", descriptor->index_buffer, descriptor->identifier().name)};
             }
 
-            const status attach_status = vertex_spec->attach_index_buffer(index_buffer_state->gl_id());
+            const status attach_status = vertex_spec->attach_index_buffer(object_identifier(descriptor->index_buffer).hash, index_buffer_state->gl_id(), index_buffer_state->gl_offset());
 
             if (is_status_error(attach_status))
             {
@@ -505,11 +1119,169 @@ namespace stardraw::gl45
         return record_object_state(descriptor->identifier(), new draw_specification_state(*descriptor, vertex_spec->has_index_buffer()));
     }
 
+    status render_context::create_parameter_set_state(const parameter_set_descriptor* descriptor)
+    {
+        const shader_state* shader = find_shader_state(object_identifier(descriptor->shader));
+        if (shader == nullptr) return {status_type::UNKNOWN, std::format("Referenced shader '{0}' not found in context", descriptor->shader)};
+
+        parameter_set_state* set = new parameter_set_state(*descriptor);
+
+        //Sets for shaders that are still compiling resolve when they're first bound.
+        if (!shader->is_pending())
+        {
+            const status resolve_status = resolve_parameter_set(set);
+            if (is_status_error(resolve_status))
+            {
+                delete set;
+                return resolve_status;
+            }
+        }
+
+        return record_object_state(descriptor->identifier(), set);
+    }
+
+    //Finds how many bytes of uniform data the constant buffer containing a plain data location holds.
+    static status data_block_size(const shader_parameter_location& location, u32& out_bytes)
+    {
+        const shader_parameter_reflection* reflection = location.reflection;
+        if (reflection->binding_kind != slang::TypeReflection::Kind::ConstantBuffer && reflection->binding_kind != slang::TypeReflection::Kind::ParameterBlock)
+        {
+            return {status_type::UNSUPPORTED, "Plain data in a parameter set must live in a constant buffer or parameter block"};
+        }
+
+        for (const shader_parameter_reflection& entry : location.table->entries | std::views::values)
+        {
+            if (!entry.is_binding || entry.set != reflection->set || entry.slot != reflection->slot) continue;
+            //Uniform blocks are sized in 16 byte steps.
+            out_bytes = (std::max(entry.size, entry.element_stride) + 15) & ~15u;
+            return status_type::SUCCESS;
+        }
+
+        return {status_type::UNKNOWN, "Constant buffer containing a parameter set's plain data not found in shader"};
+    }
+
+    status render_context::resolve_parameter_set(parameter_set_state* set)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Resolve parameter set");
+
+        shader_state* shader = find_shader_state(set->shader);
+        if (shader == nullptr) return {status_type::UNKNOWN, std::format("Shader object '{0}' not found in context (referenced by parameter set)", set->shader.name)};
+        if (shader->is_pending()) return {status_type::PENDING, std::format("Shader object '{0}' is still compiling (referenced by parameter set)", set->shader.name)};
+        if (!shader->is_valid()) return {status_type::INVALID, std::format("Shader object '{0}' is in an invalid state (referenced by parameter set)", set->shader.name)};
+
+        set->clear_binds();
+
+        //Plain data is packed into one block per constant buffer, keyed by the slot it's bound to.
+        std::map<GLuint, std::vector<u8>> data_blocks;
+        std::unordered_set<GLuint> buffer_slots;
+
+        for (const shader_parameter& parameter : set->parameters)
+        {
+            const shader_parameter_location location = shader->relocate_parameter(parameter.location);
+            const shader_parameter_reflection* reflection = location.reflection;
+            if (reflection == nullptr)
+            {
+                set->clear_binds();
+                return {status_type::UNKNOWN, std::format("Parameter set location not found in shader '{0}'", set->shader.name)};
+            }
+
+            const GLuint actual_slot = reflection->slot + shader->descriptor_set_binding_offsets[reflection->set];
+            const shader_parameter_value& value = parameter.value;
+            status resolve_status = status_type::SUCCESS;
+
+            switch (value.type)
+            {
+                case shader_parameter_value::value_type::TEXTURE_REFERENCE:
+                case shader_parameter_value::value_type::IMAGE_REFERENCE:
+                {
+                    const bool as_image = value.type == shader_parameter_value::value_type::IMAGE_REFERENCE;
+                    const texture_state* texture = find_texture_state(object_identifier(value.opaque_reference));
+                    resolve_status = validate_texture_parameter(reflection, value, texture, as_image);
+                    set->binds.push_back({.type = as_image ? parameter_set_state::slot_bind::bind_type::IMAGE : parameter_set_state::slot_bind::bind_type::TEXTURE, .slot = actual_slot, .texture = texture, .value = &value});
+                    break;
+                }
+                case shader_parameter_value::value_type::BUFFER_REFERENCE:
+                {
+                    GLenum target = 0;
+                    resolve_status = buffer_parameter_target(reflection, target);
+                    const buffer_state* buffer = find_buffer_state(object_identifier(value.opaque_reference));
+                    if (is_status_error(resolve_status)) break;
+                    if (buffer == nullptr) resolve_status = {status_type::UNKNOWN, std::format("Buffer object '{0}' not found in context (referenced by parameter set)", value.opaque_reference)};
+                    else if (!buffer->is_valid()) resolve_status = {status_type::INVALID, std::format("Buffer object '{0}' is in an invalid state (referenced by parameter set)", value.opaque_reference)};
+
+                    set->binds.push_back({.type = parameter_set_state::slot_bind::bind_type::BUFFER, .slot = actual_slot, .buffer_target = target, .buffer = buffer, .buffer_hash = object_identifier(value.opaque_reference).hash});
+                    buffer_slots.insert(actual_slot);
+                    break;
+                }
+                default:
+                {
+                    u32 block_bytes = 0;
+                    resolve_status = data_block_size(location, block_bytes);
+                    if (is_status_error(resolve_status)) break;
+
+                    std::vector<u8>& block = data_blocks[actual_slot];
+                    if (block.size() < block_bytes) block.resize(block_bytes, 0);
+                    if (location.byte_address + value.bytes.size() > block.size())
+                    {
+                        resolve_status = {status_type::RANGE_OVERFLOW, std::format("Parameter set data overflows its constant buffer in shader '{0}'", set->shader.name)};
+                        break;
+                    }
+
+                    memcpy(block.data() + location.byte_address, value.bytes.data(), value.bytes.size());
+                    break;
+                }
+            }
+
+            if (is_status_error(resolve_status))
+            {
+                set->clear_binds();
+                return resolve_status;
+            }
+        }
+
+        for (const auto& [slot, data] : data_blocks)
+        {
+            status block_status = status_type::SUCCESS;
+            if (buffer_slots.contains(slot)) block_status = {status_type::INVALID, std::format("Parameter set for shader '{0}' both binds a buffer to slot {1} and sets plain data in it", set->shader.name, slot)};
+            else block_status = set->add_data_block(slot, data);
+
+            if (is_status_error(block_status))
+            {
+                set->clear_binds();
+                return block_status;
+            }
+        }
+
+        set->resolved_generation = binding_generation;
+        return status_type::SUCCESS;
+    }
+
     status render_context::bind_vertex_specification_state(const object_identifier& source)
     {
         const vertex_specification_state* state = find_vertex_specification_state(source);
         if (state == nullptr) return {status_type::UNKNOWN, std::format("No vertex specification with name '{0}' exists in context", source.name)};
         if (!state->is_valid()) return {status_type::INVALID, std::format("Vertex specification object '{0}' is in an invalid state", source.name)};
+
+        if (objects.contains(descriptor_type::BUFFER))
+        {
+            const std::unordered_map<u64, object_state*>& buffers = objects[descriptor_type::BUFFER];
+            for (const vertex_specification_state::vertex_buffer_attachment& attachment : state->vertex_buffers)
+            {
+                if (buffers.contains(attachment.buffer_hash)) mark_used(buffers.at(attachment.buffer_hash));
+            }
+            if (state->has_index_buffer() && buffers.contains(state->index_buffer_hash)) mark_used(buffers.at(state->index_buffer_hash));
+        }
+
+        //Binding a vertex array replaces every vertex and index buffer binding at once.
+        std::erase_if(bound_buffers, [](const std::pair<const u64, u64>& binding)
+        {
+            const GLenum target = static_cast<GLenum>(binding.first >> 32);
+            return target == GL_ARRAY_BUFFER || target == GL_ELEMENT_ARRAY_BUFFER;
+        });
+        for (const vertex_specification_state::vertex_buffer_attachment& attachment : state->vertex_buffers) note_buffer_binding(GL_ARRAY_BUFFER, attachment.slot, attachment.buffer_hash);
+        if (state->has_index_buffer()) note_buffer_binding(GL_ELEMENT_ARRAY_BUFFER, 0, state->index_buffer_hash);
+
         return state->bind();
     }
 
@@ -520,11 +1292,13 @@ namespace stardraw::gl45
 
         status vertex_specification_bind = bind_vertex_specification_state(state->vertex_specification);
         if (is_status_error(vertex_specification_bind)) return vertex_specification_bind;
+        active_index_buffer_offset = find_vertex_specification_state(state->vertex_specification)->index_buffer_offset;
 
         status shader_bind = bind_shader(state->shader);
         if (is_status_error(shader_bind)) return shader_bind;
 
         active_draw_specification = state;
+        active_shader_pending = shader_bind.type == status_type::PENDING;
 
         return status_type::SUCCESS;
     }
@@ -533,6 +1307,8 @@ namespace stardraw::gl45
     {
         const buffer_state* buffer_state = find_buffer_state(source);
         if (buffer_state == nullptr) return {status_type::UNKNOWN, std::format("No buffer with name '{0}' exists in context", source.name)};
+        mark_used(buffer_state);
+        note_buffer_binding(target, 0, source.hash);
         return buffer_state->bind_to(target);
     }
 
@@ -540,6 +1316,16 @@ namespace stardraw::gl45
     {
         shader_state* shader = find_shader_state(source);
         if (shader == nullptr) return {status_type::UNKNOWN, std::format("Shader object '{0}' not found in context", source.name)};
+
+        const status compile_status = shader->poll_compile();
+        if (compile_status.type == status_type::PENDING)
+        {
+            //Only fall back one level, so fallback chains can't loop.
+            const shader_state* fallback = shader->fallback_shader.empty() ? nullptr : find_shader_state(object_identifier(shader->fallback_shader));
+            if (fallback != nullptr && fallback->is_valid() && !fallback->is_pending() && fallback->fallback_shader != source.name) return bind_shader(object_identifier(shader->fallback_shader));
+            return {status_type::PENDING, std::format("Shader object '{0}' is still compiling", source.name)};
+        }
+        if (is_status_error(compile_status)) return compile_status;
         if (!shader->is_valid()) return {status_type::INVALID, std::format("Shader object '{0}' is in an invalid state", source.name)};
 
         status activate_status = shader->make_active();
@@ -582,13 +1368,12 @@ namespace stardraw::gl45
         return status_type::SUCCESS;
     }
 
-    status render_context::bind_shader_texture_parameter(shader_state* shader, const shader_parameter_location& location, const shader_parameter_value& value, const bool as_image = false)
+    status render_context::validate_texture_parameter(const shader_parameter_reflection* reflection, const shader_parameter_value& value, const texture_state* texture, const bool as_image)
     {
-        const binding_location_info binding_info = vk_binding_for_location(location);
-        const u32 actual_slot = binding_info.slot + shader->descriptor_set_binding_offsets[binding_info.set];
+        if (reflection == nullptr) return {status_type::UNKNOWN, "Shader parameter location not found in shader"};
 
         //To bind a texture, we make sure the location is *explicitly* pointed at the texture variable, not something contained inside the texture.
-        if (binding_info.binding_type != location.offset_ptr)
+        if (!reflection->is_binding)
         {
             return {status_type::UNSUPPORTED, "The shader parameter location provided cannot have a texture bound to it!"};
         }
@@ -596,11 +1381,11 @@ namespace stardraw::gl45
         texture_shape resource_shape;
         bool is_array;
 
-        switch (binding_info.binding_type->getKind())
+        switch (reflection->binding_kind)
         {
             case slang::TypeReflection::Kind::Resource:
             {
-                const u32 shape = binding_info.binding_type->getResourceShape() & ~SlangResourceShape::SLANG_TEXTURE_COMBINED_FLAG;
+                const u32 shape = reflection->resource_shape & ~SlangResourceShape::SLANG_TEXTURE_COMBINED_FLAG;
                 switch (shape)
                 {
                     case SlangResourceShape::SLANG_TEXTURE_1D_ARRAY: is_array = true;
@@ -639,18 +1424,34 @@ namespace stardraw::gl45
             }
         }
 
-        const texture_state* texture = find_texture_state(object_identifier(value.opaque_reference));
         if (texture == nullptr) return {status_type::UNKNOWN, std::format("Texture object '{0}' not found in context (referenced by shader parameter)", value.opaque_reference)};
         if (!texture->is_valid()) return {status_type::INVALID, std::format("Texture object '{0}' is in an invalid state (referenced by shader parameter)", value.opaque_reference)};
         if (texture->get_shape() != resource_shape) return {status_type::INVALID, std::format("Texture object '{0}' can't be bound to this location - wrong texture shape!", value.opaque_reference)};
 
-        status bind_status = status_type::SUCCESS;
         if (as_image)
         {
-            const SlangResourceAccess access = binding_info.binding_type->getResourceAccess();
+            const SlangResourceAccess access = reflection->resource_access;
             if (access == SlangResourceAccess::SLANG_RESOURCE_ACCESS_READ && value.image_access == shader_parameter_value::image_texture_access::WRITE_ONLY) return {status_type::INVALID, std::format("Can't bind texture object '{0}' as image texture - binding location has readonly access, but parameter access is writeonly", value.opaque_reference)};
             if (access == SlangResourceAccess::SLANG_RESOURCE_ACCESS_WRITE && value.image_access == shader_parameter_value::image_texture_access::READ_ONLY) return {status_type::INVALID, std::format("Can't bind texture object '{0}' as image texture - binding location has writeonly access, but parameter access is readonly", value.opaque_reference)};
             if (access == SlangResourceAccess::SLANG_RESOURCE_ACCESS_READ_WRITE && value.image_access != shader_parameter_value::image_texture_access::READ_WRITE) return {status_type::INVALID, std::format("Can't bind texture object '{0}' as image texture - binding location has readwrite access, but parameter access is not readwrite", value.opaque_reference)};
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    status render_context::bind_shader_texture_parameter(shader_state* shader, const shader_parameter_location& location, const shader_parameter_value& value, const bool as_image = false)
+    {
+        const shader_parameter_reflection* reflection = location.reflection;
+        const texture_state* texture = find_texture_state(object_identifier(value.opaque_reference));
+        const status validate_status = validate_texture_parameter(reflection, value, texture, as_image);
+        if (is_status_error(validate_status)) return validate_status;
+
+        const u32 actual_slot = reflection->slot + shader->descriptor_set_binding_offsets[reflection->set];
+        mark_used(texture);
+
+        status bind_status = status_type::SUCCESS;
+        if (as_image)
+        {
             bind_status = texture->bind_to_image_slot(actual_slot, value.image_texture_mipmap, value.image_texture_layer, value.image_texture_array, value.image_access);
         }
         else
@@ -663,40 +1464,38 @@ namespace stardraw::gl45
         return status_type::SUCCESS;
     }
 
-    status render_context::bind_shader_buffer_parameter(shader_state* shader, const shader_parameter_location& location, const shader_parameter_value& value)
+    status render_context::buffer_parameter_target(const shader_parameter_reflection* reflection, GLenum& out_target)
     {
-        const binding_location_info binding_info = vk_binding_for_location(location);
-        const u32 actual_slot = binding_info.slot + shader->descriptor_set_binding_offsets[binding_info.set];
-        GLenum binding_type = 0;
+        if (reflection == nullptr) return {status_type::UNKNOWN, "Shader parameter location not found in shader"};
 
         //To bind a buffer, we make sure the location is *explicitly* pointed at the buffer variable, not something contained inside the buffer.
-        if (binding_info.binding_type != location.offset_ptr)
+        if (!reflection->is_binding)
         {
             return {status_type::UNSUPPORTED, "The shader parameter location provided cannot have a buffer bound to it!"};
         }
 
-        switch (binding_info.binding_type->getKind())
+        switch (reflection->binding_kind)
         {
             case slang::TypeReflection::Kind::ParameterBlock:
             case slang::TypeReflection::Kind::ConstantBuffer:
             {
-                binding_type = GL_UNIFORM_BUFFER;
-                break;
+                out_target = GL_UNIFORM_BUFFER;
+                return status_type::SUCCESS;
             }
 
             case slang::TypeReflection::Kind::ShaderStorageBuffer:
             {
-                binding_type = GL_SHADER_STORAGE_BUFFER;
-                break;
+                out_target = GL_SHADER_STORAGE_BUFFER;
+                return status_type::SUCCESS;
             }
 
             case slang::TypeReflection::Kind::Resource:
             {
-                const SlangResourceShape shape = binding_info.binding_type->getResourceShape();
+                const SlangResourceShape shape = reflection->resource_shape;
                 if (shape == SLANG_STRUCTURED_BUFFER || shape == SLANG_BYTE_ADDRESS_BUFFER)
                 {
-                    binding_type = GL_SHADER_STORAGE_BUFFER;
-                    break;
+                    out_target = GL_SHADER_STORAGE_BUFFER;
+                    return status_type::SUCCESS;
                 }
 
                 //fallthrough to unsupported
@@ -706,20 +1505,32 @@ namespace stardraw::gl45
                 return {status_type::UNSUPPORTED, "The shader parameter location provided cannot have a buffer bound to it!"};
             }
         }
+    }
+
+    status render_context::bind_shader_buffer_parameter(shader_state* shader, const shader_parameter_location& location, const shader_parameter_value& value)
+    {
+        const shader_parameter_reflection* reflection = location.reflection;
+        GLenum binding_type = 0;
+        const status target_status = buffer_parameter_target(reflection, binding_type);
+        if (is_status_error(target_status)) return target_status;
+        const u32 actual_slot = reflection->slot + shader->descriptor_set_binding_offsets[reflection->set];
 
         const buffer_state* buffer = find_buffer_state(object_identifier(value.opaque_reference));
         if (buffer == nullptr) return {status_type::UNKNOWN, std::format("Buffer object '{0}' not found in context (referenced by shader parameter)", value.opaque_reference)};
         if (!buffer->is_valid()) return {status_type::INVALID, std::format("Buffer object '{0}' is in an invalid state (referenced by shader parameter)", value.opaque_reference)};
+        mark_used(buffer);
         status bind_status = buffer->bind_to_slot(binding_type, actual_slot);
         if (is_status_error(bind_status)) return bind_status;
+        note_buffer_binding(binding_type, actual_slot, object_identifier(value.opaque_reference).hash);
         shader->bound_objects[actual_slot] = value.opaque_reference;
         return status_type::SUCCESS;
     }
 
     status render_context::bind_shader_data_parameter(shader_state* shader, const shader_parameter_location& location, shader_parameter_value& value)
     {
-        const binding_location_info binding_info = vk_binding_for_location(location);
-        const u32 actual_slot = binding_info.slot + shader->descriptor_set_binding_offsets[binding_info.set];
+        const shader_parameter_reflection* reflection = location.reflection;
+        if (reflection == nullptr) return {status_type::UNKNOWN, "Shader parameter location not found in shader"};
+        const u32 actual_slot = reflection->slot + shader->descriptor_set_binding_offsets[reflection->set];
 
         if (!shader->bound_objects.contains(actual_slot))
         {
@@ -735,6 +1546,7 @@ namespace stardraw::gl45
         if (!objects.contains(state->object_type())) objects[state->object_type()] = {};
         if (objects[state->object_type()].contains(identifier.hash)) return {status_type::DUPLICATE, std::format("An object of this type with the name '{0}' already exists (or there is a hash collision)!", identifier.name)};
         objects[state->object_type()][identifier.hash] = state;
+        mark_used(state);
         return status_type::SUCCESS;
     }
 }
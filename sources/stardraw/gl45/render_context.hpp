@@ -1,10 +1,17 @@
 #pragma once
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 
+#include "async_upload_ring.hpp"
+#include "push_constant_ring.hpp"
+#include "staging_buffer_downloader.hpp"
 #include "types.hpp"
+#include "upload_scheduler.hpp"
+#include "object_states/buffer_pool_state.hpp"
 #include "object_states/buffer_state.hpp"
 #include "object_states/draw_specification_state.hpp"
+#include "object_states/parameter_set_state.hpp"
 #include "object_states/shader_state.hpp"
 #include "object_states/texture_state.hpp"
 #include "object_states/vertex_specification_state.hpp"
@@ -29,6 +36,9 @@ namespace stardraw::gl45
         [[nodiscard]] status create_objects(const descriptor_list&& descriptors) override;
         [[nodiscard]] status delete_object(const descriptor_type type, const std::string_view& name) override;
 
+        [[nodiscard]] status get_shader_status(const std::string_view& name) override;
+        [[nodiscard]] status apply_shader_reloads() override;
+
         [[nodiscard]] signal_status check_signal(const std::string_view& name) override;
         [[nodiscard]] signal_status wait_signal(const std::string_view& name, u64 timeout) override;
 
@@ -37,8 +47,41 @@ namespace stardraw::gl45
 
         [[nodiscard]] status prepare_texture_memory_transfer(const texture_memory_transfer_info& info, memory_transfer_handle** out_handle) override;
         [[nodiscard]] status flush_texture_memory_transfer(memory_transfer_handle* handle) override;
+
+        [[nodiscard]] status resize_buffer(const std::string_view& name, const u64 new_size, const bool preserve) override;
+        [[nodiscard]] status ensure_buffer_size(const std::string_view& name, const u64 min_size, const bool preserve) override;
+        [[nodiscard]] status get_buffer_pool_info(const std::string_view& name, buffer_pool_info* out_info) override;
+
+        [[nodiscard]] status set_memory_budget(const u64 bytes) override;
+        [[nodiscard]] status get_memory_usage(memory_usage_info* out_info) override;
+        [[nodiscard]] status get_object_memory_usage(const descriptor_type type, const std::string_view& name, u64* out_bytes) override;
+        [[nodiscard]] status set_object_evictable(const descriptor_type type, const std::string_view& name, const object_eviction_callback& callback) override;
+        [[nodiscard]] status evict_objects(const u64 target_bytes) override;
+
+        [[nodiscard]] status configure_async_uploads(const u64 ring_bytes) override;
+        [[nodiscard]] status set_upload_budget(const u64 bytes_per_frame) override;
+        [[nodiscard]] status get_upload_queue_info(upload_queue_info* out_info) override;
+        [[nodiscard]] status process_memory_transfers() override;
+        [[nodiscard]] signal_status wait_memory_transfer(memory_transfer_handle* handle, const u64 timeout_nanos) override;
     private:
         [[nodiscard]] static status status_from_last_gl_error();
+        [[nodiscard]] status flush_async_uploads();
+        [[nodiscard]] status flush_scheduled_uploads();
+
+        [[nodiscard]] memory_usage_info compute_memory_usage();
+        [[nodiscard]] static u64 object_memory_usage(const object_state* state);
+        [[nodiscard]] bool has_pending_transfers(const descriptor_type type, const u64 hash);
+        [[nodiscard]] status enforce_memory_budget();
+        void fence_tracked_ranges();
+        void record_bound_buffer_reads();
+        void note_buffer_binding(GLenum target, GLuint slot, u64 buffer_hash);
+        void poll_pending_shaders();
+        void poll_reloading_shaders();
+
+        inline void mark_used(const object_state* state)
+        {
+            if (state != nullptr) state->last_used = ++use_counter;
+        }
 
 
         [[nodiscard]] status execute_command(const command* cmd);
@@ -47,6 +90,10 @@ namespace stardraw::gl45
         [[nodiscard]] status execute_draw_indirect(const draw_indirect_command* cmd) const;
         [[nodiscard]] status execute_draw_indexed_indirect(const draw_indexed_indirect_command* cmd) const;
         [[nodiscard]] status execute_buffer_copy(const buffer_copy_command* cmd);
+        [[nodiscard]] status execute_texture_copy(const texture_copy_command* cmd);
+        [[nodiscard]] status execute_clear_buffer(const clear_buffer_command* cmd);
+        [[nodiscard]] status execute_buffer_to_texture_copy(const buffer_to_texture_copy_command* cmd);
+        [[nodiscard]] status execute_texture_to_buffer_copy(const texture_to_buffer_copy_command* cmd);
         [[nodiscard]] status execute_draw_config(const draw_config_command* cmd);
         [[nodiscard]] static status execute_config_blending(const blending_config_command* cmd);
         [[nodiscard]] static status execute_config_stencil(const stencil_config_command* cmd);
@@ -56,15 +103,19 @@ namespace stardraw::gl45
         [[nodiscard]] static status execute_config_depth_range(const depth_range_config_command* cmd);
         [[nodiscard]] static status execute_clear_window(const clear_window_command* cmd);
         [[nodiscard]] status execute_shader_parameters_upload(const shader_config_command* cmd);
+        [[nodiscard]] status execute_push_constants(const push_constants_command* cmd);
+        [[nodiscard]] status execute_parameter_set(const parameter_set_command* cmd);
         [[nodiscard]] status execute_signal(const signal_command* cmd);
 
         [[nodiscard]] status create_object(const descriptor* descriptor);
         [[nodiscard]] status create_buffer_state(const buffer_descriptor* descriptor);
+        [[nodiscard]] status create_buffer_pool_state(const buffer_pool_descriptor* descriptor);
         [[nodiscard]] status create_shader_state(const shader_descriptor* descriptor);
         [[nodiscard]] status create_texture_state(const texture_descriptor* descriptor);
         [[nodiscard]] status create_texture_sampler_state(const texture_sampler_descriptor* descriptor);
         [[nodiscard]] status create_vertex_specification_state(const vertex_specification_descriptor* descriptor);
         [[nodiscard]] status create_draw_specification_state(const draw_specification_descriptor* descriptor);
+        [[nodiscard]] status create_parameter_set_state(const parameter_set_descriptor* descriptor);
 
         [[nodiscard]] status bind_vertex_specification_state(const object_identifier& source);
         [[nodiscard]] status bind_draw_specification_state(const object_identifier& source);
@@ -73,6 +124,9 @@ namespace stardraw::gl45
         [[nodiscard]] status bind_shader_texture_parameter(shader_state* shader, const shader_parameter_location& location, const shader_parameter_value& value, bool as_image);
         [[nodiscard]] status bind_shader_buffer_parameter(shader_state* shader, const shader_parameter_location& location, const shader_parameter_value& value);
         [[nodiscard]] status bind_shader_data_parameter(shader_state* shader, const shader_parameter_location& location, shader_parameter_value& value);
+        [[nodiscard]] static status validate_texture_parameter(const shader_parameter_reflection* reflection, const shader_parameter_value& value, const texture_state* texture, const bool as_image);
+        [[nodiscard]] static status buffer_parameter_target(const shader_parameter_reflection* reflection, GLenum& out_target);
+        [[nodiscard]] status resolve_parameter_set(parameter_set_state* set);
 
         status record_object_state(const object_identifier& identifier, object_state* state);
 
@@ -98,6 +152,11 @@ namespace stardraw::gl45
             return find_object_state<buffer_state, descriptor_type::BUFFER>(identifier);
         }
 
+        [[nodiscard]] inline buffer_pool_state* find_buffer_pool_state(const object_identifier& identifier)
+        {
+            return find_object_state<buffer_pool_state, descriptor_type::BUFFER_POOL>(identifier);
+        }
+
         [[nodiscard]] inline shader_state* find_shader_state(const object_identifier& identifier)
         {
             return find_object_state<shader_state, descriptor_type::SHADER>(identifier);
@@ -118,12 +177,50 @@ namespace stardraw::gl45
             return find_object_state<draw_specification_state, descriptor_type::DRAW_SPECIFICATION>(identifier);
         }
 
+        [[nodiscard]] inline parameter_set_state* find_parameter_set_state(const object_identifier& identifier)
+        {
+            return find_object_state<parameter_set_state, descriptor_type::PARAMETER_SET>(identifier);
+        }
+
         window* parent_window;
         std::unordered_map<std::string, command_list> command_lists;
         std::unordered_map<descriptor_type, std::unordered_map<u64, object_state*>> objects;
         std::unordered_map<std::string, signal_state> signals;
         std::unordered_map<memory_transfer_handle*, buffer_memory_transfer_info> buffer_transfers;
         std::unordered_map<memory_transfer_handle*, texture_memory_transfer_info> texture_transfers;
+        staging_buffer_downloader readback_downloader;
+        async_upload_ring async_uploader;
+        upload_scheduler scheduled_uploader;
+        push_constant_ring push_constants;
+        //The push constant block as last written. Every push re-uploads all of it, so partial writes keep the rest of the block.
+        std::array<u8, max_push_constant_bytes> push_constant_data = {};
+        struct evictable_object
+        {
+            std::string name;
+            object_eviction_callback callback;
+        };
+
+        std::unordered_map<descriptor_type, std::unordered_map<u64, evictable_object>> evictable_objects;
+        //Buffers that have had tracked uploads, and so need their touched ranges fenced at every fence point.
+        std::unordered_set<u64> range_tracked_buffers;
+        //Buffer bound at each binding point draws can read from, keyed by (target << 32 | slot). Bindings outlive command buffers, so every fence point after a draw records these as read.
+        std::unordered_map<u64, u64> bound_buffers;
+        //Set when a draw executes, cleared at the next fence point.
+        bool draws_since_fence = false;
+        //Shaders with asynchronous compiles in flight, polled whenever command buffers are executed.
+        std::unordered_set<u64> pending_shaders;
+        //Replacements for shaders whose programs were hot reloaded. The old state keeps drawing until its replacement finishes compiling.
+        std::unordered_map<u64, shader_state*> reloading_shaders;
+        //Last hot reload generation this context has rebuilt its shaders for.
+        u64 seen_shader_reload_generation;
+        bool parallel_compile_configured = false;
+        //Set while the bound draw specification's shader is still compiling (and has no fallback), so draws are skipped.
+        bool active_shader_pending = false;
+        u64 memory_budget = 0;
+        u64 use_counter = 0;
+        //Bumped whenever a buffer, texture or shader state is deleted or replaced, so parameter sets holding pointers to them resolve again.
+        u64 binding_generation = 1;
         const draw_specification_state* active_draw_specification = nullptr;
+        GLintptr active_index_buffer_offset = 0;
     };
 }
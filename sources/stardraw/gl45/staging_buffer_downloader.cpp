@@ -0,0 +1,171 @@
+#include "staging_buffer_downloader.hpp"
+
+#include <format>
+#include <ranges>
+
+#include <tracy/Tracy.hpp>
+#include <tracy/TracyOpenGL.hpp>
+
+#include "gl_headers.hpp"
+#include "../../../libraries/starlib/sources/starlib/types/block_allocator.hpp"
+
+namespace stardraw::gl45
+{
+    status staging_buffer_downloader::allocate_download(const u64 bytes, const memory_transfer_ready_callback& callback, gl_memory_transfer_handle** out_handle)
+    {
+        u64 chunk_address;
+        bool has_space = chunk_allocator.try_allocate(bytes, chunk_address);
+        if (!has_space)
+        {
+            status new_buffer_status = allocate_new_staging_buffer(std::max(bytes, active_staging_buffer_size) * 2);
+            if (is_status_error(new_buffer_status)) return new_buffer_status;
+            has_space = chunk_allocator.try_allocate(bytes, chunk_address);
+        }
+
+        if (!has_space) return {status_type::BACKEND_ERROR, "Unable to allocate space for staged memory download"};
+
+        gl_memory_transfer_handle* handle = new gl_memory_transfer_handle();
+        chunks.emplace_back(new download_chunk(chunk_address, active_staging_buffer_id, nullptr, handle));
+        staging_buffer_refcounts[active_staging_buffer_id]++;
+        handle->transfer_buffer_ptr = active_staging_buffer_ptr + chunk_address;
+        handle->transfer_size = bytes;
+        handle->transfer_buffer_address = chunk_address;
+        handle->transfer_buffer_id = active_staging_buffer_id;
+        handle->sync_ptr = &chunks.back()->fence;
+        handle->is_download = true;
+        handle->ready_callback = callback;
+        handle->current_status = memory_transfer_status::PENDING;
+        *out_handle = handle;
+
+        return status_type::SUCCESS;
+    }
+
+    void staging_buffer_downloader::fence_download(const gl_memory_transfer_handle* handle)
+    {
+        *handle->sync_ptr = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    void staging_buffer_downloader::update_downloads()
+    {
+        ZoneScoped;
+        std::vector<gl_memory_transfer_handle*> ready_handles;
+        for (const download_chunk* chunk : chunks)
+        {
+            if (chunk->fence == nullptr || chunk->handle->current_status != memory_transfer_status::PENDING) continue;
+            const GLenum status = glClientWaitSync(chunk->fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+            chunk->handle->current_status = memory_transfer_status::READY;
+            ready_handles.push_back(chunk->handle);
+        }
+
+        //Callbacks are invoked after the scan, so they're free to transfer and flush their own handle.
+        for (gl_memory_transfer_handle* handle : ready_handles)
+        {
+            if (handle->ready_callback) handle->ready_callback(handle);
+        }
+    }
+
+    signal_status staging_buffer_downloader::wait_download(gl_memory_transfer_handle* handle, const u64 timeout)
+    {
+        ZoneScoped;
+        if (handle->current_status != memory_transfer_status::PENDING) return signal_status::SIGNALLED;
+        if (handle->sync_ptr == nullptr || *handle->sync_ptr == nullptr) return signal_status::NOT_SIGNALLED;
+
+        const GLenum status = glClientWaitSync(*handle->sync_ptr, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        switch (status)
+        {
+            case GL_ALREADY_SIGNALED:
+            case GL_CONDITION_SATISFIED:
+            {
+                update_downloads();
+                return signal_status::SIGNALLED;
+            }
+            case GL_TIMEOUT_EXPIRED: return signal_status::TIMED_OUT;
+            default: return signal_status::NOT_SIGNALLED;
+        }
+    }
+
+    status staging_buffer_downloader::free_download(const gl_memory_transfer_handle* handle)
+    {
+        const auto chunk_it = std::ranges::find_if(chunks, [handle](const download_chunk* chunk) { return chunk->handle == handle; });
+        if (chunk_it == chunks.end()) return {status_type::UNKNOWN, "Download handle is not owned by this downloader - this is an internal bug!"};
+        download_chunk* chunk = *chunk_it;
+        chunks.erase(chunk_it);
+
+        //Any copy into the chunk that is still in flight will complete before a later copy reuses the memory, so the range can be released straight away.
+        if (chunk->fence != nullptr) glDeleteSync(chunk->fence);
+        if (chunk->staging_buffer_id == active_staging_buffer_id) chunk_allocator.free(chunk->address);
+
+        staging_buffer_refcounts[chunk->staging_buffer_id]--;
+        if (staging_buffer_refcounts[chunk->staging_buffer_id] == 0 && chunk->staging_buffer_id != active_staging_buffer_id)
+        {
+            glDeleteBuffers(1, &chunk->staging_buffer_id);
+            staging_buffer_refcounts.erase(chunk->staging_buffer_id);
+            staging_buffer_sizes.erase(chunk->staging_buffer_id);
+        }
+
+        delete chunk;
+        delete handle;
+        return status_type::SUCCESS;
+    }
+
+    u64 staging_buffer_downloader::allocated_bytes() const
+    {
+        u64 total = 0;
+        for (const u64 size : staging_buffer_sizes | std::views::values) total += size;
+        return total;
+    }
+
+    staging_buffer_downloader::~staging_buffer_downloader()
+    {
+        for (const download_chunk* chunk : chunks)
+        {
+            if (chunk->fence != nullptr) glDeleteSync(chunk->fence);
+            delete chunk->handle;
+            delete chunk;
+        }
+
+        for (const auto& staging_buff : staging_buffer_refcounts | std::views::keys)
+        {
+            glDeleteBuffers(1, &staging_buff);
+        }
+    }
+
+    status staging_buffer_downloader::allocate_new_staging_buffer(const u64 size)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Allocate readback buffer");
+
+        if (active_staging_buffer_id != 0 && staging_buffer_refcounts[active_staging_buffer_id] == 0)
+        {
+            glDeleteBuffers(1, &active_staging_buffer_id);
+            staging_buffer_refcounts.erase(active_staging_buffer_id);
+            staging_buffer_sizes.erase(active_staging_buffer_id);
+        }
+
+        glCreateBuffers(1, &active_staging_buffer_id);
+        if (active_staging_buffer_id == 0) return {status_type::BACKEND_ERROR, std::format("Unable to create staging buffer for download")};
+
+        //Client storage keeps the ring in host memory, which is the right place for data the CPU reads back.
+        constexpr GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glNamedBufferStorage(active_staging_buffer_id, size, nullptr, flags | GL_CLIENT_STORAGE_BIT);
+
+        active_staging_buffer_ptr = static_cast<GLbyte*>(glMapNamedBufferRange(active_staging_buffer_id, 0, size, flags));
+        if (active_staging_buffer_ptr == nullptr)
+        {
+            glDeleteBuffers(1, &active_staging_buffer_id);
+            active_staging_buffer_id = 0;
+            active_staging_buffer_ptr = nullptr;
+            active_staging_buffer_size = 0;
+            return {status_type::BACKEND_ERROR, std::format("Unable to map staging buffer for download")};
+        }
+
+        active_staging_buffer_size = size;
+        staging_buffer_refcounts[active_staging_buffer_id] = 0;
+        staging_buffer_sizes[active_staging_buffer_id] = size;
+
+        chunk_allocator.resize(size);
+        chunk_allocator.clear();
+        return status_type::SUCCESS;
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "gl_headers.hpp"
+#include "types.hpp"
+#include "stardraw/api/types.hpp"
+#include "../../../libraries/starlib/sources/starlib/types/block_allocator.hpp"
+
+namespace stardraw::gl45
+{
+    //Readback ring for downloads. GPU copies land in a persistently mapped staging buffer and are fenced; handles become READY once their fence has signalled.
+    class staging_buffer_downloader
+    {
+    public:
+        status allocate_download(const u64 bytes, const memory_transfer_ready_callback& callback, gl_memory_transfer_handle** out_handle);
+        static void fence_download(const gl_memory_transfer_handle* handle);
+        void update_downloads();
+        signal_status wait_download(gl_memory_transfer_handle* handle, const u64 timeout);
+        status free_download(const gl_memory_transfer_handle* handle);
+        //Bytes of staging memory currently allocated, including retired staging buffers waiting on their last transfers.
+        [[nodiscard]] u64 allocated_bytes() const;
+
+        ~staging_buffer_downloader();
+    private:
+
+        struct download_chunk
+        {
+            u64 address = 0;
+            GLuint staging_buffer_id = 0;
+            GLsync fence = nullptr;
+            gl_memory_transfer_handle* handle = nullptr;
+        };
+
+        status allocate_new_staging_buffer(const u64 size);
+
+        std::vector<download_chunk*> chunks = {};
+        starlib::block_allocator chunk_allocator = starlib::block_allocator(0);
+        std::unordered_map<GLuint, u32> staging_buffer_refcounts = {};
+        std::unordered_map<GLuint, u64> staging_buffer_sizes = {};
+        GLuint active_staging_buffer_id = 0;
+        GLbyte* active_staging_buffer_ptr = nullptr;
+        u64 active_staging_buffer_size = 0;
+    };
+}
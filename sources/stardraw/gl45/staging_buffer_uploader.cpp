@@ -35,6 +35,7 @@ namespace stardraw::gl45
         handle->transfer_destination_address = address;
         handle->transfer_buffer_id = active_staging_buffer_id;
         handle->sync_ptr = &chunks.back()->fence;
+        handle->explicit_flush = explicit_flush;
         *out_handle = handle;
 
         return status_type::SUCCESS;
@@ -47,6 +48,13 @@ namespace stardraw::gl45
         return status_type::SUCCESS;
     }
 
+    u64 staging_buffer_uploader::allocated_bytes() const
+    {
+        u64 total = 0;
+        for (const u64 size : staging_buffer_sizes | std::views::values) total += size;
+        return total;
+    }
+
     staging_buffer_uploader::~staging_buffer_uploader()
     {
         for (const auto& staging_buff : staging_buffer_refcounts | std::views::keys)
@@ -71,6 +79,7 @@ namespace stardraw::gl45
             {
                 glDeleteBuffers(1, &chunk->staging_buffer_id);
                 staging_buffer_refcounts.erase(chunk->staging_buffer_id);
+                staging_buffer_sizes.erase(chunk->staging_buffer_id);
             }
 
             delete chunk;
@@ -87,10 +96,11 @@ namespace stardraw::gl45
         glCreateBuffers(1, &active_staging_buffer_id);
         if (active_staging_buffer_id == 0) return {status_type::BACKEND_ERROR, std::format("Unable to create staging buffer for upload")};
 
-        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
-        glNamedBufferStorage(active_staging_buffer_id, size, nullptr, flags);
+        const GLbitfield storage_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | (explicit_flush ? 0 : GL_MAP_COHERENT_BIT);
+        const GLbitfield map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | (explicit_flush ? GL_MAP_FLUSH_EXPLICIT_BIT : GL_MAP_COHERENT_BIT);
+        glNamedBufferStorage(active_staging_buffer_id, size, nullptr, storage_flags);
 
-        active_staging_buffer_ptr = static_cast<GLbyte*>(glMapNamedBufferRange(active_staging_buffer_id, 0, size, flags));
+        active_staging_buffer_ptr = static_cast<GLbyte*>(glMapNamedBufferRange(active_staging_buffer_id, 0, size, map_flags));
         if (active_staging_buffer_ptr == nullptr)
         {
             glDeleteBuffers(1, &active_staging_buffer_id);
@@ -100,7 +110,9 @@ namespace stardraw::gl45
             return {status_type::BACKEND_ERROR, std::format("Unable to map staging buffer for upload")};
         }
 
+        active_staging_buffer_size = size;
         staging_buffer_refcounts[active_staging_buffer_id] = 0;
+        staging_buffer_sizes[active_staging_buffer_id] = size;
 
         chunk_allocator.resize(size);
         chunk_allocator.clear();
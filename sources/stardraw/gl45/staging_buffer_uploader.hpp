@@ -9,8 +9,13 @@ namespace stardraw::gl45
     class staging_buffer_uploader
     {
     public:
+        explicit staging_buffer_uploader(const bool explicit_flush = false) : explicit_flush(explicit_flush) {}
+
         status allocate_upload(const u64 address, const u64 bytes, const u64 max_staging_buffer_size, gl_memory_transfer_handle** out_handle);
         static status flush_upload(const gl_memory_transfer_handle* handle);
+        //Bytes of staging memory currently allocated, including retired staging buffers waiting on their last transfers.
+        [[nodiscard]] u64 allocated_bytes() const;
+
         ~staging_buffer_uploader();
     private:
 
@@ -27,8 +32,10 @@ namespace stardraw::gl45
         std::vector<upload_chunk*> chunks = {};
         starlib::block_allocator chunk_allocator = starlib::block_allocator(0);
         std::unordered_map<GLuint, u32> staging_buffer_refcounts = {};
+        std::unordered_map<GLuint, u64> staging_buffer_sizes = {};
         GLuint active_staging_buffer_id = 0;
         GLbyte* active_staging_buffer_ptr = nullptr;
         u64 active_staging_buffer_size = 0;
+        bool explicit_flush = false;
     };
 }
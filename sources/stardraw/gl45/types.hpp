@@ -1,4 +1,9 @@
 #pragma once
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "stardraw/api/descriptors.hpp"
 #include "stardraw/api/memory_transfer.hpp"
@@ -88,11 +93,28 @@ namespace stardraw::gl45
     };
     #pragma pack(pop)
 
+    //Fence shared by every range it covers. The sync object is deleted with the last reference.
+    using shared_gl_fence = std::shared_ptr<std::remove_pointer_t<GLsync>>;
+
+    inline shared_gl_fence make_shared_gl_fence()
+    {
+        return shared_gl_fence(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), [](const GLsync fence) { glDeleteSync(fence); });
+    }
+
     class object_state
     {
     public:
         virtual ~object_state() = default;
         [[nodiscard]] virtual descriptor_type object_type() const = 0;
+
+        //Estimated GPU memory owned by this object (excluding staging memory).
+        [[nodiscard]] virtual u64 memory_usage() const
+        {
+            return 0;
+        }
+
+        //Stamp from the context's use counter, updated whenever the object is bound or transferred to. Used to evict least recently used objects first.
+        mutable u64 last_used = 0;
     };
 
     struct signal_state
@@ -100,17 +122,87 @@ namespace stardraw::gl45
         GLsync sync_point;
     };
 
+    struct gl_transfer_region
+    {
+        u64 source_offset;
+        u64 staging_offset;
+        u64 destination_address;
+        u64 bytes;
+    };
+
     class gl_memory_transfer_handle final : public memory_transfer_handle
     {
     public:
         status transfer(void* data) override
         {
+            if (current_status == memory_transfer_status::PENDING) return {status_type::INVALID, "Download has not completed yet - wait for the handle to become ready!"};
             if (current_status != memory_transfer_status::READY) return {status_type::INVALID, "Transfer has already been called on this handle!"};
             current_status = memory_transfer_status::TRANSFERRING;
-            memcpy(transfer_buffer_ptr, data, transfer_size);
+            if (is_download) memcpy(data, transfer_buffer_ptr, transfer_size);
+            else if (!regions.empty())
+            {
+                for (const gl_transfer_region& region : regions)
+                {
+                    memcpy(static_cast<GLbyte*>(transfer_buffer_ptr) + region.staging_offset, static_cast<const GLbyte*>(data) + region.source_offset, region.bytes);
+                }
+            }
+            else memcpy(transfer_buffer_ptr, data, transfer_size);
+            if (!is_download) record_write(0, transfer_size);
             current_status = memory_transfer_status::COMPLETE;
             return status_type::SUCCESS;
         }
+        status transfer(const memory_transfer_callback& callback) override
+        {
+            return transfer_region(0, transfer_size, callback);
+        }
+
+        status transfer_region(const u64 offset, const u64 bytes, const memory_transfer_callback& callback) override
+        {
+            if (offset > transfer_size || bytes > transfer_size - offset) return {status_type::RANGE_OVERFLOW, "Transfer region is outside the bounds of the transfer"};
+
+            memory_transfer_status expected = memory_transfer_status::READY;
+            if (!current_status.compare_exchange_strong(expected, memory_transfer_status::TRANSFERRING) && expected != memory_transfer_status::TRANSFERRING)
+            {
+                if (expected == memory_transfer_status::PENDING) return {status_type::INVALID, "Download has not completed yet - wait for the handle to become ready!"};
+                return {status_type::INVALID, "Transfer has already been completed on this handle!"};
+            }
+
+            const status callback_status = callback(static_cast<GLbyte*>(transfer_buffer_ptr) + offset, bytes);
+            if (is_status_error(callback_status)) return callback_status;
+            if (!is_download) record_write(offset, bytes);
+
+            if (cover_region(offset, bytes)) current_status = memory_transfer_status::COMPLETE;
+            return status_type::SUCCESS;
+        }
+
+        //Records a finished region, and returns true once every byte of the transfer is covered. Repeated and overlapping regions only count once.
+        bool cover_region(const u64 offset, const u64 bytes)
+        {
+            const std::lock_guard lock(covered_ranges_mutex);
+            u64 begin = offset;
+            u64 end = offset + bytes;
+
+            //Merge with every covered range touching this one, so the map only ever holds disjoint ranges.
+            auto range = covered_ranges.upper_bound(begin);
+            if (range != covered_ranges.begin() && std::prev(range)->second >= begin) range = std::prev(range);
+            while (range != covered_ranges.end() && range->first <= end)
+            {
+                begin = std::min(begin, range->first);
+                end = std::max(end, range->second);
+                covered_bytes -= range->second - range->first;
+                range = covered_ranges.erase(range);
+            }
+
+            covered_ranges[begin] = end;
+            covered_bytes += end - begin;
+            return covered_bytes >= transfer_size;
+        }
+
+        u64 transfer_bytes() override
+        {
+            return transfer_size;
+        }
+
         memory_transfer_status transfer_status() override
         {
             return current_status;
@@ -118,12 +210,69 @@ namespace stardraw::gl45
 
         ~gl_memory_transfer_handle() override = default;
 
+        void record_write(const u64 offset, const u64 bytes)
+        {
+            if (!explicit_flush || bytes == 0) return;
+            const std::lock_guard lock(written_ranges_mutex);
+            written_ranges.emplace_back(offset, bytes);
+        }
+
+        //Makes the recorded writes visible to the GL for non-coherent mappings. Overlapping and adjacent ranges are merged first.
+        void flush_mapped_writes()
+        {
+            if (!explicit_flush) return;
+            const std::lock_guard lock(written_ranges_mutex);
+            std::ranges::sort(written_ranges);
+
+            std::vector<std::pair<u64, u64>> merged_ranges;
+            for (const auto& [offset, bytes] : written_ranges)
+            {
+                if (!merged_ranges.empty() && offset <= merged_ranges.back().first + merged_ranges.back().second)
+                {
+                    auto& [merged_offset, merged_bytes] = merged_ranges.back();
+                    merged_bytes = std::max(merged_offset + merged_bytes, offset + bytes) - merged_offset;
+                    continue;
+                }
+                merged_ranges.emplace_back(offset, bytes);
+            }
+
+            for (const auto& [offset, bytes] : merged_ranges)
+            {
+                glFlushMappedNamedBufferRange(transfer_buffer_id, transfer_buffer_address + offset, bytes);
+            }
+            written_ranges.clear();
+        }
+
         void* transfer_buffer_ptr = nullptr;
         GLuint transfer_buffer_id = 0;
         u64 transfer_buffer_address = 0;
         u64 transfer_destination_address = 0;
         u64 transfer_size = 0;
         GLsync* sync_ptr = nullptr;
+        bool is_download = false;
+
+        //Scatter uploads only - staging is laid out in the caller's region order, the same packing as the source data. Copy runs are sorted by destination.
+        std::vector<gl_transfer_region> regions;
+        std::vector<gl_transfer_region> copy_runs;
+
+        memory_transfer_ready_callback ready_callback = nullptr;
+
+        //Async uploads only - resolved on the GL thread when the handle is drained from the submission queue.
+        bool is_async = false;
+        std::string async_target;
+        u64 async_reservation_begin = 0;
+        u64 async_reservation_end = 0;
+        gl_memory_transfer_handle* next_submitted = nullptr;
+
         std::atomic<stardraw::memory_transfer_status> current_status = memory_transfer_status::READY;
+        //Regions finished through transfer_region, as disjoint [begin, end) ranges.
+        std::mutex covered_ranges_mutex;
+        std::map<u64, u64> covered_ranges;
+        u64 covered_bytes = 0;
+
+        //Set for uploads into persistent mappings created with GL_MAP_FLUSH_EXPLICIT_BIT.
+        bool explicit_flush = false;
+        std::mutex written_ranges_mutex;
+        std::vector<std::pair<u64, u64>> written_ranges;
     };
 }
@@ -0,0 +1,128 @@
+#include "upload_scheduler.hpp"
+
+#include <tracy/Tracy.hpp>
+#include <tracy/TracyOpenGL.hpp>
+
+namespace stardraw::gl45
+{
+    upload_scheduler::~upload_scheduler()
+    {
+        for (const std::deque<scheduled_upload>& queue : queues)
+        {
+            for (const scheduled_upload& upload : queue)
+            {
+                glDeleteBuffers(1, &upload.staging_buffer_id);
+            }
+        }
+    }
+
+    void upload_scheduler::set_frame_budget(const u64 bytes)
+    {
+        frame_budget = bytes;
+    }
+
+    void upload_scheduler::enqueue(const upload_priority priority, scheduled_upload&& upload)
+    {
+        queues[static_cast<u8>(priority)].push_back(std::move(upload));
+    }
+
+    status upload_scheduler::process(const slice_uploader& uploader)
+    {
+        ZoneScoped;
+        TracyGpuZone("[Stardraw] Process scheduled uploads");
+
+        //A budget of zero means unlimited.
+        const bool unlimited = frame_budget == 0;
+        u64 budget_left = frame_budget;
+        u64 uploaded = 0;
+        status result = status_type::SUCCESS;
+
+        for (u8 priority = 0; priority < queues.size(); priority++)
+        {
+            std::deque<scheduled_upload>& queue = queues[priority];
+            const bool ignores_budget = unlimited || priority == static_cast<u8>(upload_priority::CRITICAL);
+
+            while (!queue.empty())
+            {
+                scheduled_upload& upload = queue.front();
+                const u64 remaining_slices = upload.total_slices - upload.next_slice;
+
+                u64 slices = remaining_slices;
+                if (!ignores_budget)
+                {
+                    slices = std::min(remaining_slices, budget_left / upload.slice_bytes);
+                    //Always make some progress, even if a single slice is bigger than the whole budget.
+                    if (slices == 0 && uploaded == 0) slices = 1;
+                    if (slices == 0) break;
+                }
+
+                const status upload_status = uploader(upload, upload.next_slice, slices);
+                const u64 bytes = slices * upload.slice_bytes;
+                uploaded += bytes;
+                budget_left -= std::min(budget_left, bytes);
+                upload.next_slice += slices;
+
+                //Failed uploads are dropped rather than retried every frame; the first failure is reported.
+                if (is_status_error(upload_status) && !is_status_error(result)) result = upload_status;
+                if (is_status_error(upload_status) || upload.next_slice >= upload.total_slices)
+                {
+                    glDeleteBuffers(1, &upload.staging_buffer_id);
+                    queue.pop_front();
+                }
+
+                if (!ignores_budget && budget_left == 0) break;
+            }
+        }
+
+        bytes_uploaded_last_frame = uploaded;
+        return result;
+    }
+
+    upload_queue_info upload_scheduler::info() const
+    {
+        upload_queue_info queue_info;
+        queue_info.frame_budget = frame_budget;
+        queue_info.bytes_uploaded_last_frame = bytes_uploaded_last_frame;
+
+        std::array<u64*, 3> queued_bytes = {&queue_info.queued_critical_bytes, &queue_info.queued_normal_bytes, &queue_info.queued_background_bytes};
+        for (u8 priority = 0; priority < queues.size(); priority++)
+        {
+            for (const scheduled_upload& upload : queues[priority])
+            {
+                *queued_bytes[priority] += (upload.total_slices - upload.next_slice) * upload.slice_bytes;
+                queue_info.queued_uploads++;
+            }
+        }
+
+        return queue_info;
+    }
+
+    bool upload_scheduler::has_upload_for(const bool is_texture, const u64 target_hash) const
+    {
+        for (const std::deque<scheduled_upload>& queue : queues)
+        {
+            for (const scheduled_upload& upload : queue)
+            {
+                if (upload.is_texture != is_texture) continue;
+                const std::string& target = is_texture ? upload.texture_info.target : upload.buffer_info.target;
+                if (object_identifier(target).hash == target_hash) return true;
+            }
+        }
+
+        return false;
+    }
+
+    u64 upload_scheduler::staging_bytes() const
+    {
+        u64 total = 0;
+        for (const std::deque<scheduled_upload>& queue : queues)
+        {
+            for (const scheduled_upload& upload : queue)
+            {
+                total += upload.total_slices * upload.slice_bytes;
+            }
+        }
+
+        return total;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <array>
+#include <deque>
+#include <functional>
+
+#include "gl_headers.hpp"
+#include "types.hpp"
+#include "stardraw/api/memory_transfer.hpp"
+
+namespace stardraw::gl45
+{
+    //Queues flushed uploads and paces their copies out of staging memory across frames.
+    //Transfers are split into slices (bytes for buffers, rows/slices/layers for textures) so a large upload can be spread over several frames.
+    class upload_scheduler
+    {
+    public:
+        struct scheduled_upload
+        {
+            bool is_texture = false;
+            buffer_memory_transfer_info buffer_info;
+            texture_memory_transfer_info texture_info;
+            GLuint staging_buffer_id = 0;
+            u64 slice_bytes = 1;
+            u64 total_slices = 0;
+            u64 next_slice = 0;
+        };
+
+        //Copies slice_count slices starting at first_slice out of the upload's staging buffer.
+        using slice_uploader = std::function<status(const scheduled_upload& upload, u64 first_slice, u64 slice_count)>;
+
+        ~upload_scheduler();
+
+        void set_frame_budget(const u64 bytes);
+        void enqueue(const upload_priority priority, scheduled_upload&& upload);
+        [[nodiscard]] status process(const slice_uploader& uploader);
+        [[nodiscard]] upload_queue_info info() const;
+        //Bytes of staging memory held by queued uploads.
+        [[nodiscard]] u64 staging_bytes() const;
+        [[nodiscard]] bool has_upload_for(const bool is_texture, const u64 target_hash) const;
+
+    private:
+        std::array<std::deque<scheduled_upload>, 3> queues;
+        u64 frame_budget = 0;
+        u64 bytes_uploaded_last_frame = 0;
+    };
+}
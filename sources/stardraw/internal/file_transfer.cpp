@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <format>
+
+#include <tracy/Tracy.hpp>
+
+#include "mapped_file.hpp"
+#include "stardraw/api/render_context.hpp"
+
+namespace stardraw
+{
+    status render_context::transfer_buffer_memory_from_file(const buffer_file_transfer_info& info)
+    {
+        ZoneScoped;
+        using transfer_type = buffer_memory_transfer_info::type;
+        if (info.transfer_type == transfer_type::DOWNLOAD || info.transfer_type == transfer_type::UPLOAD_ASYNC)
+        {
+            return {status_type::INVALID, "File transfers must use a render thread upload type"};
+        }
+        if (info.chunk_bytes == 0) return {status_type::INVALID, "File transfer chunk size must be greater than zero"};
+
+        mapped_file file;
+        const status open_status = file.open(info.path);
+        if (is_status_error(open_status)) return open_status;
+
+        if (info.file_offset > file.size()) return {status_type::RANGE_OVERFLOW, std::format("File offset is past the end of '{0}'", info.path.string())};
+        const u64 total_bytes = info.bytes == 0 ? file.size() - info.file_offset : info.bytes;
+        if (info.file_offset + total_bytes > file.size()) return {status_type::RANGE_OVERFLOW, std::format("Requested range is past the end of '{0}'", info.path.string())};
+        if (total_bytes == 0) return status_type::NOTHING_TO_DO;
+
+        //Whole-granularity chunks keep every view after the first starting exactly on a mapping boundary.
+        const u64 granularity = mapped_file::allocation_granularity();
+        const u64 chunk_bytes = (info.chunk_bytes + granularity - 1) / granularity * granularity;
+
+        for (u64 done = 0; done < total_bytes;)
+        {
+            //Stop the first chunk on a boundary, so an unaligned file offset doesn't make every view straddle one.
+            const u64 file_address = info.file_offset + done;
+            const u64 bytes = std::min(chunk_bytes - file_address % granularity, total_bytes - done);
+
+            const void* file_data;
+            const status map_status = file.map_view(file_address, bytes, &file_data);
+            if (is_status_error(map_status)) return map_status;
+
+            buffer_memory_transfer_info transfer_info = {info.target, info.address + done, bytes, info.transfer_type};
+            transfer_info.priority = info.priority;
+
+            memory_transfer_handle* handle;
+            const status prepare_status = prepare_buffer_memory_transfer(transfer_info, &handle);
+            if (is_status_error(prepare_status)) return prepare_status;
+
+            const status transfer_status = handle->transfer(const_cast<void*>(file_data));
+            const status flush_status = flush_buffer_memory_transfer(handle);
+            if (is_status_error(transfer_status)) return transfer_status;
+            if (is_status_error(flush_status)) return flush_status;
+
+            file.unmap_view();
+            done += bytes;
+        }
+
+        return status_type::SUCCESS;
+    }
+}
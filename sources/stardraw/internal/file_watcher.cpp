@@ -0,0 +1,124 @@
+#include "file_watcher.hpp"
+
+#include <algorithm>
+#include <format>
+#include <thread>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace stardraw
+{
+#if defined(__linux__)
+    file_watcher::~file_watcher()
+    {
+        if (inotify_descriptor != -1) close(inotify_descriptor);
+    }
+
+    status file_watcher::watch(const std::filesystem::path& path)
+    {
+        std::error_code error;
+        const std::filesystem::path canonical_path = std::filesystem::weakly_canonical(path, error);
+        if (error) return {status_type::UNKNOWN, std::format("Unable to resolve watched file '{0}'", path.string())};
+
+        std::lock_guard lock(mutex);
+        if (watched_files.contains(canonical_path)) return status_type::NOTHING_TO_DO;
+
+        if (inotify_descriptor == -1)
+        {
+            inotify_descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (inotify_descriptor == -1) return {status_type::BACKEND_ERROR, "Unable to create inotify instance for file watching"};
+        }
+
+        //Watching the directory rather than the file survives editors replacing the file on save. Adding the same directory twice returns the existing watch.
+        const std::filesystem::path directory = canonical_path.parent_path();
+        const int watch_descriptor = inotify_add_watch(inotify_descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (watch_descriptor == -1) return {status_type::BACKEND_ERROR, std::format("Unable to watch directory '{0}'", directory.string())};
+
+        watched_directories[watch_descriptor] = directory;
+        watched_files.insert(canonical_path);
+        return status_type::SUCCESS;
+    }
+
+    std::vector<std::filesystem::path> file_watcher::wait_for_changes(const std::chrono::milliseconds timeout)
+    {
+        std::vector<std::filesystem::path> changes;
+
+        int descriptor;
+        {
+            std::lock_guard lock(mutex);
+            descriptor = inotify_descriptor;
+        }
+
+        if (descriptor == -1)
+        {
+            std::this_thread::sleep_for(timeout);
+            return changes;
+        }
+
+        pollfd poll_descriptor = {descriptor, POLLIN, 0};
+        if (poll(&poll_descriptor, 1, static_cast<int>(timeout.count())) <= 0) return changes;
+
+        alignas(inotify_event) char buffer[4096];
+        while (true)
+        {
+            const ssize_t bytes = read(descriptor, buffer, sizeof(buffer));
+            if (bytes <= 0) break;
+
+            std::lock_guard lock(mutex);
+            for (ssize_t offset = 0; offset < bytes;)
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+                if (event->len == 0 || !watched_directories.contains(event->wd)) continue;
+
+                const std::filesystem::path changed = watched_directories[event->wd] / event->name;
+                if (watched_files.contains(changed) && std::ranges::find(changes, changed) == changes.end()) changes.push_back(changed);
+            }
+        }
+
+        return changes;
+    }
+#else
+    file_watcher::~file_watcher() = default;
+
+    status file_watcher::watch(const std::filesystem::path& path)
+    {
+        std::error_code error;
+        const std::filesystem::path canonical_path = std::filesystem::weakly_canonical(path, error);
+        if (error) return {status_type::UNKNOWN, std::format("Unable to resolve watched file '{0}'", path.string())};
+
+        const std::filesystem::file_time_type modified = std::filesystem::last_write_time(canonical_path, error);
+        if (error) return {status_type::UNKNOWN, std::format("Unable to read modification time of '{0}'", path.string())};
+
+        std::lock_guard lock(mutex);
+        if (watched_files.contains(canonical_path)) return status_type::NOTHING_TO_DO;
+
+        watched_files.insert(canonical_path);
+        modification_times[canonical_path] = modified;
+        return status_type::SUCCESS;
+    }
+
+    std::vector<std::filesystem::path> file_watcher::wait_for_changes(const std::chrono::milliseconds timeout)
+    {
+        std::this_thread::sleep_for(timeout);
+        std::vector<std::filesystem::path> changes;
+
+        std::lock_guard lock(mutex);
+        for (auto& [path, last_modified] : modification_times)
+        {
+            std::error_code error;
+            const std::filesystem::file_time_type modified = std::filesystem::last_write_time(path, error);
+            if (error || modified == last_modified) continue;
+
+            last_modified = modified;
+            changes.push_back(path);
+        }
+
+        return changes;
+    }
+#endif
+}
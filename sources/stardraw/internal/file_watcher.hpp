@@ -0,0 +1,43 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "stardraw/api/types.hpp"
+
+namespace stardraw
+{
+    using namespace starlib_stdint;
+
+    /*
+    Reports changes to a set of watched files. On Linux this uses inotify on each file's directory, so editors that save by replacing the file are still seen.
+    Elsewhere modification times are polled. Files can be added from any thread while another waits for changes.
+    */
+    class file_watcher
+    {
+    public:
+        file_watcher() = default;
+        ~file_watcher();
+        file_watcher(const file_watcher&) = delete;
+        file_watcher& operator=(const file_watcher&) = delete;
+
+        [[nodiscard]] status watch(const std::filesystem::path& path);
+
+        //Waits up to the timeout for any watched file to change. Returns each changed file once, or nothing if the timeout passed.
+        [[nodiscard]] std::vector<std::filesystem::path> wait_for_changes(const std::chrono::milliseconds timeout);
+
+    private:
+        std::mutex mutex;
+        std::unordered_set<std::filesystem::path> watched_files;
+
+#if defined(__linux__)
+        int inotify_descriptor = -1;
+        std::unordered_map<int, std::filesystem::path> watched_directories;
+#else
+        std::unordered_map<std::filesystem::path, std::filesystem::file_time_type> modification_times;
+#endif
+    };
+}
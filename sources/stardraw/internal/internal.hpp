@@ -1,4 +1,5 @@
 #pragma once
+#include <unordered_map>
 #include <slang.h>
 
 #include "stardraw/api/shaders.hpp"
@@ -8,28 +9,41 @@ struct std::hash<stardraw::shader_parameter_location>
 {
     std::size_t operator()(const stardraw::shader_parameter_location& key) const noexcept
     {
-        return hash<starlib_stdint::u32>()(key.binding_range_index + key.binding_range + key.byte_address + key.root_idx);
+        return hash<starlib_stdint::u64>()(key.path_hash + key.byte_address + key.binding_range_index);
     }
 };
 
 namespace stardraw
 {
-    struct binding_location_info
+    struct shader_parameter_reflection
     {
+        //Descriptor set and slot of the binding the parameter lives in. For plain data this is the containing buffer.
         i64 set;
         i64 slot;
-        //The binding type that the location exists inside
-        //May not always be the same as the actual variable the location references -
-        //for instance, for plain data, it will be the containing buffer variable.
-        slang::TypeLayoutReflection* binding_type;
+        //Byte address within the binding with every array index along the path at 0.
+        u32 byte_offset;
+        u32 size;
+        //Applied per index when indexing into this parameter.
+        u32 element_stride;
+        u32 element_count;
+        u32 binding_range;
+        //Kind, shape and access of the binding, not of the parameter itself.
+        slang::TypeReflection::Kind binding_kind;
+        SlangResourceShape resource_shape;
+        SlangResourceAccess resource_access;
+        //True when the parameter is the binding itself, so an object can be bound to it.
+        bool is_binding;
     };
 
-    constexpr shader_parameter_location invalid_shader_paramter_location = {
-        nullptr, nullptr, 0, 0, 0, 0
+    struct shader_reflection_table
+    {
+        std::unordered_map<u64, shader_parameter_reflection> entries;
     };
 
-    slang::TypeLayoutReflection* slang_type_reflection(const shader_parameter_location& location);
-    slang::VariableLayoutReflection* slang_root_var_reflection(const shader_parameter_location& location);
+    constexpr shader_parameter_location invalid_shader_paramter_location = {};
+
+    //Remaps a location found in another program (or before a reload) onto the program's own reflection, by its path. Invalid if the program has no such parameter.
+    [[nodiscard]] shader_parameter_location relocate_shader_parameter(const shader_parameter_location& location, const shader_program* program);
+
     slang::ShaderReflection* slang_shader_reflection(const shader_program* program);
-    binding_location_info vk_binding_for_location(const shader_parameter_location& location);
 }
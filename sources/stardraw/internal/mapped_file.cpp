@@ -0,0 +1,167 @@
+#include "mapped_file.hpp"
+
+#include <format>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <tracy/Tracy.hpp>
+
+namespace stardraw
+{
+    mapped_file::~mapped_file()
+    {
+        close();
+    }
+
+#if defined(_WIN32)
+    status mapped_file::open(const std::filesystem::path& path)
+    {
+        close();
+
+        file_handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file_handle == INVALID_HANDLE_VALUE)
+        {
+            file_handle = nullptr;
+            return {status_type::UNKNOWN, std::format("Unable to open file '{0}' for mapping", path.string())};
+        }
+
+        LARGE_INTEGER large_size;
+        if (!GetFileSizeEx(file_handle, &large_size))
+        {
+            close();
+            return {status_type::BACKEND_ERROR, std::format("Unable to query size of file '{0}'", path.string())};
+        }
+        file_size = large_size.QuadPart;
+        if (file_size == 0) return status_type::SUCCESS;
+
+        mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_handle == nullptr)
+        {
+            close();
+            return {status_type::BACKEND_ERROR, std::format("Unable to create file mapping for '{0}'", path.string())};
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    status mapped_file::map_view(const u64 offset, const u64 bytes, const void** out_data)
+    {
+        ZoneScoped;
+        unmap_view();
+        if (offset + bytes > file_size) return {status_type::RANGE_OVERFLOW, "Requested file view is out of range of the mapped file"};
+
+        const u64 view_offset = offset - offset % allocation_granularity();
+        const u64 lead_bytes = offset - view_offset;
+        view_ptr = MapViewOfFile(mapping_handle, FILE_MAP_READ, static_cast<DWORD>(view_offset >> 32), static_cast<DWORD>(view_offset & 0xFFFFFFFF), lead_bytes + bytes);
+        if (view_ptr == nullptr) return {status_type::BACKEND_ERROR, "Unable to map file view"};
+        view_bytes = lead_bytes + bytes;
+
+        //Fault the whole view in with one large read instead of page by page as the copy touches it.
+        WIN32_MEMORY_RANGE_ENTRY prefetch_range = {view_ptr, view_bytes};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &prefetch_range, 0);
+
+        *out_data = static_cast<const u8*>(view_ptr) + lead_bytes;
+        return status_type::SUCCESS;
+    }
+
+    void mapped_file::unmap_view()
+    {
+        if (view_ptr == nullptr) return;
+        UnmapViewOfFile(view_ptr);
+        view_ptr = nullptr;
+        view_bytes = 0;
+    }
+
+    u64 mapped_file::allocation_granularity()
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwAllocationGranularity;
+    }
+
+    void mapped_file::close()
+    {
+        unmap_view();
+        if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+        if (file_handle != nullptr) CloseHandle(file_handle);
+        mapping_handle = nullptr;
+        file_handle = nullptr;
+        file_size = 0;
+    }
+#else
+    status mapped_file::open(const std::filesystem::path& path)
+    {
+        close();
+
+        file_descriptor = ::open(path.c_str(), O_RDONLY);
+        if (file_descriptor < 0) return {status_type::UNKNOWN, std::format("Unable to open file '{0}' for mapping", path.string())};
+
+        struct stat file_stat = {};
+        if (fstat(file_descriptor, &file_stat) != 0)
+        {
+            close();
+            return {status_type::BACKEND_ERROR, std::format("Unable to query size of file '{0}'", path.string())};
+        }
+        file_size = file_stat.st_size;
+
+        posix_fadvise(file_descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+        return status_type::SUCCESS;
+    }
+
+    status mapped_file::map_view(const u64 offset, const u64 bytes, const void** out_data)
+    {
+        ZoneScoped;
+        unmap_view();
+        if (offset + bytes > file_size) return {status_type::RANGE_OVERFLOW, "Requested file view is out of range of the mapped file"};
+
+        const u64 view_offset = offset - offset % allocation_granularity();
+        const u64 lead_bytes = offset - view_offset;
+        void* mapping = mmap(nullptr, lead_bytes + bytes, PROT_READ, MAP_PRIVATE, file_descriptor, static_cast<off_t>(view_offset));
+        if (mapping == MAP_FAILED) return {status_type::BACKEND_ERROR, "Unable to map file view"};
+        view_ptr = mapping;
+        view_bytes = lead_bytes + bytes;
+
+        //The view is read front to back exactly once - let the kernel read ahead aggressively and drop pages behind us.
+        madvise(view_ptr, view_bytes, MADV_SEQUENTIAL);
+        madvise(view_ptr, view_bytes, MADV_WILLNEED);
+
+        *out_data = static_cast<const u8*>(view_ptr) + lead_bytes;
+        return status_type::SUCCESS;
+    }
+
+    void mapped_file::unmap_view()
+    {
+        if (view_ptr == nullptr) return;
+        munmap(view_ptr, view_bytes);
+        view_ptr = nullptr;
+        view_bytes = 0;
+    }
+
+    u64 mapped_file::allocation_granularity()
+    {
+        return static_cast<u64>(sysconf(_SC_PAGESIZE));
+    }
+
+    void mapped_file::close()
+    {
+        unmap_view();
+        if (file_descriptor >= 0) ::close(file_descriptor);
+        file_descriptor = -1;
+        file_size = 0;
+    }
+#endif
+
+    u64 mapped_file::size() const
+    {
+        return file_size;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <filesystem>
+
+#include "stardraw/api/types.hpp"
+
+namespace stardraw
+{
+    using namespace starlib_stdint;
+
+    //Read-only memory mapping of a file. Views are mapped one at a time, so streaming through a large file only keeps the current view resident.
+    class mapped_file
+    {
+    public:
+        mapped_file() = default;
+        ~mapped_file();
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        [[nodiscard]] status open(const std::filesystem::path& path);
+
+        //Maps bytes starting at offset, replacing any previous view. The view start is aligned down to the allocation granularity internally; out_data points at offset itself.
+        [[nodiscard]] status map_view(const u64 offset, const u64 bytes, const void** out_data);
+        void unmap_view();
+
+        [[nodiscard]] u64 size() const;
+
+        //Alignment required of mapping offsets - the page size on POSIX, the allocation granularity (usually 64KiB) on Windows.
+        [[nodiscard]] static u64 allocation_granularity();
+
+    private:
+        void close();
+
+#if defined(_WIN32)
+        void* file_handle = nullptr;
+        void* mapping_handle = nullptr;
+#else
+        int file_descriptor = -1;
+#endif
+        void* view_ptr = nullptr;
+        u64 view_bytes = 0;
+        u64 file_size = 0;
+    };
+}
@@ -0,0 +1,106 @@
+#include "shader_cache.hpp"
+
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include <tracy/Tracy.hpp>
+
+#include "stardraw/api/shaders.hpp"
+
+namespace stardraw
+{
+    static std::mutex shader_cache_mutex;
+    static std::filesystem::path shader_cache_directory;
+
+    static std::filesystem::path shader_cache_entry_path(const u64 key, const std::string_view& kind)
+    {
+        return shader_cache_directory / std::format("{0:016x}.{1}", key, kind);
+    }
+
+    status set_shader_cache_directory(const std::filesystem::path& directory)
+    {
+        const std::lock_guard lock(shader_cache_mutex);
+        if (directory.empty())
+        {
+            shader_cache_directory.clear();
+            return status_type::SUCCESS;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error) return {status_type::BACKEND_ERROR, std::format("Unable to create shader cache directory '{0}': {1}", directory.string(), error.message())};
+
+        shader_cache_directory = directory;
+        return status_type::SUCCESS;
+    }
+
+    status clear_shader_cache()
+    {
+        const std::lock_guard lock(shader_cache_mutex);
+        if (shader_cache_directory.empty()) return status_type::NOTHING_TO_DO;
+
+        std::error_code error;
+        for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(shader_cache_directory, error))
+        {
+            if (entry.is_regular_file()) std::filesystem::remove(entry.path(), error);
+        }
+
+        if (error) return {status_type::BACKEND_ERROR, std::format("Unable to clear shader cache directory: {0}", error.message())};
+        return status_type::SUCCESS;
+    }
+
+    bool is_shader_cache_enabled()
+    {
+        const std::lock_guard lock(shader_cache_mutex);
+        return !shader_cache_directory.empty();
+    }
+
+    bool read_shader_cache(const u64 key, const std::string_view& kind, std::vector<u8>& out_data)
+    {
+        ZoneScoped;
+        std::filesystem::path path;
+        {
+            const std::lock_guard lock(shader_cache_mutex);
+            if (shader_cache_directory.empty()) return false;
+            path = shader_cache_entry_path(key, kind);
+        }
+
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) return false;
+
+        const std::streamsize size = file.tellg();
+        if (size <= 0) return false;
+
+        out_data.resize(size);
+        file.seekg(0);
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(out_data.data()), size));
+    }
+
+    void write_shader_cache(const u64 key, const std::string_view& kind, const void* data, const u64 bytes)
+    {
+        ZoneScoped;
+        std::filesystem::path path;
+        {
+            const std::lock_guard lock(shader_cache_mutex);
+            if (shader_cache_directory.empty()) return;
+            path = shader_cache_entry_path(key, kind);
+        }
+
+        //Write to a temporary file and rename it over the entry, so a crash or a concurrent reader never sees a partial entry.
+        std::filesystem::path temp_path = path;
+        temp_path += std::format(".{0}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if (!file) return;
+            file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+            if (!file) return;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temp_path, path, error);
+        if (error) std::filesystem::remove(temp_path, error);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <string_view>
+#include <vector>
+
+#include "stardraw/api/types.hpp"
+
+namespace stardraw
+{
+    using namespace starlib_stdint;
+
+    constexpr u64 fnv1a_offset_basis = 14695981039346656037ull;
+    constexpr u64 fnv1a_prime = 1099511628211ull;
+
+    [[nodiscard]] inline u64 fnv1a_hash(const void* data, const u64 bytes, u64 hash = fnv1a_offset_basis)
+    {
+        const u8* byte_data = static_cast<const u8*>(data);
+        for (u64 idx = 0; idx < bytes; idx++)
+        {
+            hash ^= byte_data[idx];
+            hash *= fnv1a_prime;
+        }
+        return hash;
+    }
+
+    [[nodiscard]] inline u64 fnv1a_hash(const std::string_view& data, const u64 hash = fnv1a_offset_basis)
+    {
+        return fnv1a_hash(data.data(), data.size(), hash);
+    }
+
+    [[nodiscard]] inline u64 fnv1a_hash_value(const u64 value, const u64 hash = fnv1a_offset_basis)
+    {
+        return fnv1a_hash(&value, sizeof(value), hash);
+    }
+
+    //Content addressed store for compiled shader artifacts. Entries are files named by key and kind inside the directory set with set_shader_cache_directory.
+    [[nodiscard]] bool is_shader_cache_enabled();
+    [[nodiscard]] bool read_shader_cache(const u64 key, const std::string_view& kind, std::vector<u8>& out_data);
+    void write_shader_cache(const u64 key, const std::string_view& kind, const void* data, const u64 bytes);
+}
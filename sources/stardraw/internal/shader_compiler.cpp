@@ -0,0 +1,581 @@
+#include "shader_compiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include "shader_cache.hpp"
+
+namespace stardraw
+{
+    shader_compiler& shader_compiler::instance()
+    {
+        static shader_compiler compiler;
+        return compiler;
+    }
+
+    status shader_compiler::setup(const std::vector<shader_macro>& macro_defines)
+    {
+        {
+            std::lock_guard lock(global_session_mutex);
+            if (global_session == nullptr)
+            {
+                const SlangResult result = slang::createGlobalSession(&global_session);
+                if (SLANG_FAILED(result)) return {status_type::BACKEND_ERROR, "Slang context creation failed"};
+            }
+        }
+
+        {
+            std::unique_lock lock(registry_mutex);
+            this->macro_defines = macro_defines;
+            modules.clear();
+            module_indexes.clear();
+            epoch++;
+        }
+
+        //Creating a session up front reports bad macros here rather than on the first load.
+        Slang::ComPtr<slang::ISession> probe_session;
+        u64 content_hash;
+        const status session_status = create_session({}, probe_session.writeRef(), content_hash);
+        if (is_status_error(session_status)) return session_status;
+
+        std::unique_lock lock(registry_mutex);
+        session_content_hash = content_hash;
+        return status_type::SUCCESS;
+    }
+
+    bool shader_compiler::is_setup()
+    {
+        std::lock_guard lock(global_session_mutex);
+        return global_session != nullptr;
+    }
+
+    status shader_compiler::create_session(const std::vector<shader_macro>& additional_macros, slang::ISession** out_session, u64& out_content_hash)
+    {
+        std::vector<shader_macro> session_macros;
+        {
+            std::shared_lock lock(registry_mutex);
+            session_macros = macro_defines;
+        }
+        session_macros.insert(session_macros.end(), additional_macros.begin(), additional_macros.end());
+
+        std::lock_guard lock(global_session_mutex);
+        if (global_session == nullptr) return {status_type::NOT_INITIALIZED, "Shader compiler has not been set up"};
+
+        out_content_hash = fnv1a_hash(global_session->getBuildTagString());
+
+        std::vector<slang::CompilerOptionEntry> compiler_options;
+        for (const shader_macro& macro : session_macros)
+        {
+            out_content_hash = fnv1a_hash(macro.name, out_content_hash);
+            out_content_hash = fnv1a_hash(macro.value, out_content_hash);
+
+            compiler_options.push_back(slang::CompilerOptionEntry {
+                slang::CompilerOptionName::MacroDefine,
+                slang::CompilerOptionValue {
+                    slang::CompilerOptionValueKind::String,
+                    0, 0, macro.name.data(), macro.value.data()
+                }
+            });
+        }
+
+        slang::SessionDesc session_desc;
+
+        const static std::array slang_targets = {
+            slang::TargetDesc {
+                .format = SlangCompileTarget::SLANG_SPIRV,
+                .profile = global_session->findProfile("spirv_latest"),
+            },
+        };
+
+        session_desc.targets = slang_targets.data();
+        session_desc.targetCount = slang_targets.size();
+
+        session_desc.compilerOptionEntries = compiler_options.data();
+        session_desc.compilerOptionEntryCount = compiler_options.size();
+
+        session_desc.searchPaths = nullptr;
+        session_desc.searchPathCount = 0;
+
+        const SlangResult session_creation = global_session->createSession(session_desc, out_session);
+        if (SLANG_FAILED(session_creation)) return {status_type::BACKEND_ERROR, "Slang session creation failed"};
+
+        return status_type::SUCCESS;
+    }
+
+    status shader_compiler::acquire_session(shader_session_lock& out_lock)
+    {
+        thread_local std::shared_ptr<shader_worker_session> thread_worker;
+
+        u64 current_epoch;
+        {
+            std::shared_lock lock(registry_mutex);
+            current_epoch = epoch;
+        }
+
+        if (thread_worker == nullptr || thread_worker->epoch != current_epoch)
+        {
+            const std::shared_ptr<shader_worker_session> worker = std::make_shared<shader_worker_session>();
+            u64 content_hash;
+            const status session_status = create_session({}, worker->session.writeRef(), content_hash);
+            if (is_status_error(session_status)) return session_status;
+
+            worker->epoch = current_epoch;
+            thread_worker = worker;
+        }
+
+        out_lock.worker = thread_worker;
+        out_lock.lock = std::unique_lock(thread_worker->mutex);
+        return sync_session(*thread_worker, std::numeric_limits<u64>::max());
+    }
+
+    status shader_compiler::sync_session(shader_worker_session& worker, const u64 module_limit)
+    {
+        while (worker.synced_modules < module_limit)
+        {
+            registered_module entry;
+            {
+                std::shared_lock lock(registry_mutex);
+                if (worker.synced_modules >= modules.size()) break;
+                entry = modules[worker.synced_modules];
+            }
+
+            worker.synced_modules++;
+            //Modules this session compiled itself are already loaded.
+            if (worker.modules.contains(entry.name)) continue;
+
+            const status load_status = load_module_from_ir(worker, entry.name, entry.load_path, entry.ir->data(), entry.ir->size());
+            if (is_status_error(load_status)) return load_status;
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    //Dependency paths are compared against module load paths, so both go through the same normalisation. Placeholder paths that don't exist are kept as they are.
+    static std::filesystem::path normalise_dependency_path(const std::filesystem::path& path)
+    {
+        std::error_code error;
+        const std::filesystem::path canonical_path = std::filesystem::weakly_canonical(path, error);
+        return error ? path : canonical_path;
+    }
+
+    static std::vector<std::filesystem::path> module_dependencies(slang::IModule* module)
+    {
+        std::vector<std::filesystem::path> dependencies;
+        for (i32 idx = 0; idx < module->getDependencyFileCount(); idx++)
+        {
+            dependencies.push_back(normalise_dependency_path(module->getDependencyFilePath(idx)));
+        }
+        return dependencies;
+    }
+
+    static status read_text_file(const std::filesystem::path& path, std::string& out_text)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        if (!file) return {status_type::UNKNOWN, std::format("Unable to open shader file '{0}'", path.string())};
+
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        out_text = buffer.str();
+        return status_type::SUCCESS;
+    }
+
+    status shader_compiler::load_module_from_ir(shader_worker_session& worker, const std::string_view& module_name, const std::filesystem::path& path, const void* ir_ptr, const u64 ir_size)
+    {
+        const std::string path_string = path.string();
+        const std::string name = std::string(module_name);
+        Slang::ComPtr<slang::IBlob> diagnostics;
+
+        const Slang::ComPtr module(worker.session->loadModuleFromIRBlob(name.c_str(), path_string.c_str(), slang_createBlob(ir_ptr, ir_size), diagnostics.writeRef()));
+
+        if (diagnostics)
+        {
+            std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
+            return {status_type::BACKEND_ERROR, std::format("Slang module loading '{1}' failed with error: '{0}'", msg, module_name)};
+        }
+
+        if (!module)
+        {
+            return {status_type::BACKEND_ERROR, std::format("Slang module '{0}' loading failed with unknwon error", module_name)};
+        }
+
+        worker.modules[name] = module;
+        return status_type::SUCCESS;
+    }
+
+    status shader_compiler::compile_module_source(shader_worker_session& worker, const std::string_view& module_name, const std::string& source, const std::filesystem::path& path, Slang::ComPtr<ISlangBlob>& out_ir, std::vector<std::filesystem::path>& out_dependencies)
+    {
+        const std::string name = std::string(module_name);
+        const std::string path_string = path.string();
+        Slang::ComPtr<slang::IBlob> diagnostics;
+        const Slang::ComPtr module(worker.session->loadModuleFromSourceString(name.c_str(), path_string.c_str(), source.c_str(), diagnostics.writeRef()));
+
+        if (diagnostics)
+        {
+            std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
+            return {status_type::BACKEND_ERROR, std::format("Slang module loading '{1}' failed with error: '{0}'", msg, module_name)};
+        }
+
+        if (!module)
+        {
+            return {status_type::BACKEND_ERROR, std::format("Slang module '{0}' loading failed with unknown error", module_name)};
+        }
+
+        worker.modules[name] = module;
+        out_dependencies = module_dependencies(module);
+
+        //Other sessions load the module from its IR, so it's always serialized.
+        const SlangResult serialize_result = module->serialize(out_ir.writeRef());
+        if (SLANG_FAILED(serialize_result)) return {status_type::BACKEND_ERROR, std::format("Failed to serialize module '{0}'", module_name)};
+
+        return status_type::SUCCESS;
+    }
+
+    status shader_compiler::register_module(registered_module&& entry, const void* ir_ptr, const u64 ir_size)
+    {
+        const u8* ir_bytes = static_cast<const u8*>(ir_ptr);
+        entry.ir = std::make_shared<const std::vector<u8>>(ir_bytes, ir_bytes + ir_size);
+
+        std::unique_lock lock(registry_mutex);
+        if (const auto existing = module_indexes.find(entry.name); existing != module_indexes.end())
+        {
+            //Replacing a module changes what later modules import, so sessions can't just load the new version on top.
+            modules[existing->second] = std::move(entry);
+            epoch++;
+        }
+        else
+        {
+            module_indexes[entry.name] = modules.size();
+            modules.push_back(std::move(entry));
+        }
+
+        return status_type::SUCCESS;
+    }
+
+    //Called with the registry lock held. Only modules actually imported are folded in, so the hash doesn't depend on what else was loaded or in which order.
+    u64 shader_compiler::import_content_hash(const std::string_view& module_name, const std::vector<std::filesystem::path>& dependencies, u64 hash) const
+    {
+        for (const std::filesystem::path& dependency : dependencies)
+        {
+            const auto imported = std::ranges::find(modules, dependency, &registered_module::load_path);
+            if (imported != modules.end() && imported->name != module_name) hash = fnv1a_hash_value(imported->content_hash, hash);
+        }
+        return hash;
+    }
+
+    status shader_compiler::load_module(const std::string_view& module_name, const std::string_view& source)
+    {
+        shader_session_lock session;
+        const status session_status = acquire_session(session);
+        if (is_status_error(session_status)) return session_status;
+
+        //Module IR refers to its imports by name, so the IR cache is keyed on the source alone.
+        u64 source_hash;
+        {
+            std::shared_lock lock(registry_mutex);
+            source_hash = fnv1a_hash(source, fnv1a_hash(module_name, session_content_hash));
+        }
+
+        const std::filesystem::path fake_path = std::format("{0}_fakepath.slang", module_name);
+        const std::string name = std::string(module_name);
+
+        std::vector<u8> cached_module;
+        if (read_shader_cache(source_hash, "slang-module", cached_module) && !is_status_error(load_module_from_ir(*session.worker, module_name, fake_path, cached_module.data(), cached_module.size())))
+        {
+            std::vector<std::filesystem::path> dependencies = module_dependencies(session.worker->modules[name]);
+            u64 content_hash;
+            {
+                std::shared_lock lock(registry_mutex);
+                content_hash = import_content_hash(module_name, dependencies, source_hash);
+            }
+            return register_module({name, nullptr, content_hash, fake_path, false, std::move(dependencies), std::string(source)}, cached_module.data(), cached_module.size());
+        }
+
+        Slang::ComPtr<ISlangBlob> serialized_blob;
+        std::vector<std::filesystem::path> dependencies;
+        const status compile_status = compile_module_source(*session.worker, module_name, std::string(source), fake_path, serialized_blob, dependencies);
+        if (is_status_error(compile_status)) return compile_status;
+
+        write_shader_cache(source_hash, "slang-module", serialized_blob->getBufferPointer(), serialized_blob->getBufferSize());
+
+        u64 content_hash;
+        {
+            std::shared_lock lock(registry_mutex);
+            content_hash = import_content_hash(module_name, dependencies, source_hash);
+        }
+        return register_module({name, nullptr, content_hash, fake_path, false, std::move(dependencies), std::string(source)}, serialized_blob->getBufferPointer(), serialized_blob->getBufferSize());
+    }
+
+    status shader_compiler::load_module(const std::string_view& module_name, const void* cache_ptr, const u64 cache_size)
+    {
+        shader_session_lock session;
+        const status session_status = acquire_session(session);
+        if (is_status_error(session_status)) return session_status;
+
+        const std::filesystem::path fake_path = std::format("{0}_fakepath.slang", module_name);
+        const status load_status = load_module_from_ir(*session.worker, module_name, fake_path, cache_ptr, cache_size);
+        if (is_status_error(load_status)) return load_status;
+
+        const std::string name = std::string(module_name);
+        std::vector<std::filesystem::path> dependencies = module_dependencies(session.worker->modules[name]);
+
+        u64 content_hash;
+        {
+            std::shared_lock lock(registry_mutex);
+            content_hash = import_content_hash(module_name, dependencies, fnv1a_hash(cache_ptr, cache_size, session_content_hash));
+        }
+
+        return register_module({name, nullptr, content_hash, fake_path, false, std::move(dependencies)}, cache_ptr, cache_size);
+    }
+
+    //Includes aren't part of the module source, so file modules hash the contents of every file they were built from instead.
+    static u64 dependency_content_hash(const std::vector<std::filesystem::path>& dependencies, u64 hash)
+    {
+        for (const std::filesystem::path& dependency : dependencies)
+        {
+            std::string contents;
+            if (is_status_error(read_text_file(dependency, contents))) contents.clear();
+            hash = fnv1a_hash(contents, fnv1a_hash(dependency.string(), hash));
+        }
+        return hash;
+    }
+
+    status shader_compiler::load_module_file(const std::string_view& module_name, const std::filesystem::path& path)
+    {
+        std::string source;
+        const status read_status = read_text_file(path, source);
+        if (is_status_error(read_status)) return read_status;
+
+        shader_session_lock session;
+        const status session_status = acquire_session(session);
+        if (is_status_error(session_status)) return session_status;
+
+        //No module IR cache here - it couldn't tell when an include changed. Generated code is still cached, keyed on the dependency contents.
+        Slang::ComPtr<ISlangBlob> serialized_blob;
+        std::vector<std::filesystem::path> dependencies;
+        const status compile_status = compile_module_source(*session.worker, module_name, source, normalise_dependency_path(path), serialized_blob, dependencies);
+        if (is_status_error(compile_status)) return compile_status;
+
+        u64 content_hash;
+        {
+            std::shared_lock lock(registry_mutex);
+            content_hash = import_content_hash(module_name, dependencies, dependency_content_hash(dependencies, fnv1a_hash(source, fnv1a_hash(module_name, session_content_hash))));
+        }
+
+        return register_module({std::string(module_name), nullptr, content_hash, normalise_dependency_path(path), true, std::move(dependencies)}, serialized_blob->getBufferPointer(), serialized_blob->getBufferSize());
+    }
+
+    status shader_compiler::serialize_module(const std::string& module_name, std::vector<u8>& out_data)
+    {
+        std::shared_lock lock(registry_mutex);
+        const auto existing = module_indexes.find(module_name);
+        if (existing == module_indexes.end()) return {status_type::UNKNOWN, std::format("No loaded slang module called '{0}' found.", module_name)};
+
+        out_data = *modules[existing->second].ir;
+        return status_type::SUCCESS;
+    }
+
+    status shader_compiler::link(const std::string& linked_set_name, const std::vector<shader_entry_point>& entry_points, const std::vector<std::string>& additional_modules)
+    {
+        shader_session_lock session;
+        const status session_status = acquire_session(session);
+        if (is_status_error(session_status)) return session_status;
+        shader_worker_session& worker = *session.worker;
+
+        std::vector<slang::IComponentType*> shader_components;
+        std::vector<Slang::ComPtr<slang::IEntryPoint>> slang_entry_points;
+        std::unordered_map<shader_entry_point, u32> entry_point_index_map;
+
+        std::shared_lock registry_lock(registry_mutex);
+        u64 content_hash = session_content_hash;
+
+        for (u32 idx = 0; idx < entry_points.size(); idx++)
+        {
+            const shader_entry_point& entry_point = entry_points[idx];
+
+            if (!worker.modules.contains(entry_point.module_name) || !module_indexes.contains(entry_point.module_name)) return {status_type::UNKNOWN, std::format("No loaded slang module called '{0}' found.", entry_point.module_name)};
+            const Slang::ComPtr<slang::IModule> module = worker.modules[entry_point.module_name];
+
+            Slang::ComPtr<slang::IEntryPoint> slang_entry_point;
+
+            const SlangResult found_entry_point = module->findEntryPointByName(entry_point.entry_point_name.c_str(), slang_entry_point.writeRef());
+            if (SLANG_FAILED(found_entry_point)) return {status_type::BACKEND_ERROR, std::format("Couldn't find entry point named '{0}' in module '{1}'", entry_point.entry_point_name, entry_point.module_name)};
+
+            shader_components.push_back(slang_entry_point);
+            slang_entry_points.push_back(slang_entry_point);
+            entry_point_index_map[entry_point] = idx;
+            content_hash = fnv1a_hash_value(modules[module_indexes[entry_point.module_name]].content_hash, fnv1a_hash(entry_point.entry_point_name, content_hash));
+        }
+
+        for (const std::string& module_name : additional_modules)
+        {
+            if (!worker.modules.contains(module_name) || !module_indexes.contains(module_name)) return {status_type::UNKNOWN, std::format("No loaded slang module called '{0}' found.", module_name)};
+            shader_components.push_back(worker.modules[module_name]);
+            content_hash = fnv1a_hash_value(modules[module_indexes[module_name]].content_hash, content_hash);
+        }
+
+        registry_lock.unlock();
+
+        Slang::ComPtr<slang::IComponentType> composite;
+
+        {
+            Slang::ComPtr<slang::IBlob> diagnostics;
+            worker.session->createCompositeComponentType(shader_components.data(), shader_components.size(), composite.writeRef(), diagnostics.writeRef());
+
+            if (diagnostics)
+            {
+                std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
+                return {status_type::BACKEND_ERROR, std::format("Slang shader linking for '{1}' failed with error: '{0}'", msg, linked_set_name)};
+            }
+        }
+
+        Slang::ComPtr<slang::IComponentType> linked_program;
+
+        {
+            Slang::ComPtr<slang::IBlob> diagnostics;
+            composite->link(linked_program.writeRef(), diagnostics.writeRef());
+
+            if (diagnostics)
+            {
+                std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
+                return {status_type::BACKEND_ERROR, std::format("Slang shader linking for '{1}' failed with error: '{0}'", msg, linked_set_name)};
+            }
+        }
+
+        std::unique_lock lock(registry_mutex);
+        linked_sets[linked_set_name] = {
+            entry_points,
+            additional_modules,
+            session.worker,
+            linked_program,
+            std::move(entry_point_index_map),
+            content_hash
+        };
+
+        return status_type::SUCCESS;
+    }
+
+    status shader_compiler::find_linked_set(const std::string& linked_set_name, linked_set& out_linked_set)
+    {
+        std::shared_lock lock(registry_mutex);
+        const auto existing = linked_sets.find(linked_set_name);
+        if (existing == linked_sets.end()) return {status_type::UNKNOWN, std::format("No linked slang shader called '{0}' exists.", linked_set_name)};
+
+        out_linked_set = existing->second;
+        return status_type::SUCCESS;
+    }
+
+    std::vector<std::filesystem::path> shader_compiler::dependency_files()
+    {
+        std::vector<std::filesystem::path> files;
+        std::shared_lock lock(registry_mutex);
+        for (const registered_module& module : modules)
+        {
+            if (!module.is_file) continue;
+            for (const std::filesystem::path& dependency : module.dependencies)
+            {
+                if (std::ranges::find(files, dependency) == files.end()) files.push_back(dependency);
+            }
+        }
+        return files;
+    }
+
+    status shader_compiler::reload_changed_files(const std::vector<std::filesystem::path>& changed_files, std::vector<std::string>& out_relinked_sets)
+    {
+        std::vector<std::filesystem::path> changed;
+        for (const std::filesystem::path& path : changed_files) changed.push_back(normalise_dependency_path(path));
+
+        std::vector<registered_module> snapshot;
+        {
+            std::shared_lock lock(registry_mutex);
+            snapshot = modules;
+        }
+
+        //Imports show up as a dependency on the imported module's load path, and imported modules are always registered first, so one forward pass finds every importer.
+        std::vector<bool> affected(snapshot.size(), false);
+        std::vector<std::string> affected_names;
+        for (u64 idx = 0; idx < snapshot.size(); idx++)
+        {
+            const std::vector<std::filesystem::path>& dependencies = snapshot[idx].dependencies;
+            for (const std::filesystem::path& dependency : dependencies)
+            {
+                if (std::ranges::find(changed, dependency) != changed.end()) affected[idx] = true;
+            }
+
+            for (u64 import_idx = 0; import_idx < idx && !affected[idx]; import_idx++)
+            {
+                if (affected[import_idx] && std::ranges::find(dependencies, snapshot[import_idx].load_path) != dependencies.end()) affected[idx] = true;
+            }
+
+            if (affected[idx]) affected_names.push_back(snapshot[idx].name);
+        }
+
+        if (affected_names.empty()) return status_type::NOTHING_TO_DO;
+
+        for (u64 idx = 0; idx < snapshot.size(); idx++)
+        {
+            if (!affected[idx]) continue;
+            const registered_module& module = snapshot[idx];
+            //Modules loaded from cached IR have nothing to recompile from, so they keep the IR built against the old imports.
+            if (!module.is_file && module.source.empty()) continue;
+
+            std::string source = module.source;
+            if (module.is_file)
+            {
+                const status read_status = read_text_file(module.load_path, source);
+                if (is_status_error(read_status)) return read_status;
+            }
+
+            //A fresh session holding only the modules registered before this one, including any already reloaded, so imports resolve to their new versions.
+            shader_worker_session worker;
+            u64 session_hash;
+            const status session_status = create_session({}, worker.session.writeRef(), session_hash);
+            if (is_status_error(session_status)) return session_status;
+
+            const status sync_status = sync_session(worker, idx);
+            if (is_status_error(sync_status)) return sync_status;
+
+            Slang::ComPtr<ISlangBlob> serialized_blob;
+            std::vector<std::filesystem::path> dependencies;
+            const status compile_status = compile_module_source(worker, module.name, source, module.load_path, serialized_blob, dependencies);
+            if (is_status_error(compile_status)) return compile_status;
+
+            //Hashed the same way as when the module was first loaded.
+            u64 content_hash;
+            {
+                std::shared_lock lock(registry_mutex);
+                const u64 source_hash = fnv1a_hash(source, fnv1a_hash(module.name, session_content_hash));
+                content_hash = import_content_hash(module.name, dependencies, module.is_file ? dependency_content_hash(dependencies, source_hash) : source_hash);
+            }
+
+            const status register_status = register_module({module.name, nullptr, content_hash, module.load_path, module.is_file, std::move(dependencies), module.source}, serialized_blob->getBufferPointer(), serialized_blob->getBufferSize());
+            if (is_status_error(register_status)) return register_status;
+        }
+
+        std::vector<std::pair<std::string, linked_set>> relink;
+        {
+            std::unique_lock lock(registry_mutex);
+            epoch++;
+
+            for (const auto& [name, set] : linked_sets)
+            {
+                bool uses_affected = false;
+                for (const shader_entry_point& entry_point : set.entry_points) uses_affected |= std::ranges::find(affected_names, entry_point.module_name) != affected_names.end();
+                for (const std::string& module_name : set.additional_modules) uses_affected |= std::ranges::find(affected_names, module_name) != affected_names.end();
+                if (uses_affected) relink.emplace_back(name, set);
+            }
+        }
+
+        for (const auto& [name, set] : relink)
+        {
+            const status link_status = link(name, set.entry_points, set.additional_modules);
+            if (is_status_error(link_status)) return link_status;
+            out_relinked_sets.push_back(name);
+        }
+
+        return status_type::SUCCESS;
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <slang-com-ptr.h>
+#include <slang.h>
+
+#include "stardraw/api/shaders.hpp"
+
+template <>
+struct std::hash<stardraw::shader_entry_point>
+{
+    std::size_t operator()(const stardraw::shader_entry_point& key) const noexcept
+    {
+        return hash<string>()(key.module_name + key.entry_point_name);
+    }
+};
+
+namespace stardraw
+{
+    //A slang session used by one thread. Registered modules are loaded into it from their IR on demand, in registration order, so imports resolve the same way in every session.
+    struct shader_worker_session
+    {
+        Slang::ComPtr<slang::ISession> session;
+        std::unordered_map<std::string, Slang::ComPtr<slang::IModule>> modules;
+        u64 synced_modules = 0;
+        u64 epoch = 0;
+        //Held while the session is in use. Linked sets keep their session alive, and programs can be generated from them on any thread.
+        std::mutex mutex;
+    };
+
+    //A session locked for the calling thread, and synced with every module registered so far.
+    struct shader_session_lock
+    {
+        std::shared_ptr<shader_worker_session> worker;
+        std::unique_lock<std::mutex> lock;
+    };
+
+    struct linked_set
+    {
+        //Kept so the set can be relinked when one of its modules is hot reloaded.
+        std::vector<shader_entry_point> entry_points;
+        std::vector<std::string> additional_modules;
+        std::shared_ptr<shader_worker_session> owner;
+        Slang::ComPtr<slang::IComponentType> linked_components;
+        std::unordered_map<shader_entry_point, u32> entry_point_indexes;
+        u64 content_hash;
+    };
+
+    /*
+    Owns the slang global session, the module registry and the linked sets. Each thread compiles in its own session, so module loads, links and program generation run concurrently.
+    The global session isn't thread safe, so creating sessions is serialised. Everything else only locks the registry briefly to read or publish results.
+    */
+    class shader_compiler
+    {
+    public:
+        [[nodiscard]] static shader_compiler& instance();
+
+        [[nodiscard]] status setup(const std::vector<shader_macro>& macro_defines);
+        [[nodiscard]] bool is_setup();
+
+        //Creates a standalone session with the setup macros plus the given ones defined. The hash covers the compiler version and every macro.
+        [[nodiscard]] status create_session(const std::vector<shader_macro>& additional_macros, slang::ISession** out_session, u64& out_content_hash);
+        [[nodiscard]] status acquire_session(shader_session_lock& out_lock);
+
+        [[nodiscard]] status load_module(const std::string_view& module_name, const std::string_view& source);
+        [[nodiscard]] status load_module(const std::string_view& module_name, const void* cache_ptr, const u64 cache_size);
+        [[nodiscard]] status load_module_file(const std::string_view& module_name, const std::filesystem::path& path);
+        [[nodiscard]] status serialize_module(const std::string& module_name, std::vector<u8>& out_data);
+        [[nodiscard]] status link(const std::string& linked_set_name, const std::vector<shader_entry_point>& entry_points, const std::vector<std::string>& additional_modules);
+        [[nodiscard]] status find_linked_set(const std::string& linked_set_name, linked_set& out_linked_set);
+
+        //Every file that a module loaded from disk was built from, including its includes and the files of modules it imports.
+        [[nodiscard]] std::vector<std::filesystem::path> dependency_files();
+
+        /*
+        Reloads every module built from one of the changed files, then every module that imports a reloaded one, and relinks every linked set using any of them.
+        Modules loaded from memory as source are recompiled from that source against their reloaded imports. Modules loaded from cached IR have no source, so they keep
+        the IR they were built with against the old imports until loaded again. Returns the names of the relinked sets.
+        */
+        [[nodiscard]] status reload_changed_files(const std::vector<std::filesystem::path>& changed_files, std::vector<std::string>& out_relinked_sets);
+
+    private:
+        struct registered_module
+        {
+            std::string name;
+            std::shared_ptr<const std::vector<u8>> ir;
+            u64 content_hash;
+            //Path the module was compiled from - a placeholder for modules loaded from memory. Other modules list it as a dependency when they import this one.
+            std::filesystem::path load_path;
+            bool is_file = false;
+            std::vector<std::filesystem::path> dependencies;
+            //Kept for modules loaded from memory as source, so they can be recompiled when an import is reloaded. Empty for file and IR modules.
+            std::string source;
+        };
+
+        [[nodiscard]] status register_module(registered_module&& entry, const void* ir_ptr, const u64 ir_size);
+        [[nodiscard]] status sync_session(shader_worker_session& worker, const u64 module_limit);
+        [[nodiscard]] status compile_module_source(shader_worker_session& worker, const std::string_view& module_name, const std::string& source, const std::filesystem::path& path, Slang::ComPtr<ISlangBlob>& out_ir, std::vector<std::filesystem::path>& out_dependencies);
+        [[nodiscard]] u64 import_content_hash(const std::string_view& module_name, const std::vector<std::filesystem::path>& dependencies, u64 hash) const;
+        [[nodiscard]] static status load_module_from_ir(shader_worker_session& worker, const std::string_view& module_name, const std::filesystem::path& path, const void* ir_ptr, const u64 ir_size);
+
+        slang::IGlobalSession* global_session = nullptr;
+        std::mutex global_session_mutex;
+
+        std::shared_mutex registry_mutex;
+        std::vector<shader_macro> macro_defines;
+        std::vector<registered_module> modules;
+        std::unordered_map<std::string, u64> module_indexes;
+        std::unordered_map<std::string, linked_set> linked_sets;
+        //Bumped whenever already registered modules change, so every worker session is rebuilt from the registry on its next use.
+        u64 epoch = 0;
+
+        //Cache keys. The session hash covers the compiler version and macros; module hashes cover their own source and the hashes of the modules they import.
+        u64 session_content_hash = 0;
+    };
+}
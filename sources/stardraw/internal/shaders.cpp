@@ -1,36 +1,30 @@
 #include "../api/shaders.hpp"
 #include "internal.hpp"
+#include "shader_cache.hpp"
+#include "shader_compiler.hpp"
+#include "file_watcher.hpp"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <deque>
 #include <format>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <queue>
+#include <thread>
+#include <ranges>
 #include <set>
 #include <slang-com-ptr.h>
 #include <slang.h>
 #include <spirv_glsl.hpp>
 #include <stack>
-
-template <>
-struct std::hash<stardraw::shader_entry_point>
-{
-    std::size_t operator()(const stardraw::shader_entry_point& key) const noexcept
-    {
-        return hash<string>()(key.module_name + key.entry_point_name);
-    }
-};
+#include <unordered_set>
 
 namespace stardraw
 {
-    struct linked_set
-    {
-        Slang::ComPtr<slang::IComponentType> linked_components;
-        std::unordered_map<shader_entry_point, u32> entry_point_indexes;
-    };
-
-    static slang::IGlobalSession* global_slang_context;
-    static slang::ISession* active_slang_session;
-    static std::unordered_map<std::string, Slang::ComPtr<slang::IModule>> loaded_modules;
-    static std::unordered_map<std::string, linked_set> linked_sets;
+    static shader_reflection_table* build_shader_reflection_table(slang::ShaderReflection* layout);
 
     status delete_shader_buffer_layout(shader_buffer_layout** buffer_layout)
     {
@@ -39,36 +33,92 @@ namespace stardraw
         return status_type::SUCCESS;
     }
 
-    void* layout_shader_buffer_memory(const shader_buffer_layout* layout, const void* data, const u64 data_size)
+    //Fixed size copies let the compiler emit single vector moves for the common scalar / vec2 / vec3 / vec4 runs.
+    static void copy_layout_run(u8* destination, const u8* source, const u64 size)
     {
-        if (layout == nullptr || data == nullptr) return nullptr;
+        switch (size)
+        {
+            case 4: memcpy(destination, source, 4); return;
+            case 8: memcpy(destination, source, 8); return;
+            case 12: memcpy(destination, source, 12); return;
+            case 16: memcpy(destination, source, 16); return;
+            default: memcpy(destination, source, size); return;
+        }
+    }
+
+    template <u64 run_size>
+    static void copy_layout_single_run(u8* destination, const u8* source, const u64 element_count, const u64 read_stride, const u64 write_stride, const u64 write_offset)
+    {
+        for (u64 idx = 0; idx < element_count; idx++)
+        {
+            memcpy(destination + write_stride * idx + write_offset, source + read_stride * idx, run_size);
+        }
+    }
+
+    status layout_shader_buffer_memory(const shader_buffer_layout* layout, const void* data, const u64 data_size, void* destination, const u64 destination_size)
+    {
+        if (layout == nullptr || data == nullptr || destination == nullptr) return status_type::UNEXPECTED;
+        if (layout->packed_size == 0) return {status_type::INVALID, "Buffer layout has a packed size of zero"};
+        if (data_size % layout->packed_size != 0) return {status_type::RANGE_OVERFLOW, std::format("Data size {0} is not a multiple of the packed element size {1}", data_size, layout->packed_size)};
 
         const u64 element_count = data_size / layout->packed_size;
+        if (layout->padded_size * element_count > destination_size) return {status_type::RANGE_OVERFLOW, std::format("Laid out data ({0} bytes) would overflow the destination ({1} bytes)", layout->padded_size * element_count, destination_size)};
+
         const u8* in_bytes = static_cast<const u8*>(data);
-        u8* output = static_cast<u8*>(malloc(layout->padded_size * element_count));
+        u8* out_bytes = static_cast<u8*>(destination);
+
         if (layout->padded_size == layout->packed_size)
         {
-            memcpy(output, in_bytes, layout->padded_size * element_count);
-            return output;
+            memcpy(out_bytes, in_bytes, data_size);
+            return status_type::SUCCESS;
         }
 
-        for (u64 idx = 0; idx < element_count; idx++)
+        if (layout->copy_runs.empty()) return {status_type::INVALID, "Buffer layout has no copy plan - layouts must be created with create_shader_buffer_layout"};
+
+        //Single run layouts (eg. a vec3 padded to a vec4) are by far the most common, so they get a dedicated strided loop.
+        if (layout->copy_runs.size() == 1)
         {
-            const u64 base_read_address = layout->packed_size * idx;
-            const u64 base_write_address = layout->padded_size * idx;
+            const shader_buffer_layout::copy_run& run = layout->copy_runs[0];
+            switch (run.size)
+            {
+                case 4: copy_layout_single_run<4>(out_bytes, in_bytes, element_count, layout->packed_size, layout->padded_size, run.write_offset); return status_type::SUCCESS;
+                case 8: copy_layout_single_run<8>(out_bytes, in_bytes, element_count, layout->packed_size, layout->padded_size, run.write_offset); return status_type::SUCCESS;
+                case 12: copy_layout_single_run<12>(out_bytes, in_bytes, element_count, layout->packed_size, layout->padded_size, run.write_offset); return status_type::SUCCESS;
+                case 16: copy_layout_single_run<16>(out_bytes, in_bytes, element_count, layout->packed_size, layout->padded_size, run.write_offset); return status_type::SUCCESS;
+                default: break;
+            }
+        }
 
-            u64 current_write_offset = 0;
-            u64 current_read_offset = 0;
+        for (u64 idx = 0; idx < element_count; idx++)
+        {
+            const u8* element_in = in_bytes + layout->packed_size * idx;
+            u8* element_out = out_bytes + layout->padded_size * idx;
 
-            for (const shader_buffer_layout::pad& pad : layout->pads)
+            for (const shader_buffer_layout::copy_run& run : layout->copy_runs)
             {
-                const u64 size_to_pad_start = pad.address - current_write_offset;
-                memcpy(output + base_write_address + current_write_offset, in_bytes + base_read_address + current_read_offset, size_to_pad_start);
-                current_write_offset = pad.address + pad.size;
-                current_read_offset += size_to_pad_start;
+                copy_layout_run(element_out + run.write_offset, element_in + run.read_offset, run.size);
             }
         }
 
+        return status_type::SUCCESS;
+    }
+
+    void* layout_shader_buffer_memory(const shader_buffer_layout* layout, const void* data, const u64 data_size)
+    {
+        if (layout == nullptr || data == nullptr || layout->packed_size == 0) return nullptr;
+
+        const u64 element_count = data_size / layout->packed_size;
+        const u64 output_size = layout->padded_size * element_count;
+        void* output = malloc(output_size);
+        if (output == nullptr) return nullptr;
+
+        const status layout_status = layout_shader_buffer_memory(layout, data, layout->packed_size * element_count, output, output_size);
+        if (is_status_error(layout_status))
+        {
+            free(output);
+            return nullptr;
+        }
+
         return output;
     }
 
@@ -85,247 +135,751 @@ namespace stardraw
 
     status setup_shader_compiler(const std::vector<shader_macro>& macro_defines)
     {
-        if (global_slang_context == nullptr)
+        return shader_compiler::instance().setup(macro_defines);
+    }
+
+    status load_shader_module(const std::string_view& module_name, const std::string_view& source)
+    {
+        return shader_compiler::instance().load_module(module_name, source);
+    }
+
+    status load_shader_module(const std::string_view& module_name, const void* cache_ptr, const u64 cache_size)
+    {
+        return shader_compiler::instance().load_module(module_name, cache_ptr, cache_size);
+    }
+
+    status load_shader_library(const std::vector<shader_module_source>& modules, const u32 max_threads)
+    {
+        const u32 thread_limit = max_threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : max_threads;
+        std::vector<const shader_module_source*> pending;
+        for (const shader_module_source& module : modules) pending.push_back(&module);
+
+        //Imports aren't known up front, so modules are loaded in waves. A module whose imports aren't registered yet fails and is retried next wave, until a wave makes no progress.
+        while (!pending.empty())
         {
-            const SlangResult result = slang::createGlobalSession(&global_slang_context);
-            if (SLANG_FAILED(result)) return {status_type::BACKEND_ERROR, "Slang context creation failed"};
+            std::vector<status> results(pending.size(), status_type::SUCCESS);
+            std::atomic<u64> next_module = 0;
+            std::vector<std::thread> workers;
+
+            for (u32 idx = 0; idx < std::min<u64>(thread_limit, pending.size()); idx++)
+            {
+                workers.emplace_back([&pending, &results, &next_module]
+                {
+                    for (u64 module_idx = next_module++; module_idx < pending.size(); module_idx = next_module++)
+                    {
+                        results[module_idx] = load_shader_module(pending[module_idx]->module_name, pending[module_idx]->source);
+                    }
+                });
+            }
+
+            for (std::thread& worker : workers) worker.join();
+
+            std::vector<const shader_module_source*> failed;
+            const status* first_error = nullptr;
+            for (u64 idx = 0; idx < pending.size(); idx++)
+            {
+                if (!is_status_error(results[idx])) continue;
+                failed.push_back(pending[idx]);
+                if (first_error == nullptr) first_error = &results[idx];
+            }
+
+            if (failed.size() == pending.size()) return *first_error;
+            pending = std::move(failed);
         }
 
-        if (active_slang_session != nullptr)
+        return status_type::SUCCESS;
+    }
+
+    status cache_shader_module(const std::string& module_name, void** out_cache_ptr, u64& out_cache_size)
+    {
+        std::vector<u8> serialized;
+        const status serialize_status = shader_compiler::instance().serialize_module(module_name, serialized);
+        if (is_status_error(serialize_status)) return serialize_status;
+
+        const u64 cache_size = serialized.size();
+
+        *out_cache_ptr = malloc(cache_size);
+        memcpy(*out_cache_ptr, serialized.data(), cache_size);
+        out_cache_size = cache_size;
+
+        return status_type::SUCCESS;
+    }
+
+    status link_shader_modules(const std::string& linked_set_name, const std::vector<shader_entry_point>& entry_points, const std::vector<std::string>& additional_modules)
+    {
+        return shader_compiler::instance().link(linked_set_name, entry_points, additional_modules);
+    }
+
+    //Fills in code, reflection and hashes for an entry point of a linked set. Shared by program creation and hot reloading.
+    //The program's layout belongs to out_linked_components, which has to outlive it - relinking the set drops the set's own reference.
+    static status generate_linked_program(const std::string& linked_set_name, const shader_entry_point& entry_point, const graphics_api& api, shader_program& result, Slang::ComPtr<slang::IComponentType>& out_linked_components)
+    {
+        linked_set linked_set;
+        const status find_status = shader_compiler::instance().find_linked_set(linked_set_name, linked_set);
+        if (is_status_error(find_status)) return find_status;
+        const Slang::ComPtr<slang::IComponentType> linked_shader = linked_set.linked_components;
+        out_linked_components = linked_shader;
+
+        if (!linked_set.entry_point_indexes.contains(entry_point)) return {status_type::UNKNOWN, "Entry point not found in linked set"};
+        const u32 entry_point_idx = linked_set.entry_point_indexes.at(entry_point);
+
+        const int target_index = get_target_index_for_api(api);
+        if (target_index == -1) return {status_type::UNSUPPORTED, "API selected is not currently supported for slang shaders"};
+
+        result.api = api;
+        result.content_hash = fnv1a_hash_value(target_index, fnv1a_hash_value(entry_point_idx, linked_set.content_hash));
+
+        //The linked components belong to the session that linked them, which may be in use on another thread.
+        std::lock_guard session_lock(linked_set.owner->mutex);
+
+        std::vector<u8> cached_code;
+        if (read_shader_cache(result.content_hash, "spv", cached_code))
         {
-            const SlangResult delete_result = active_slang_session->release();
-            delete active_slang_session;
+            result.data_size = cached_code.size();
+            result.data = malloc(result.data_size);
+            memcpy(result.data, cached_code.data(), result.data_size);
+        }
+        else
+        {
+            Slang::ComPtr<slang::IBlob> shader_blob;
+            Slang::ComPtr<slang::IBlob> diagnostics;
+
+            linked_shader->getEntryPointCode(entry_point_idx, target_index, shader_blob.writeRef(), diagnostics.writeRef());
+
+            if (diagnostics)
+            {
+                std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
+                return {status_type::BACKEND_ERROR, std::format("Slang shader data for '{1}' failed with error: '{0}'", msg, linked_set_name)};
+            }
 
-            loaded_modules.clear();
+            if (!shader_blob)
+            {
+                return {status_type::BACKEND_ERROR, std::format("Slang shader data for '{0}' failed with unknown error", linked_set_name)};
+            }
 
-            if (SLANG_FAILED(delete_result)) return {status_type::BACKEND_ERROR, "Deleting previous slang session failed"};
+            result.data_size = shader_blob->getBufferSize();
+            result.data = malloc(result.data_size);
+            memcpy(result.data, shader_blob->getBufferPointer(), result.data_size);
+            write_shader_cache(result.content_hash, "spv", result.data, result.data_size);
         }
 
-        std::vector<slang::CompilerOptionEntry> compiler_options;
-        for (const shader_macro& macro : macro_defines)
         {
-            compiler_options.push_back(slang::CompilerOptionEntry {
-                slang::CompilerOptionName::MacroDefine,
-                slang::CompilerOptionValue {
-                    slang::CompilerOptionValueKind::String,
-                    0, 0, macro.name.data(), macro.value.data()
-                }
-            });
+            Slang::ComPtr<slang::IBlob> diagnostics;
+            slang::ShaderReflection* layout = linked_shader->getLayout(target_index, diagnostics.writeRef());
+
+            if (diagnostics)
+            {
+                std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
+                return {status_type::BACKEND_ERROR, std::format("Slang shader layout for '{1}' failed with error: '{0}'", msg, linked_set_name)};
+            }
+
+            result.internal_ptr = layout;
+            result.reflection_table = build_shader_reflection_table(layout);
         }
 
-        slang::SessionDesc session_desc;
+        return status_type::SUCCESS;
+    }
 
-        const static std::array slang_targets = {
-            slang::TargetDesc {
-                .format = SlangCompileTarget::SLANG_SPIRV,
-                .profile = global_slang_context->findProfile("spirv_latest"),
-            },
-        };
+    //Programs created from linked sets, so hot reloads know what to regenerate them from.
+    struct live_program
+    {
+        std::string linked_set_name;
+        shader_entry_point entry_point;
+        graphics_api api;
+        //Tables replaced by reloads. Locations found before a reload still point into them, so they live as long as the program.
+        std::vector<shader_reflection_table*> retired_tables;
+        //Owns the layout behind the program's internal_ptr.
+        Slang::ComPtr<slang::IComponentType> linked_components;
+        //Generation of the reload last swapped into the program, 0 if never reloaded.
+        u64 reload_generation = 0;
+    };
 
-        session_desc.targets = slang_targets.data();
-        session_desc.targetCount = slang_targets.size();
+    static std::unordered_map<shader_program*, live_program> live_programs;
+    static std::mutex live_programs_mutex;
 
-        session_desc.compilerOptionEntries = compiler_options.data();
-        session_desc.compilerOptionEntryCount = compiler_options.size();
+    status create_shader_program(const std::string& linked_set_name, const shader_entry_point& entry_point, const graphics_api& api, shader_program** out_shader_program)
+    {
+        if (out_shader_program == nullptr) return status_type::UNEXPECTED;
+        *out_shader_program = new shader_program();
 
-        session_desc.searchPaths = nullptr;
-        session_desc.searchPathCount = 0;
+        Slang::ComPtr<slang::IComponentType> linked_components;
+        const status generate_status = generate_linked_program(linked_set_name, entry_point, api, **out_shader_program, linked_components);
+        if (is_status_error(generate_status)) return generate_status;
 
-        const SlangResult session_creation = global_slang_context->createSession(session_desc, &active_slang_session);
-        if (SLANG_FAILED(session_creation)) return {status_type::BACKEND_ERROR, "Slang session creation failed"};
+        std::lock_guard lock(live_programs_mutex);
+        live_programs[*out_shader_program] = {linked_set_name, entry_point, api, {}, linked_components};
+        return status_type::SUCCESS;
+    }
 
+    status delete_shader_program(shader_program** shader_program)
+    {
+        if (shader_program == nullptr || *shader_program == nullptr) return status_type::UNEXPECTED;
+
+        {
+            std::lock_guard lock(live_programs_mutex);
+            if (const auto live = live_programs.find(*shader_program); live != live_programs.end())
+            {
+                for (const shader_reflection_table* table : live->second.retired_tables) delete table;
+                live_programs.erase(live);
+            }
+        }
+
+        free((*shader_program)->data);
+        delete (*shader_program)->reflection_table;
+        delete *shader_program;
+        *shader_program = nullptr;
         return status_type::SUCCESS;
     }
 
-    status load_shader_module(const std::string_view& module_name, const std::string_view& source)
+    struct program_reload
     {
-        const std::string fake_path = std::format("{0}_fakepath.slang", module_name);
-        Slang::ComPtr<slang::IBlob> diagnostics;
-        const Slang::ComPtr module(active_slang_session->loadModuleFromSourceString(module_name.data(), fake_path.c_str(), source.data(), diagnostics.writeRef()));
+        shader_program* program;
+        shader_program replacement;
+        Slang::ComPtr<slang::IComponentType> linked_components;
+    };
 
-        if (diagnostics)
+    static void free_program_reload(program_reload& reload)
+    {
+        free(reload.replacement.data);
+        delete reload.replacement.reflection_table;
+    }
+
+    //Background rebuilds triggered by the file watcher. Finished rebuilds wait in ready_reloads until apply_shader_reloads swaps them in.
+    //Swaps and failures are numbered from one generation counter, so every caller of apply_shader_reloads can catch up on what it hasn't seen yet.
+    static struct hot_reload_state
+    {
+        ~hot_reload_state()
         {
-            std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
-            return {status_type::BACKEND_ERROR, std::format("Slang module loading '{1}' failed with error: '{0}'", msg, module_name)};
+            running = false;
+            if (thread.joinable()) thread.join();
+            for (program_reload& reload : ready_reloads) free_program_reload(reload);
         }
 
-        if (!module)
+        std::thread thread;
+        std::atomic<bool> running = false;
+        std::unique_ptr<file_watcher> watcher;
+        std::mutex mutex;
+        std::vector<program_reload> ready_reloads;
+        status failure = status_type::SUCCESS;
+        u64 failure_generation = 0;
+        std::atomic<u64> generation = 0;
+        //Used by callers that don't track their own generation.
+        u64 shared_seen_generation = 0;
+    } hot_reload;
+
+    static void watch_dependency_files()
+    {
+        for (const std::filesystem::path& path : shader_compiler::instance().dependency_files())
         {
-            std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
-            return {status_type::BACKEND_ERROR, std::format("Slang module '{1}' loading failed with error: '{0}'", msg, module_name)};
+            (void)hot_reload.watcher->watch(path);
+        }
+    }
+
+    static status rebuild_changed_programs(const std::vector<std::filesystem::path>& changed_files)
+    {
+        std::vector<std::string> relinked_sets;
+        const status reload_status = shader_compiler::instance().reload_changed_files(changed_files, relinked_sets);
+        if (is_status_error(reload_status) || reload_status.type == status_type::NOTHING_TO_DO) return reload_status;
+
+        //Reloaded modules may have gained includes.
+        watch_dependency_files();
+
+        std::vector<std::pair<shader_program*, live_program>> affected;
+        {
+            std::lock_guard lock(live_programs_mutex);
+            for (const auto& [program, live] : live_programs)
+            {
+                if (std::ranges::find(relinked_sets, live.linked_set_name) != relinked_sets.end()) affected.emplace_back(program, live);
+            }
+        }
+
+        std::vector<program_reload> reloads;
+        for (const auto& [program, live] : affected)
+        {
+            program_reload reload = {program, {}, {}};
+            const status generate_status = generate_linked_program(live.linked_set_name, live.entry_point, live.api, reload.replacement, reload.linked_components);
+            if (is_status_error(generate_status))
+            {
+                free_program_reload(reload);
+                for (program_reload& generated : reloads) free_program_reload(generated);
+                return generate_status;
+            }
+
+            reloads.push_back(reload);
         }
 
-        loaded_modules[std::string(module_name)] = module;
+        std::lock_guard lock(hot_reload.mutex);
+        for (program_reload& reload : reloads)
+        {
+            //A newer rebuild of a program that hasn't been applied yet supersedes the older one.
+            const auto existing = std::ranges::find(hot_reload.ready_reloads, reload.program, &program_reload::program);
+            if (existing != hot_reload.ready_reloads.end())
+            {
+                free_program_reload(*existing);
+                *existing = reload;
+            }
+            else hot_reload.ready_reloads.push_back(reload);
+        }
 
         return status_type::SUCCESS;
     }
 
-    status load_shader_module(const std::string_view& module_name, const void* cache_ptr, const u64 cache_size)
+    status load_shader_module_file(const std::string_view& module_name, const std::filesystem::path& path)
     {
-        const std::string fake_path = std::format("{0}_fakepath.slang", module_name);
-        Slang::ComPtr<slang::IBlob> diagnostics;
+        const status load_status = shader_compiler::instance().load_module_file(module_name, path);
+        if (is_status_error(load_status)) return load_status;
 
-        const Slang::ComPtr module(active_slang_session->loadModuleFromIRBlob(module_name.data(), fake_path.c_str(), slang_createBlob(cache_ptr, cache_size), diagnostics.writeRef()));
+        std::lock_guard lock(hot_reload.mutex);
+        if (hot_reload.watcher != nullptr) watch_dependency_files();
+        return load_status;
+    }
 
-        if (diagnostics)
+    status set_shader_hot_reload(const bool enabled)
+    {
+        if (enabled == hot_reload.running) return status_type::NOTHING_TO_DO;
+
+        if (!enabled)
         {
-            std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
-            return {status_type::BACKEND_ERROR, std::format("Slang module loading '{1}' failed with error: '{0}'", msg, module_name)};
+            hot_reload.running = false;
+            hot_reload.thread.join();
+            std::lock_guard lock(hot_reload.mutex);
+            hot_reload.watcher.reset();
+            return status_type::SUCCESS;
         }
 
-        if (!module)
         {
-            return {status_type::BACKEND_ERROR, std::format("Slang module '{0}' loading failed with unknwon error", module_name)};
+            std::lock_guard lock(hot_reload.mutex);
+            hot_reload.watcher = std::make_unique<file_watcher>();
+            watch_dependency_files();
         }
 
-        loaded_modules[std::string(module_name)] = module;
+        hot_reload.running = true;
+        hot_reload.thread = std::thread([]
+        {
+            while (hot_reload.running)
+            {
+                const std::vector<std::filesystem::path> changes = hot_reload.watcher->wait_for_changes(std::chrono::milliseconds(100));
+                if (changes.empty()) continue;
+
+                const status rebuild_status = rebuild_changed_programs(changes);
+                if (!is_status_error(rebuild_status)) continue;
+
+                std::lock_guard lock(hot_reload.mutex);
+                hot_reload.failure = rebuild_status;
+                hot_reload.failure_generation = ++hot_reload.generation;
+            }
+        });
 
         return status_type::SUCCESS;
     }
 
-    status cache_shader_module(const std::string& module_name, void** out_cache_ptr, u64& out_cache_size)
+    u64 shader_reload_generation()
+    {
+        return hot_reload.generation;
+    }
+
+    status apply_shader_reloads(std::vector<shader_program*>* out_reloaded_programs, u64* io_seen_generation)
     {
-        if (!loaded_modules.contains(module_name)) return {status_type::UNKNOWN, std::format("No loaded slang module called '{0}' found.", module_name)};
-        const Slang::ComPtr<slang::IModule> module = loaded_modules[module_name];
+        std::vector<program_reload> reloads;
+        status failure = status_type::SUCCESS;
+        u64 failure_generation;
+        {
+            std::lock_guard lock(hot_reload.mutex);
+            reloads.swap(hot_reload.ready_reloads);
+            failure = hot_reload.failure;
+            failure_generation = hot_reload.failure_generation;
+        }
 
-        Slang::ComPtr<ISlangBlob> serialized_blob;
-        const SlangResult serialize_result = module->serialize(serialized_blob.writeRef());
-        if (SLANG_FAILED(serialize_result)) return {status_type::BACKEND_ERROR, std::format("Failed to serialize module '{0}'", module_name)};
+        std::lock_guard lock(live_programs_mutex);
+        u64& seen_generation = io_seen_generation != nullptr ? *io_seen_generation : hot_reload.shared_seen_generation;
+        for (program_reload& reload : reloads)
+        {
+            const auto live = live_programs.find(reload.program);
+            if (live == live_programs.end())
+            {
+                free_program_reload(reload);
+                continue;
+            }
 
-        const u64 cache_size = serialized_blob->getBufferSize();
+            //The old layout is only released once the program no longer points at it.
+            live->second.retired_tables.push_back(reload.program->reflection_table);
+            free(reload.program->data);
+            *reload.program = reload.replacement;
+            live->second.linked_components = reload.linked_components;
+            live->second.reload_generation = ++hot_reload.generation;
+        }
 
-        *out_cache_ptr = malloc(cache_size);
-        memcpy(*out_cache_ptr, serialized_blob->getBufferPointer(), cache_size);
-        out_cache_size = cache_size;
+        //Programs swapped in by any caller since this one last looked, including by this call.
+        //Only generations actually observed are marked seen, so a failure recorded meanwhile is reported next time.
+        u64 observed_generation = std::max(seen_generation, failure_generation);
+        bool any_reloaded = false;
+        for (const auto& [program, live] : live_programs)
+        {
+            if (live.reload_generation <= seen_generation) continue;
+            any_reloaded = true;
+            observed_generation = std::max(observed_generation, live.reload_generation);
+            if (out_reloaded_programs != nullptr) out_reloaded_programs->push_back(program);
+        }
 
-        return status_type::SUCCESS;
+        const bool unseen_failure = failure_generation > seen_generation;
+        seen_generation = observed_generation;
+        if (unseen_failure && is_status_error(failure)) return failure;
+        return any_reloaded ? status_type::SUCCESS : status_type::NOTHING_TO_DO;
     }
 
+    shader_parameter_location relocate_shader_parameter(const shader_parameter_location& location, const shader_program* program)
+    {
+        if (location.reflection == nullptr || program->reflection_table == nullptr) return invalid_shader_paramter_location;
+        if (location.table == program->reflection_table) return location;
 
-    status link_shader_modules(const std::string& linked_set_name, const std::vector<shader_entry_point>& entry_points, const std::vector<std::string>& additional_modules)
+        const auto entry = program->reflection_table->entries.find(location.path_hash);
+        if (entry == program->reflection_table->entries.end()) return invalid_shader_paramter_location;
+
+        shader_parameter_location result = location;
+        result.table = program->reflection_table;
+        result.reflection = &entry->second;
+        result.byte_address = location.byte_address - location.reflection->byte_offset + entry->second.byte_offset;
+        return result;
+    }
+
+    struct shader_variant
     {
-        std::vector<slang::IComponentType*> shader_components;
-        std::unordered_map<shader_entry_point, u32> entry_point_index_map;
+        Slang::ComPtr<slang::ISession> session;
+        Slang::ComPtr<slang::IComponentType> linked_components;
+        u64 content_hash = 0;
+        //Per entry point, null until first requested. Points into the owning set's programs.
+        std::vector<shader_program*> programs;
+        //Ready once the session is compiled, so callers wanting the same variant wait on it instead of compiling it again.
+        std::shared_future<status> compiled;
+        //Slang sessions aren't thread safe - guards the session and programs once compiled.
+        std::mutex mutex;
+    };
+
+    struct shader_variant_set
+    {
+        shader_variant_set_info info;
+        std::unordered_map<u64, std::unique_ptr<shader_variant>> variants;
+        //Every generated program keyed by a hash of its code, so identical variants share one program.
+        std::unordered_map<u64, shader_program*> programs_by_code;
+        std::future<status> precompile;
+        //Permutations waiting for the running precompile, guarded by mutex. The precompile keeps going until this is empty.
+        std::deque<std::pair<std::vector<shader_macro>, graphics_api>> precompile_queue;
+        bool precompile_running = false;
+        //Only guards the maps above. Compiles run outside it, so different variants compile in parallel.
+        std::mutex mutex;
+    };
+
+    static std::unordered_map<std::string, std::unique_ptr<shader_variant_set>> variant_sets;
+    static std::mutex variant_sets_mutex;
+
+    static shader_variant_set* find_variant_set(const std::string& variant_set_name)
+    {
+        std::lock_guard lock(variant_sets_mutex);
+        const auto it = variant_sets.find(variant_set_name);
+        return it == variant_sets.end() ? nullptr : it->second.get();
+    }
+
+    static status canonicalize_permutation(const shader_variant_set& set, const std::vector<shader_macro>& permutation, std::vector<shader_macro>& out_macros, u64& out_hash)
+    {
+        out_macros = permutation;
+        std::ranges::sort(out_macros, {}, &shader_macro::name);
 
-        for (u32 idx = 0; idx < entry_points.size(); idx++)
+        out_hash = fnv1a_offset_basis;
+        for (u64 idx = 0; idx < out_macros.size(); idx++)
         {
-            const shader_entry_point& entry_point = entry_points[idx];
+            const shader_macro& macro = out_macros[idx];
+            if (std::ranges::find(set.info.permutation_keys, macro.name) == set.info.permutation_keys.end())
+            {
+                return {status_type::UNKNOWN, std::format("'{0}' is not a permutation key of the variant set", macro.name)};
+            }
+
+            if (idx > 0 && out_macros[idx - 1].name == macro.name)
+            {
+                return {status_type::DUPLICATE, std::format("Permutation key '{0}' is defined more than once", macro.name)};
+            }
 
-            if (!loaded_modules.contains(entry_point.module_name)) return {status_type::UNKNOWN, std::format("No loaded slang module called '{0}' found.", entry_point.module_name)};
-            const Slang::ComPtr<slang::IModule> module = loaded_modules[entry_point.module_name];
+            out_hash = fnv1a_hash(macro.value, fnv1a_hash(macro.name, out_hash));
+        }
 
-            Slang::ComPtr<slang::IEntryPoint> slang_entry_point;
+        return status_type::SUCCESS;
+    }
+
+    static status compile_shader_variant(const shader_variant_set& set, const std::vector<shader_macro>& permutation, shader_variant& out_variant)
+    {
+        const status session_status = shader_compiler::instance().create_session(permutation, out_variant.session.writeRef(), out_variant.content_hash);
+        if (is_status_error(session_status)) return session_status;
+
+        std::unordered_map<std::string, Slang::ComPtr<slang::IModule>> modules;
+        for (const shader_module_source& module_source : set.info.modules)
+        {
+            const std::string fake_path = std::format("{0}_fakepath.slang", module_source.module_name);
+            Slang::ComPtr<slang::IBlob> diagnostics;
+            const Slang::ComPtr module(out_variant.session->loadModuleFromSourceString(module_source.module_name.c_str(), fake_path.c_str(), module_source.source.c_str(), diagnostics.writeRef()));
+
+            if (diagnostics)
+            {
+                std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
+                return {status_type::BACKEND_ERROR, std::format("Slang module loading '{1}' failed with error: '{0}'", msg, module_source.module_name)};
+            }
+
+            if (!module) return {status_type::BACKEND_ERROR, std::format("Slang module '{0}' loading failed with unknown error", module_source.module_name)};
+
+            modules[module_source.module_name] = module;
+            out_variant.content_hash = fnv1a_hash(module_source.source, fnv1a_hash(module_source.module_name, out_variant.content_hash));
+        }
+
+        std::vector<slang::IComponentType*> shader_components;
+        std::vector<Slang::ComPtr<slang::IEntryPoint>> slang_entry_points;
+        for (const shader_entry_point& entry_point : set.info.entry_points)
+        {
+            if (!modules.contains(entry_point.module_name)) return {status_type::UNKNOWN, std::format("No module called '{0}' in the variant set.", entry_point.module_name)};
 
-            const SlangResult found_entry_point = module->findEntryPointByName(entry_point.entry_point_name.c_str(), slang_entry_point.writeRef());
+            Slang::ComPtr<slang::IEntryPoint> slang_entry_point;
+            const SlangResult found_entry_point = modules[entry_point.module_name]->findEntryPointByName(entry_point.entry_point_name.c_str(), slang_entry_point.writeRef());
             if (SLANG_FAILED(found_entry_point)) return {status_type::BACKEND_ERROR, std::format("Couldn't find entry point named '{0}' in module '{1}'", entry_point.entry_point_name, entry_point.module_name)};
 
             shader_components.push_back(slang_entry_point);
-            entry_point_index_map[entry_point] = idx;
+            slang_entry_points.push_back(slang_entry_point);
+            out_variant.content_hash = fnv1a_hash(entry_point.entry_point_name, fnv1a_hash(entry_point.module_name, out_variant.content_hash));
         }
 
-        for (const std::string& module_name : additional_modules)
+        for (const shader_module_source& module_source : set.info.modules)
         {
-            if (!loaded_modules.contains(module_name)) return {status_type::UNKNOWN, std::format("No loaded slang module called '{0}' found.", module_name)};
-            const Slang::ComPtr<slang::IModule> additional_module = loaded_modules[module_name];
-            shader_components.push_back(additional_module);
+            shader_components.push_back(modules[module_source.module_name]);
         }
 
         Slang::ComPtr<slang::IComponentType> composite;
 
         {
             Slang::ComPtr<slang::IBlob> diagnostics;
-            active_slang_session->createCompositeComponentType(shader_components.data(), shader_components.size(), composite.writeRef(), diagnostics.writeRef());
+            out_variant.session->createCompositeComponentType(shader_components.data(), shader_components.size(), composite.writeRef(), diagnostics.writeRef());
 
             if (diagnostics)
             {
                 std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
-                return {status_type::BACKEND_ERROR, std::format("Slang shader linking for '{1}' failed with error: '{0}'", msg, linked_set_name)};
+                return {status_type::BACKEND_ERROR, std::format("Slang shader linking for variant failed with error: '{0}'", msg)};
             }
         }
 
-        Slang::ComPtr<slang::IComponentType> linked_program;
-
         {
             Slang::ComPtr<slang::IBlob> diagnostics;
-            composite->link(linked_program.writeRef(), diagnostics.writeRef());
+            composite->link(out_variant.linked_components.writeRef(), diagnostics.writeRef());
 
             if (diagnostics)
             {
                 std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
-                return {status_type::BACKEND_ERROR, std::format("Slang shader linking for '{1}' failed with error: '{0}'", msg, linked_set_name)};
+                return {status_type::BACKEND_ERROR, std::format("Slang shader linking for variant failed with error: '{0}'", msg)};
             }
         }
 
-
-        linked_sets[linked_set_name] = {
-            linked_program,
-            std::move(entry_point_index_map)
-        };
-
+        out_variant.programs.assign(set.info.entry_points.size(), nullptr);
         return status_type::SUCCESS;
     }
 
-    status create_shader_program(const std::string& linked_set_name, const shader_entry_point& entry_point, const graphics_api& api, shader_program** out_shader_program)
+    static status generate_variant_program(shader_variant_set& set, shader_variant& variant, const u32 entry_point_idx, const int target_index, const graphics_api& api)
     {
-        if (out_shader_program == nullptr) return status_type::UNEXPECTED;
-        *out_shader_program = new shader_program();
-        shader_program* result = *out_shader_program;
-
-        if (!linked_sets.contains(linked_set_name)) return {status_type::UNKNOWN, std::format("No linked slang shader called '{0}' exists.", linked_set_name)};
-        const linked_set& linked_set = linked_sets[linked_set_name];
-        const Slang::ComPtr<slang::IComponentType> linked_shader = linked_set.linked_components;
-
-        if (!linked_set.entry_point_indexes.contains(entry_point)) return {status_type::UNKNOWN, "Entry point not found in linked set"};
-        const u32 entry_point_idx = linked_set.entry_point_indexes.at(entry_point);
-
-        const int target_index = get_target_index_for_api(api);
-        if (target_index == -1) return {status_type::UNSUPPORTED, "API selected is not currently supported for slang shaders"};
+        const u64 content_hash = fnv1a_hash_value(target_index, fnv1a_hash_value(entry_point_idx, variant.content_hash));
 
+        std::vector<u8> code;
+        if (!read_shader_cache(content_hash, "spv", code))
         {
             Slang::ComPtr<slang::IBlob> shader_blob;
             Slang::ComPtr<slang::IBlob> diagnostics;
-
-            linked_shader->getEntryPointCode(entry_point_idx, target_index, shader_blob.writeRef(), diagnostics.writeRef());
+            variant.linked_components->getEntryPointCode(entry_point_idx, target_index, shader_blob.writeRef(), diagnostics.writeRef());
 
             if (diagnostics)
             {
                 std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
-                return {status_type::BACKEND_ERROR, std::format("Slang shader data for '{1}' failed with error: '{0}'", msg, linked_set_name)};
+                return {status_type::BACKEND_ERROR, std::format("Slang shader data for variant failed with error: '{0}'", msg)};
             }
 
-            if (!shader_blob)
+            if (!shader_blob) return {status_type::BACKEND_ERROR, "Slang shader data for variant failed with unknown error"};
+
+            const u8* code_ptr = static_cast<const u8*>(shader_blob->getBufferPointer());
+            code.assign(code_ptr, code_ptr + shader_blob->getBufferSize());
+            write_shader_cache(content_hash, "spv", code.data(), code.size());
+        }
+
+        //Permutation keys that don't affect an entry point produce identical code - share the program that already exists.
+        const u64 code_hash = fnv1a_hash_value(target_index, fnv1a_hash(code.data(), code.size(), fnv1a_offset_basis));
+        std::lock_guard lock(set.mutex);
+        if (const auto existing = set.programs_by_code.find(code_hash); existing != set.programs_by_code.end())
+        {
+            variant.programs[entry_point_idx] = existing->second;
+            return status_type::SUCCESS;
+        }
+
+        Slang::ComPtr<slang::IBlob> diagnostics;
+        slang::ShaderReflection* layout = variant.linked_components->getLayout(target_index, diagnostics.writeRef());
+
+        if (diagnostics)
+        {
+            std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
+            return {status_type::BACKEND_ERROR, std::format("Slang shader layout for variant failed with error: '{0}'", msg)};
+        }
+
+        shader_program* program = new shader_program();
+        program->api = api;
+        program->content_hash = content_hash;
+        program->data_size = code.size();
+        program->data = malloc(program->data_size);
+        memcpy(program->data, code.data(), program->data_size);
+        program->internal_ptr = layout;
+        program->reflection_table = build_shader_reflection_table(layout);
+
+        set.programs_by_code[code_hash] = program;
+        variant.programs[entry_point_idx] = program;
+        return status_type::SUCCESS;
+    }
+
+    static status resolve_shader_variant(shader_variant_set& set, const std::vector<shader_macro>& permutation, const u32 entry_point_idx, const graphics_api& api, shader_program** out_shader_program)
+    {
+        const int target_index = get_target_index_for_api(api);
+        if (target_index == -1) return {status_type::UNSUPPORTED, "API selected is not currently supported for slang shaders"};
+
+        std::vector<shader_macro> macros;
+        u64 permutation_hash;
+        const status permutation_status = canonicalize_permutation(set, permutation, macros, permutation_hash);
+        if (is_status_error(permutation_status)) return permutation_status;
+
+        //The first caller for a permutation claims its slot and compiles it; everyone else waits on that compile.
+        shader_variant* variant;
+        std::promise<status> compile_promise;
+        std::shared_future<status> compiled;
+        bool compiles_here = false;
+        {
+            std::lock_guard lock(set.mutex);
+            std::unique_ptr<shader_variant>& slot = set.variants[permutation_hash];
+            if (slot == nullptr)
             {
-                return {status_type::BACKEND_ERROR, std::format("Slang shader data for '{0}' failed with unknown error", linked_set_name)};
+                slot = std::make_unique<shader_variant>();
+                slot->compiled = compile_promise.get_future().share();
+                compiles_here = true;
             }
-
-            result->api = api;
-            result->data_size = shader_blob->getBufferSize();
-            result->data = malloc(result->data_size);
-            memcpy(result->data, shader_blob->getBufferPointer(), result->data_size);
+            variant = slot.get();
+            compiled = variant->compiled;
         }
 
+        if (compiles_here)
         {
-            Slang::ComPtr<slang::IBlob> diagnostics;
-            slang::ShaderReflection* layout = linked_shader->getLayout(target_index, diagnostics.writeRef());
+            const status compile_status = compile_shader_variant(set, macros, *variant);
+            compile_promise.set_value(compile_status);
 
-            if (diagnostics)
+            //Failed variants aren't kept, so a later request tries again. Waiters only hold the future, not the variant.
+            if (is_status_error(compile_status))
             {
-                std::string msg = std::string(static_cast<const char*>(diagnostics->getBufferPointer()));
-                return {status_type::BACKEND_ERROR, std::format("Slang shader layout for '{1}' failed with error: '{0}'", msg, linked_set_name)};
+                std::lock_guard lock(set.mutex);
+                set.variants.erase(permutation_hash);
+                return compile_status;
             }
+        }
 
-            result->internal_ptr = layout;
+        const status compile_status = compiled.get();
+        if (is_status_error(compile_status)) return compile_status;
+
+        std::lock_guard variant_lock(variant->mutex);
+        if (variant->programs[entry_point_idx] == nullptr)
+        {
+            const status program_status = generate_variant_program(set, *variant, entry_point_idx, target_index, api);
+            if (is_status_error(program_status)) return program_status;
         }
 
+        if (out_shader_program != nullptr) *out_shader_program = variant->programs[entry_point_idx];
         return status_type::SUCCESS;
     }
 
-    status delete_shader_program(shader_program** shader_program)
+    status declare_shader_variants(const std::string& variant_set_name, const shader_variant_set_info& info)
     {
-        if (shader_program == nullptr || *shader_program == nullptr) return status_type::UNEXPECTED;
-        free((*shader_program)->data);
-        delete *shader_program;
-        *shader_program = nullptr;
+        if (!shader_compiler::instance().is_setup()) return {status_type::NOT_INITIALIZED, "Shader compiler has not been set up"};
+        if (info.entry_points.empty()) return {status_type::UNEXPECTED, std::format("Variant set '{0}' has no entry points", variant_set_name)};
+
+        std::lock_guard lock(variant_sets_mutex);
+        if (variant_sets.contains(variant_set_name)) return {status_type::DUPLICATE, std::format("A variant set called '{0}' already exists", variant_set_name)};
+
+        std::unique_ptr<shader_variant_set> set = std::make_unique<shader_variant_set>();
+        set->info = info;
+        variant_sets[variant_set_name] = std::move(set);
+        return status_type::SUCCESS;
+    }
+
+    status get_shader_variant(const std::string& variant_set_name, const std::vector<shader_macro>& permutation, const shader_entry_point& entry_point, const graphics_api& api, shader_program** out_shader_program)
+    {
+        if (out_shader_program == nullptr) return status_type::UNEXPECTED;
+
+        shader_variant_set* set = find_variant_set(variant_set_name);
+        if (set == nullptr) return {status_type::UNKNOWN, std::format("No variant set called '{0}' exists.", variant_set_name)};
+
+        const auto entry_point_it = std::ranges::find(set->info.entry_points, entry_point);
+        if (entry_point_it == set->info.entry_points.end()) return {status_type::UNKNOWN, "Entry point not found in variant set"};
+
+        return resolve_shader_variant(*set, permutation, static_cast<u32>(entry_point_it - set->info.entry_points.begin()), api, out_shader_program);
+    }
+
+    status precompile_shader_variants(const std::string& variant_set_name, const std::vector<std::vector<shader_macro>>& manifest, const graphics_api& api)
+    {
+        shader_variant_set* set = find_variant_set(variant_set_name);
+        if (set == nullptr) return {status_type::UNKNOWN, std::format("No variant set called '{0}' exists.", variant_set_name)};
+        {
+            std::lock_guard lock(set->mutex);
+            for (const std::vector<shader_macro>& permutation : manifest) set->precompile_queue.emplace_back(permutation, api);
+            if (set->precompile_running) return status_type::SUCCESS;
+            set->precompile_running = true;
+        }
+
+        set->precompile = std::async(std::launch::async, [set]() -> status
+        {
+            //Keeps failures from dropping permutations queued after them - the first failure is reported once the queue is empty.
+            status result = status_type::SUCCESS;
+            while (true)
+            {
+                std::pair<std::vector<shader_macro>, graphics_api> next;
+                {
+                    std::lock_guard lock(set->mutex);
+                    if (set->precompile_queue.empty())
+                    {
+                        set->precompile_running = false;
+                        return result;
+                    }
+
+                    next = std::move(set->precompile_queue.front());
+                    set->precompile_queue.pop_front();
+                }
+
+                for (u32 idx = 0; idx < set->info.entry_points.size(); idx++)
+                {
+                    const status variant_status = resolve_shader_variant(*set, next.first, idx, next.second, nullptr);
+                    if (is_status_error(variant_status) && !is_status_error(result)) result = variant_status;
+                }
+            }
+        });
+
+        return status_type::SUCCESS;
+    }
+
+    status wait_shader_variant_precompile(const std::string& variant_set_name)
+    {
+        shader_variant_set* set = find_variant_set(variant_set_name);
+        if (set == nullptr) return {status_type::UNKNOWN, std::format("No variant set called '{0}' exists.", variant_set_name)};
+        if (!set->precompile.valid()) return status_type::NOTHING_TO_DO;
+
+        return set->precompile.get();
+    }
+
+    status delete_shader_variants(const std::string& variant_set_name)
+    {
+        shader_variant_set* set = find_variant_set(variant_set_name);
+        if (set == nullptr) return {status_type::UNKNOWN, std::format("No variant set called '{0}' exists.", variant_set_name)};
+        if (set->precompile.valid()) set->precompile.wait();
+
+        for (shader_program* program : set->programs_by_code | std::views::values)
+        {
+            free(program->data);
+            delete program->reflection_table;
+            delete program;
+        }
+
+        std::lock_guard lock(variant_sets_mutex);
+        variant_sets.erase(variant_set_name);
         return status_type::SUCCESS;
     }
 
@@ -395,17 +949,37 @@ namespace stardraw
         return results;
     }
 
+    //Path hashes. Roots hash their name, fields chain their name onto the parent, and every array index shares one hash.
+    static u64 field_path_hash(const u64 parent_hash, const std::string_view& name)
+    {
+        return fnv1a_hash(name, fnv1a_hash(".", parent_hash));
+    }
+
+    static u64 index_path_hash(const u64 parent_hash)
+    {
+        return fnv1a_hash("[]", parent_hash);
+    }
+
+    bool shader_parameter_location::operator==(const shader_parameter_location& other) const
+    {
+        //Each program of a linked set has its own table, so compare paths rather than table entries.
+        return (reflection == nullptr) == (other.reflection == nullptr) && path_hash == other.path_hash && byte_address == other.byte_address && binding_range_index == other.binding_range_index;
+    }
+
     shader_parameter_location shader_parameter_location::index(const u32 index) const
     {
-        slang::TypeLayoutReflection* type_layout = slang_type_reflection(*this);
-        slang::TypeLayoutReflection* element_layout = type_layout->getElementTypeLayout();
-        if (element_layout == nullptr) return invalid_shader_paramter_location;
+        if (table == nullptr || reflection == nullptr) return invalid_shader_paramter_location;
+
+        const u64 element_hash = index_path_hash(path_hash);
+        const auto element = table->entries.find(element_hash);
+        if (element == table->entries.end()) return invalid_shader_paramter_location;
 
         shader_parameter_location result = shader_parameter_location(*this);
-        result.offset_ptr = element_layout;
-        result.byte_address += index * element_layout->getStride();
+        result.reflection = &element->second;
+        result.path_hash = element_hash;
+        result.byte_address += element->second.byte_offset - reflection->byte_offset + index * reflection->element_stride;
 
-        result.binding_range_index *= type_layout->getElementCount();
+        result.binding_range_index *= reflection->element_count;
         result.binding_range_index += index;
 
         return result;
@@ -432,40 +1006,33 @@ namespace stardraw
 
     shader_parameter_location shader_parameter_location::field(const std::string_view& name) const
     {
-        slang::TypeLayoutReflection* type_layout = slang_type_reflection(*this);
-
-        if (is_single_element_container_kind(type_layout->getKind())) type_layout = type_layout->getElementTypeLayout();
+        if (table == nullptr || reflection == nullptr) return invalid_shader_paramter_location;
 
-        const i32 index = type_layout->findFieldIndexByName(name.data(), name.data() + name.size());
-        if (index < 0) return invalid_shader_paramter_location;
-
-        slang::VariableLayoutReflection* field = type_layout->getFieldByIndex(index);
+        const u64 field_hash = field_path_hash(path_hash, name);
+        const auto field = table->entries.find(field_hash);
+        if (field == table->entries.end()) return invalid_shader_paramter_location;
 
         shader_parameter_location result = shader_parameter_location(*this);
-        result.offset_ptr = field->getTypeLayout();
-        result.byte_address += field->getOffset();
-        result.binding_range += type_layout->getFieldBindingRangeOffset(index);
+        result.reflection = &field->second;
+        result.path_hash = field_hash;
+        result.byte_address += field->second.byte_offset - reflection->byte_offset;
 
         return result;
     }
 
     shader_parameter_location shader_program::locate(const std::string_view& name) const
     {
-        shader_parameter_location result;
+        if (reflection_table == nullptr) return invalid_shader_paramter_location;
 
-        slang::VariableLayoutReflection* globals_as_var = slang_shader_reflection(this)->getGlobalParamsVarLayout();
-        slang::TypeLayoutReflection* globals = globals_as_var->getTypeLayout();
-        const i64 field_idx = globals->findFieldIndexByName(name.data(), name.data() + name.size());
-        if (field_idx < 0) return invalid_shader_paramter_location;
+        const u64 root_hash = fnv1a_hash(name);
+        const auto root = reflection_table->entries.find(root_hash);
+        if (root == reflection_table->entries.end()) return invalid_shader_paramter_location;
 
-        slang::VariableLayoutReflection* root_param = globals->getFieldByIndex(field_idx);
-        if (root_param == nullptr) return invalid_shader_paramter_location;
-
-        result.root_ptr = root_param;
-        result.offset_ptr = root_param->getTypeLayout();
-        result.root_idx = field_idx;
-        result.byte_address = 0;
-        result.binding_range = 0;
+        shader_parameter_location result;
+        result.table = reflection_table;
+        result.reflection = &root->second;
+        result.path_hash = root_hash;
+        result.byte_address = root->second.byte_offset;
         result.binding_range_index = 0;
 
         return result;
@@ -512,6 +1079,16 @@ namespace stardraw
                 current_offset = field.offset;
             }
 
+            //Fields that follow each other in both the packed and padded layouts are merged into one run.
+            if (!result->copy_runs.empty() && result->copy_runs.back().write_offset + result->copy_runs.back().size == field.offset)
+            {
+                result->copy_runs.back().size += field.size;
+            }
+            else if (field.size > 0)
+            {
+                result->copy_runs.push_back({packed_size, field.offset, field.size});
+            }
+
             packed_size += field.size;
             current_offset += field.size;
         }
@@ -529,14 +1106,213 @@ namespace stardraw
         return status_type::SUCCESS;
     }
 
-    slang::TypeLayoutReflection* slang_type_reflection(const shader_parameter_location& location)
+    struct struct_header_writer
     {
-        return static_cast<slang::TypeLayoutReflection*>(location.offset_ptr);
+        std::string definitions;
+        //Layout rules of the buffer currently being mirrored. The same struct is laid out differently in std140 and std430 buffers, so each gets its own suffixed definition.
+        std::string layout_rules;
+        std::unordered_set<std::string> emitted_structs;
+    };
+
+    static status cpp_scalar_type(const slang::TypeReflection::ScalarType scalar, std::string& out_type, u64& out_size)
+    {
+        switch (scalar)
+        {
+            case slang::TypeReflection::ScalarType::Bool: //Bools are 32 bits wide in shader buffers
+            case slang::TypeReflection::ScalarType::UInt32: out_type = "std::uint32_t"; out_size = 4; return status_type::SUCCESS;
+            case slang::TypeReflection::ScalarType::Int32: out_type = "std::int32_t"; out_size = 4; return status_type::SUCCESS;
+            case slang::TypeReflection::ScalarType::Float32: out_type = "float"; out_size = 4; return status_type::SUCCESS;
+            case slang::TypeReflection::ScalarType::UInt64: out_type = "std::uint64_t"; out_size = 8; return status_type::SUCCESS;
+            case slang::TypeReflection::ScalarType::Int64: out_type = "std::int64_t"; out_size = 8; return status_type::SUCCESS;
+            case slang::TypeReflection::ScalarType::Float64: out_type = "double"; out_size = 8; return status_type::SUCCESS;
+            case slang::TypeReflection::ScalarType::UInt16: out_type = "std::uint16_t"; out_size = 2; return status_type::SUCCESS;
+            case slang::TypeReflection::ScalarType::Int16: out_type = "std::int16_t"; out_size = 2; return status_type::SUCCESS;
+            case slang::TypeReflection::ScalarType::Float16: out_type = "std::uint16_t"; out_size = 2; return status_type::SUCCESS; //Raw half bits
+            case slang::TypeReflection::ScalarType::UInt8: out_type = "std::uint8_t"; out_size = 1; return status_type::SUCCESS;
+            case slang::TypeReflection::ScalarType::Int8: out_type = "std::int8_t"; out_size = 1; return status_type::SUCCESS;
+            default: return {status_type::UNSUPPORTED, "Scalar type has no C++ equivalent"};
+        }
     }
 
-    slang::VariableLayoutReflection* slang_root_var_reflection(const shader_parameter_location& location)
+    //Elements with a larger stride than their size (eg. std140 float arrays) are wrapped in a padded element.
+    static std::string strided_cpp_type(const std::string& element_type, const u64 element_size, const u64 stride)
     {
-        return static_cast<slang::VariableLayoutReflection*>(location.root_ptr);
+        if (stride <= element_size) return element_type;
+        return std::format("stardraw_generated::padded_element<{0}, {1}>", element_type, stride);
+    }
+
+    static status emit_cpp_struct(slang::TypeLayoutReflection* type, struct_header_writer& writer, std::string& out_type);
+
+    static status cpp_type_for_layout(slang::TypeLayoutReflection* type, struct_header_writer& writer, std::string& out_type)
+    {
+        switch (type->getKind())
+        {
+            case slang::TypeReflection::Kind::Scalar:
+            {
+                u64 scalar_size;
+                return cpp_scalar_type(type->getScalarType(), out_type, scalar_size);
+            }
+            case slang::TypeReflection::Kind::Vector:
+            {
+                std::string scalar_type;
+                u64 scalar_size;
+                const status scalar_status = cpp_scalar_type(type->getScalarType(), scalar_type, scalar_size);
+                if (is_status_error(scalar_status)) return scalar_status;
+
+                out_type = std::format("std::array<{0}, {1}>", scalar_type, type->getElementCount());
+                return status_type::SUCCESS;
+            }
+            case slang::TypeReflection::Kind::Matrix:
+            {
+                std::string scalar_type;
+                u64 scalar_size;
+                const status scalar_status = cpp_scalar_type(type->getScalarType(), scalar_type, scalar_size);
+                if (is_status_error(scalar_status)) return scalar_status;
+
+                const bool row_major = type->getMatrixLayoutMode() == SLANG_MATRIX_LAYOUT_ROW_MAJOR;
+                const u64 vector_count = row_major ? type->getRowCount() : type->getColumnCount();
+                const u64 vector_length = row_major ? type->getColumnCount() : type->getRowCount();
+                const u64 vector_stride = type->getSize() / vector_count;
+
+                const std::string vector_type = std::format("std::array<{0}, {1}>", scalar_type, vector_length);
+                out_type = std::format("std::array<{0}, {1}>", strided_cpp_type(vector_type, scalar_size * vector_length, vector_stride), vector_count);
+                return status_type::SUCCESS;
+            }
+            case slang::TypeReflection::Kind::Array:
+            {
+                if (type->getElementCount() == 0) return {status_type::UNSUPPORTED, "Unsized arrays can't be mirrored as C++ struct fields"};
+                slang::TypeLayoutReflection* element_type = type->getElementTypeLayout();
+
+                std::string element_cpp_type;
+                const status element_status = cpp_type_for_layout(element_type, writer, element_cpp_type);
+                if (is_status_error(element_status)) return element_status;
+
+                const u64 stride = type->getElementStride(SLANG_PARAMETER_CATEGORY_UNIFORM);
+                out_type = std::format("std::array<{0}, {1}>", strided_cpp_type(element_cpp_type, element_type->getSize(), stride), type->getElementCount());
+                return status_type::SUCCESS;
+            }
+            case slang::TypeReflection::Kind::Struct:
+            {
+                return emit_cpp_struct(type, writer, out_type);
+            }
+            default:
+            {
+                const char* type_name = type->getName();
+                return {status_type::UNSUPPORTED, std::format("Type '{0}' has no plain data C++ equivalent", type_name == nullptr ? "unknown" : type_name)};
+            }
+        }
+    }
+
+    static status emit_cpp_struct(slang::TypeLayoutReflection* type, struct_header_writer& writer, std::string& out_type)
+    {
+        out_type = std::format("{0}_{1}", type->getName(), writer.layout_rules);
+        if (writer.emitted_structs.contains(out_type)) return status_type::SUCCESS;
+
+        std::string fields;
+        std::string asserts;
+        u64 current_offset = 0;
+        u32 padding_count = 0;
+
+        for (u32 idx = 0; idx < type->getFieldCount(); idx++)
+        {
+            slang::VariableLayoutReflection* field = type->getFieldByIndex(idx);
+            slang::TypeLayoutReflection* field_type = field->getTypeLayout();
+            const u64 offset = field->getOffset();
+
+            std::string field_cpp_type;
+            const status field_status = cpp_type_for_layout(field_type, writer, field_cpp_type);
+            if (is_status_error(field_status)) return {field_status.type, std::format("Field '{0}' of struct '{1}': {2}", field->getName(), out_type, field_status.message)};
+
+            if (offset > current_offset)
+            {
+                fields += std::format("        std::uint8_t padding_{0}[{1}];\n", padding_count++, offset - current_offset);
+            }
+
+            fields += std::format("        {0} {1};\n", field_cpp_type, field->getName());
+            asserts += std::format("    static_assert(offsetof({0}, {1}) == {2});\n", out_type, field->getName(), offset);
+            current_offset = offset + field_type->getSize();
+        }
+
+        //Structs are sized to their stride so arrays of them match the buffer layout.
+        const u64 stride = type->getStride();
+        if (stride > current_offset)
+        {
+            fields += std::format("        std::uint8_t padding_{0}[{1}];\n", padding_count, stride - current_offset);
+        }
+
+        writer.definitions += std::format("    struct {0}\n    {{\n{1}    }};\n\n{2}    static_assert(sizeof({0}) == {3});\n\n", out_type, fields, asserts, stride);
+        writer.emitted_structs.insert(out_type);
+        return status_type::SUCCESS;
+    }
+
+    status generate_shader_struct_header(const std::string_view& module_name, const std::string_view& namespace_name, std::string& out_header)
+    {
+        shader_session_lock session;
+        const status session_status = shader_compiler::instance().acquire_session(session);
+        if (is_status_error(session_status)) return session_status;
+
+        const std::string module_key = std::string(module_name);
+        if (!session.worker->modules.contains(module_key)) return {status_type::UNKNOWN, std::format("No loaded slang module called '{0}' found.", module_name)};
+        const Slang::ComPtr<slang::IModule> module = session.worker->modules[module_key];
+
+        Slang::ComPtr<slang::IBlob> diagnostics;
+        slang::ShaderReflection* layout = module->getLayout(0, diagnostics.writeRef());
+        if (layout == nullptr)
+        {
+            const std::string msg = diagnostics ? std::string(static_cast<const char*>(diagnostics->getBufferPointer())) : "unknown error";
+            return {status_type::BACKEND_ERROR, std::format("Slang layout for module '{1}' failed with error: '{0}'", msg, module_name)};
+        }
+
+        struct_header_writer writer;
+        std::string parameters;
+
+        for (u32 idx = 0; idx < layout->getParameterCount(); idx++)
+        {
+            slang::VariableLayoutReflection* parameter = layout->getParameterByIndex(idx);
+            slang::TypeLayoutReflection* element_type = parameter->getTypeLayout()->getElementTypeLayout();
+
+            //Only buffers of structs (constant, structured, storage buffers, parameter blocks) are mirrored.
+            if (element_type == nullptr || element_type->getKind() != slang::TypeReflection::Kind::Struct) continue;
+
+            const slang::TypeReflection::Kind buffer_kind = parameter->getTypeLayout()->getKind();
+            const bool is_uniform_buffer = buffer_kind == slang::TypeReflection::Kind::ConstantBuffer || buffer_kind == slang::TypeReflection::Kind::ParameterBlock;
+            writer.layout_rules = is_uniform_buffer ? "std140" : "std430";
+
+            std::string element_cpp_type;
+            const status struct_status = emit_cpp_struct(element_type, writer, element_cpp_type);
+            if (is_status_error(struct_status)) return {struct_status.type, std::format("Buffer '{0}' in module '{1}': {2}", parameter->getName(), module_name, struct_status.message)};
+
+            parameters += std::format("    inline constexpr std::string_view {0}_parameter = \"{0}\";\n", parameter->getName());
+            parameters += std::format("    using {0}_element = {1};\n\n", parameter->getName(), element_cpp_type);
+        }
+
+        out_header = std::format(
+            "//Generated from shader module '{0}' - do not edit.\n"
+            "#pragma once\n"
+            "#include <array>\n"
+            "#include <cstddef>\n"
+            "#include <cstdint>\n"
+            "#include <string_view>\n\n"
+            "#ifndef STARDRAW_GENERATED_PADDED_ELEMENT\n"
+            "#define STARDRAW_GENERATED_PADDED_ELEMENT\n"
+            "namespace stardraw_generated\n"
+            "{{\n"
+            "    template <typename element_type, std::size_t stride>\n"
+            "    struct padded_element\n"
+            "    {{\n"
+            "        element_type value;\n"
+            "        std::uint8_t padding[stride - sizeof(element_type)];\n"
+            "    }};\n"
+            "}}\n"
+            "#endif\n\n"
+            "namespace {1}\n"
+            "{{\n"
+            "{2}"
+            "{3}"
+            "}}\n",
+            module_name, namespace_name, writer.definitions, parameters);
+
+        return status_type::SUCCESS;
     }
 
     slang::ShaderReflection* slang_shader_reflection(const shader_program* program)
@@ -569,11 +1345,30 @@ namespace stardraw
         }
     }
 
-    binding_location_info vk_binding_for_location(const shader_parameter_location& location)
+    struct binding_location_info
+    {
+        i64 set;
+        i64 slot;
+        //The binding type that the location exists inside
+        //May not always be the same as the actual variable the location references -
+        //for instance, for plain data, it will be the containing buffer variable.
+        slang::TypeLayoutReflection* binding_type;
+    };
+
+    //A position in slang's reflection tree. Only walked while building a program's reflection table.
+    struct reflection_cursor
+    {
+        slang::VariableLayoutReflection* root;
+        slang::TypeLayoutReflection* type;
+        u32 byte_address;
+        u32 binding_range;
+    };
+
+    static binding_location_info vk_binding_for_cursor(const reflection_cursor& cursor)
     {
-        slang::VariableLayoutReflection* root_var = slang_root_var_reflection(location);
+        slang::VariableLayoutReflection* root_var = cursor.root;
         slang::TypeLayoutReflection* root_layout = root_var->getTypeLayout();
-        slang::TypeLayoutReflection* selected_layout = slang_type_reflection(location);
+        slang::TypeLayoutReflection* selected_layout = cursor.type;
 
         const bool inside_parameter_block = root_layout->getKind() == slang::TypeReflection::Kind::ParameterBlock;
         const bool is_parameter_block = root_var->getTypeLayout() == selected_layout && inside_parameter_block;
@@ -616,8 +1411,8 @@ namespace stardraw
         const SlangInt set_offset = root_var->getOffset(slang::ParameterCategory::SubElementRegisterSpace);
 
         //Slang binding range -> Slang descriptor set indexes
-        const SlangInt slang_binding_set = root_element_layout->getBindingRangeDescriptorSetIndex(location.binding_range);
-        const SlangInt slang_binding_slot = root_element_layout->getBindingRangeFirstDescriptorRangeIndex(location.binding_range);
+        const SlangInt slang_binding_set = root_element_layout->getBindingRangeDescriptorSetIndex(cursor.binding_range);
+        const SlangInt slang_binding_slot = root_element_layout->getBindingRangeFirstDescriptorRangeIndex(cursor.binding_range);
 
         //Slang descriptor set indexes -> actual VK descriptor set / slot.
         const SlangInt set = root_element_layout->getDescriptorSetSpaceOffset(slang_binding_set) + set_offset;
@@ -625,4 +1420,66 @@ namespace stardraw
 
         return {set, slot, selected_layout};
     }
+
+    //Guards against runaway recursion through self-referencing layouts, such as pointer types.
+    constexpr u32 max_reflection_depth = 32;
+
+    static void reflect_parameter(shader_reflection_table& table, const reflection_cursor& cursor, const u64 path_hash, const u32 depth)
+    {
+        const binding_location_info binding = vk_binding_for_cursor(cursor);
+        slang::TypeLayoutReflection* element_layout = cursor.type->getElementTypeLayout();
+        const slang::TypeReflection::Kind binding_kind = binding.binding_type->getKind();
+        const bool is_resource = binding_kind == slang::TypeReflection::Kind::Resource;
+
+        table.entries[path_hash] = {
+            .set = binding.set,
+            .slot = binding.slot,
+            .byte_offset = cursor.byte_address,
+            .size = static_cast<u32>(cursor.type->getSize()),
+            .element_stride = element_layout == nullptr ? 0 : static_cast<u32>(element_layout->getStride()),
+            .element_count = static_cast<u32>(cursor.type->getElementCount()),
+            .binding_range = cursor.binding_range,
+            .binding_kind = binding_kind,
+            .resource_shape = is_resource ? binding.binding_type->getResourceShape() : SlangResourceShape {},
+            .resource_access = is_resource ? binding.binding_type->getResourceAccess() : SlangResourceAccess {},
+            .is_binding = binding.binding_type == cursor.type,
+        };
+
+        if (depth >= max_reflection_depth) return;
+
+        if (element_layout != nullptr)
+        {
+            reflection_cursor element = cursor;
+            element.type = element_layout;
+            reflect_parameter(table, element, index_path_hash(path_hash), depth + 1);
+        }
+
+        slang::TypeLayoutReflection* struct_layout = is_single_element_container_kind(cursor.type->getKind()) ? element_layout : cursor.type;
+        if (struct_layout == nullptr || struct_layout->getKind() != slang::TypeReflection::Kind::Struct) return;
+
+        for (u32 idx = 0; idx < struct_layout->getFieldCount(); idx++)
+        {
+            slang::VariableLayoutReflection* field = struct_layout->getFieldByIndex(idx);
+            reflection_cursor child = cursor;
+            child.type = field->getTypeLayout();
+            child.byte_address += field->getOffset();
+            child.binding_range += struct_layout->getFieldBindingRangeOffset(idx);
+            reflect_parameter(table, child, field_path_hash(path_hash, field->getName()), depth + 1);
+        }
+    }
+
+    static shader_reflection_table* build_shader_reflection_table(slang::ShaderReflection* layout)
+    {
+        shader_reflection_table* table = new shader_reflection_table();
+        slang::TypeLayoutReflection* globals = layout->getGlobalParamsVarLayout()->getTypeLayout();
+
+        for (u32 idx = 0; idx < globals->getFieldCount(); idx++)
+        {
+            slang::VariableLayoutReflection* root_param = globals->getFieldByIndex(idx);
+            if (root_param == nullptr) continue;
+            reflect_parameter(*table, {root_param, root_param->getTypeLayout(), 0, 0}, fnv1a_hash(root_param->getName()), 0);
+        }
+
+        return table;
+    }
 }